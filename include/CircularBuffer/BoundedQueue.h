@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include "CircularBuffer/SequenceSignal.h"
+
+// What push does when the queue is full
+enum class OverflowPolicy
+{
+    DropOldest,       // evict the oldest item to make room
+    CoalesceLatest,   // keep only the newest item; everything queued is replaced
+    BlockWithTimeout, // wait for room up to timeout, then drop the new item
+};
+
+struct BoundedQueueOptions
+{
+    size_t capacity = 1024; // rounded up to a power of two
+    OverflowPolicy policy = OverflowPolicy::DropOldest;
+    std::chrono::microseconds timeout{1000}; // BlockWithTimeout only
+};
+
+struct BoundedQueueStats
+{
+    size_t capacity = 0;
+    size_t size = 0;
+    size_t highWater = 0;    // most items queued at once
+    uint64_t pushed = 0;
+    uint64_t dropped = 0;    // evicted by DropOldest, or refused after the BlockWithTimeout wait
+    uint64_t coalesced = 0;  // replaced by a newer item under CoalesceLatest
+    uint64_t wakeCalls = 0;  // pushes that had to wake a parked consumer
+};
+
+// Fixed-capacity multi-producer / multi-consumer queue (per-cell sequence
+// numbers, after Vyukov): push and pop never take a lock, so the
+// acquisition thread is not held up by a consumer. Memory is allocated once
+// in reset(). A consumer that finds the queue empty can wait in popWait,
+// which spins and then parks on the count of pushes (SequenceSignal);
+// producers only make a system call when a consumer is parked.
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(const BoundedQueueOptions &options = BoundedQueueOptions()) { reset(options); }
+
+    // Reallocates and clears the statistics; only while nobody pushes or pops
+    void reset(const BoundedQueueOptions &options)
+    {
+        if (options.capacity == 0)
+            throw std::invalid_argument("BoundedQueue capacity must be at least 1");
+        size_t capacity = 1;
+        while (capacity < options.capacity)
+            capacity <<= 1;
+        options_ = options;
+        mask_ = capacity - 1;
+        cells_ = std::make_unique<Cell[]>(capacity);
+        for (size_t i = 0; i < capacity; ++i)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        enqueuePos_.store(0, std::memory_order_relaxed);
+        dequeuePos_.store(0, std::memory_order_relaxed);
+        highWater_.store(0, std::memory_order_relaxed);
+        pushed_.store(0, std::memory_order_relaxed);
+        dropped_.store(0, std::memory_order_relaxed);
+        coalesced_.store(0, std::memory_order_relaxed);
+        signal_.reset();
+    }
+
+    // Queues item under the overflow policy. Returns the number of items
+    // lost to make room: evicted or coalesced items, or the new item itself
+    // when BlockWithTimeout gave up.
+    size_t push(T item)
+    {
+        uint64_t pushed = pushed_.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t lost = 0;
+        switch (options_.policy)
+        {
+        case OverflowPolicy::CoalesceLatest:
+        {
+            T old;
+            while (tryPop(old))
+                ++lost;
+            while (!tryPush(item))
+            {
+                if (tryPop(old))
+                    ++lost;
+            }
+            coalesced_.fetch_add(lost, std::memory_order_relaxed);
+            break;
+        }
+        case OverflowPolicy::DropOldest:
+        {
+            T old;
+            while (!tryPush(item))
+            {
+                if (tryPop(old))
+                    ++lost;
+            }
+            dropped_.fetch_add(lost, std::memory_order_relaxed);
+            break;
+        }
+        case OverflowPolicy::BlockWithTimeout:
+            if (!tryPush(item))
+            {
+                auto deadline = std::chrono::steady_clock::now() + options_.timeout;
+                bool queued = false;
+                while (!queued && std::chrono::steady_clock::now() < deadline)
+                {
+                    std::this_thread::yield();
+                    queued = tryPush(item);
+                }
+                if (!queued)
+                {
+                    lost = 1;
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            break;
+        }
+        signal_.publish(pushed);
+        return lost;
+    }
+
+    bool tryPop(T &item)
+    {
+        size_t position = dequeuePos_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell &cell = cells_[position & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (difference == 0)
+            {
+                if (dequeuePos_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    item = std::move(cell.value);
+                    cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+                return false;
+            else
+                position = dequeuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Pops, waiting up to timeout for an item; false if none came or wakeAll was called
+    bool popWait(T &item, std::chrono::microseconds timeout)
+    {
+        if (tryPop(item))
+            return true;
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (true)
+        {
+            // Read the push count before looking, so a push in between ends the wait
+            uint64_t seen = signal_.load();
+            if (tryPop(item))
+                return true;
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+                return false;
+            if (signal_.waitPast(seen, std::chrono::duration_cast<std::chrono::microseconds>(deadline - now)) <= seen)
+                return tryPop(item);
+        }
+    }
+
+    // Wakes every parked consumer, e.g. to let it see a stop flag
+    void wakeAll() { signal_.wakeAll(); }
+
+    size_t size() const
+    {
+        size_t enqueued = enqueuePos_.load(std::memory_order_acquire);
+        size_t dequeued = dequeuePos_.load(std::memory_order_acquire);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return mask_ + 1; }
+    const BoundedQueueOptions &options() const { return options_; }
+
+    BoundedQueueStats stats() const
+    {
+        BoundedQueueStats stats;
+        stats.capacity = capacity();
+        stats.size = size();
+        stats.highWater = highWater_.load(std::memory_order_relaxed);
+        stats.pushed = pushed_.load(std::memory_order_relaxed);
+        stats.dropped = dropped_.load(std::memory_order_relaxed);
+        stats.coalesced = coalesced_.load(std::memory_order_relaxed);
+        stats.wakeCalls = signal_.stats().wakeCalls;
+        return stats;
+    }
+
+private:
+    struct alignas(64) Cell
+    {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    bool tryPush(const T &item)
+    {
+        size_t position = enqueuePos_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell &cell = cells_[position & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0)
+            {
+                if (enqueuePos_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.value = item;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    size_t dequeued = dequeuePos_.load(std::memory_order_relaxed);
+                    noteSize(position + 1 > dequeued ? position + 1 - dequeued : 0);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+                return false;
+            else
+                position = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    void noteSize(size_t size)
+    {
+        size = std::min(size, capacity());
+        size_t highWater = highWater_.load(std::memory_order_relaxed);
+        while (size > highWater && !highWater_.compare_exchange_weak(highWater, size, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    BoundedQueueOptions options_;
+    size_t mask_ = 0;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) std::atomic<size_t> dequeuePos_{0};
+    alignas(64) std::atomic<size_t> highWater_{0};
+    std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> coalesced_{0};
+    SequenceSignal signal_;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "CircularBuffer/FrameRing.h"
+
+// Frame history stored as lossless deltas against a background frame.
+// Frames are mostly static channel background with a small cell, so the delta
+// is zero or sensor noise almost everywhere. Each 16-byte block of the delta is
+// stored as nothing (all zero), 2 or 4 bits per pixel (small noise) or raw
+// bytes (the cell), which keeps encoding a fixed-width, branch-light loop.
+// Encoded frames share one byte arena used as a ring: the oldest frames are
+// evicted when it fills, so history length depends on how busy the frames are.
+// Frames are decoded on demand for review.
+class CompressedHistory
+{
+public:
+    CompressedHistory(size_t byteBudget, size_t imageSize);
+
+    // Frames pushed afterwards are encoded against this background. Frames
+    // already held keep a reference to the background they were encoded with.
+    void setBackground(const uint8_t *background);
+    bool hasBackground() const;
+
+    // Returns the encoded size, or 0 when no background has been set yet
+    size_t push(const uint8_t *frame, const FrameMeta &meta);
+    void clear();
+
+    // index 0 is the newest frame, same as FrameRing
+    bool decode(size_t index, uint8_t *destination, FrameMeta *meta = nullptr) const;
+
+    size_t size() const;
+    size_t imageSize() const { return imageSize_; }
+    size_t byteBudget() const { return arena_.size(); }
+    size_t bytesUsed() const;
+    double compressionRatio() const; // raw bytes / encoded bytes over the frames held
+
+    static size_t maxEncodedSize(size_t imageSize);
+    static size_t encode(const uint8_t *frame, const uint8_t *background, size_t imageSize, uint8_t *output);
+    static void decode(const uint8_t *encoded, const uint8_t *background, size_t imageSize, uint8_t *output);
+
+private:
+    struct Entry
+    {
+        size_t offset;
+        size_t length;
+        FrameMeta meta;
+        std::shared_ptr<const std::vector<uint8_t>> background;
+    };
+
+    void evictOverlapping(size_t start, size_t end);
+
+    size_t imageSize_;
+    std::vector<uint8_t> arena_;
+    std::vector<uint8_t> scratch_;
+    std::deque<Entry> entries_;
+    std::shared_ptr<const std::vector<uint8_t>> background_;
+    size_t writeOffset_ = 0;
+    size_t bytesUsed_ = 0;
+    mutable std::mutex mutex_;
+};
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include "CircularBuffer/FrameStorage.h"
+
+// Single-writer / multi-reader frame ring.
+// Every slot carries a sequence stamp (seqlock): the stamp is odd while the
+// writer is copying into the slot and 2 * sequence once the frame is complete.
+// Readers validate the stamp before and after copying, so a frame that was
+// overwritten mid-read is detected instead of silently analysed.
+// Readers that do not want to copy can lease a slot instead: a lease pins the
+// slot and the writer drops incoming frames rather than overwrite it.
+// Each frame is pushed once; several named consumers (processing, display,
+// recorder, ...) read it through their own cursor. Lossy consumers skip ahead
+// when lapped, pinned consumers hold back slot reclamation instead.
+// The slots can also be filled in place by a frame grabber (announced as user
+// memory): the ring then publishes slots in the order the grabber fills them
+// and hands a slot back for acquisition only once no consumer can read it.
+class FrameRing;
+
+// Fixed-size side-band record stored next to every slot, written by the
+// acquisition thread under the same sequence stamp as the pixels.
+struct FrameMeta
+{
+    uint64_t sequence = 0;        // ring sequence, assigned by push
+    uint64_t frameId = 0;         // BUFFER_INFO_FRAMEID, or source index for replayed frames
+    uint64_t cameraTimestamp = 0; // BUFFER_INFO_TIMESTAMP (device clock, us)
+    size_t sizeFilled = 0;        // BUFFER_INFO_SIZE_FILLED
+    int64_t hostSteadyUs = 0;     // steady_clock when the frame reached the ring, for latency
+    int64_t hostWallUs = 0;       // system_clock at the same instant, for saved results
+};
+
+inline int64_t steadyNowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+enum class ConsumerMode
+{
+    Lossy,  // skips frames when the writer laps it
+    Pinned, // the writer drops new frames rather than evict unread ones
+};
+
+struct ConsumerStats
+{
+    std::string name;
+    ConsumerMode mode;
+    uint64_t cursor;  // sequence of the last frame handed to this consumer
+    uint64_t lag;     // frames published but not yet consumed
+    uint64_t skipped; // frames this consumer never saw
+};
+
+class FrameLease
+{
+public:
+    FrameLease() = default;
+    ~FrameLease() { release(); }
+    FrameLease(FrameLease &&other) noexcept;
+    FrameLease &operator=(FrameLease &&other) noexcept;
+    FrameLease(const FrameLease &) = delete;
+    FrameLease &operator=(const FrameLease &) = delete;
+
+    explicit operator bool() const { return data_ != nullptr; }
+    const uint8_t *data() const { return data_; }
+    uint64_t sequence() const { return sequence_; }
+    const FrameMeta &meta() const { return *meta_; }
+    void release();
+
+private:
+    friend class FrameRing;
+    FrameLease(const FrameRing *ring, size_t slot, const uint8_t *data, const FrameMeta *meta, uint64_t sequence)
+        : ring_(ring), slot_(slot), data_(data), meta_(meta), sequence_(sequence) {}
+
+    const FrameRing *ring_ = nullptr;
+    size_t slot_ = 0;
+    const uint8_t *data_ = nullptr;
+    const FrameMeta *meta_ = nullptr;
+    uint64_t sequence_ = 0;
+};
+
+class FrameRing
+{
+public:
+    FrameRing(size_t size, size_t imageSize, const FrameStorageOptions &storageOptions = FrameStorageOptions());
+
+    // Writer side (acquisition thread only). Returns false when the target
+    // slot is leased and the frame had to be dropped. Host timestamps left at
+    // zero in meta are filled in here.
+    bool push(const uint8_t *data, const FrameMeta &meta = FrameMeta());
+    // Same as push, but fill(uint8_t *slot) writes the imageSize() bytes
+    // itself, so a conversion can land in the slot without a second copy
+    template <typename Fill>
+    bool pushWith(const FrameMeta &meta, Fill &&fill)
+    {
+        uint64_t sequence = 0;
+        uint8_t *slot = beginPush(sequence);
+        if (!slot)
+            return false;
+        fill(slot);
+        endPush(sequence, meta);
+        return true;
+    }
+    void clear();
+
+    // Reader side. index 0 is the newest frame, same as CircularBuffer.
+    const uint8_t *getPointer(size_t index) const; // unchecked, may be torn
+    bool read(size_t index, uint8_t *destination, FrameMeta *meta = nullptr) const;
+    bool readSequence(uint64_t sequence, uint8_t *destination, FrameMeta *meta = nullptr) const;
+    FrameLease lease(size_t index) const; // empty lease if the frame is gone
+    FrameLease leaseSequence(uint64_t sequence) const;
+
+    // Acquisition straight into slot memory. Slots 0 to queueDepth - 1 start
+    // out queued to the grabber; commit() publishes a slot it has filled
+    // (acquisition thread only, instead of push) and requeue is called to keep
+    // queueDepth slots queued: first with the slots never queued yet, then
+    // with the oldest frames once no lease or pinned consumer holds them.
+    void attachAcquisition(size_t queueDepth, std::function<void(size_t slot)> requeue);
+    uint8_t *slotData(size_t slot) { return storage_.slot(slot); }
+    bool commit(size_t slot, const FrameMeta &meta = FrameMeta());
+    size_t queuedSlots() const { return queuedSlots_.load(std::memory_order_relaxed); }
+    // Times the oldest frame could not be requeued because it was still held
+    uint64_t requeueStalls() const { return requeueStalls_.load(std::memory_order_relaxed); }
+
+    // Named consumers. Register before the writer starts pushing.
+    size_t registerConsumer(const std::string &name, ConsumerMode mode = ConsumerMode::Lossy);
+    FrameLease next(size_t consumer);   // oldest frame this consumer has not seen
+    FrameLease latest(size_t consumer); // newest frame, counting the ones jumped over as skipped
+    // A given frame, for consumers told which one to read; moves the cursor
+    // to it and counts any frames jumped over as skipped
+    FrameLease take(size_t consumer, uint64_t sequence);
+    ConsumerStats consumerStats(size_t consumer) const;
+    size_t consumerCount() const { return consumerCount_.load(std::memory_order_acquire); }
+
+    uint64_t latestSequence() const; // 0 when nothing has been pushed
+    size_t size() const;
+    size_t capacity() const { return size_; }
+    size_t imageSize() const { return imageSize_; }
+    bool isFull() const;
+    uint64_t tornReads() const { return tornReads_.load(std::memory_order_relaxed); }
+    uint64_t pinnedDrops() const { return pinnedDrops_.load(std::memory_order_relaxed); }
+    uint64_t consumerDrops() const { return consumerDrops_.load(std::memory_order_relaxed); }
+    const FrameStorage &storage() const { return storage_; }
+    // Time from acquisition start (construction unless marked) until the
+    // first frame was accepted, -1 before that
+    double startupToFirstFrameMs() const { return firstFrameMs_.load(std::memory_order_acquire); }
+    // Restarts the startup clock, e.g. once interactive prompts are done;
+    // call before the acquisition thread starts pushing
+    void markAcquisitionStart() { startedAt_ = std::chrono::steady_clock::now(); }
+
+    static constexpr size_t MAX_CONSUMERS = 8;
+
+private:
+    friend class FrameLease;
+
+    struct alignas(64) SlotState
+    {
+        std::atomic<uint64_t> stamp{0};
+        mutable std::atomic<uint32_t> pins{0};
+    };
+
+    struct alignas(64) ConsumerState
+    {
+        std::string name;
+        ConsumerMode mode = ConsumerMode::Lossy;
+        std::atomic<uint64_t> cursor{0};
+        std::atomic<uint64_t> skipped{0};
+    };
+
+    // Slots are reused in sequence order, except when filled by a grabber
+    size_t slotOf(uint64_t sequence) const
+    {
+        if (acquisition_)
+            return acquisition_->sequenceSlots[(sequence - 1) % size_].load(std::memory_order_acquire);
+        return (sequence - 1) % size_;
+    }
+    // push in two halves around the pixel write; beginPush returns null
+    // when the frame has to be dropped
+    uint8_t *beginPush(uint64_t &sequence);
+    void endPush(uint64_t sequence, const FrameMeta &meta);
+    bool evictionBlocked(uint64_t evictedSequence) const;
+    void releasePin(size_t slot) const;
+    void reclaim(bool wait) const;
+
+    struct AcquisitionState
+    {
+        explicit AcquisitionState(size_t size) : sequenceSlots(size) {}
+        std::vector<std::atomic<size_t>> sequenceSlots; // (sequence - 1) % size -> slot
+        std::function<void(size_t)> requeue;
+        size_t queueDepth = 0;
+        size_t nextUnqueuedSlot = 0; // slots from here on have not been queued yet
+        std::mutex reclaimMutex;
+    };
+
+    FrameStorage storage_;
+    mutable std::vector<SlotState> slots_; // reclaim() may restamp slots from a releasing reader
+    std::vector<FrameMeta> metas_;
+    size_t size_;
+    size_t imageSize_;
+    std::atomic<uint64_t> head_{0};       // sequence of the newest complete frame
+    std::atomic<uint64_t> clearedAt_{0};  // frames at or below this sequence are hidden
+    mutable std::atomic<uint64_t> tornReads_{0};
+    std::atomic<uint64_t> pinnedDrops_{0};
+    std::array<ConsumerState, MAX_CONSUMERS> consumers_;
+    std::atomic<size_t> consumerCount_{0};
+    std::atomic<uint64_t> consumerDrops_{0};
+    std::chrono::steady_clock::time_point startedAt_;
+    std::atomic<double> firstFrameMs_{-1.0};
+    std::unique_ptr<AcquisitionState> acquisition_;
+    mutable std::atomic<uint64_t> reclaimedUpTo_{0}; // frames at or below this were handed back to the grabber
+    mutable std::atomic<size_t> queuedSlots_{0};
+    mutable std::atomic<uint64_t> requeueStalls_{0};
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Backing memory for frame rings.
+// Slots are laid out on an aligned stride and the block is mapped straight from
+// the OS (mmap / VirtualAlloc), so nothing is zero-filled up front. Pages are
+// faulted in by a background thread instead of by the first pass of the
+// acquisition loop, and can optionally use huge pages and be locked in RAM.
+// Alternatively the slots can live in a memory-mapped, preallocated file, so a
+// ring far larger than RAM can hold minutes of history for pause-and-review;
+// residency is then bounded by the page cache and dirty pages are written back
+// by a helper thread, never by the acquisition thread. Anonymous storage can
+// be bound to a NUMA node, so the slots sit next to the acquisition core.
+enum class HugePageMode
+{
+    Off,
+    Transparent, // madvise(MADV_HUGEPAGE); no-op on Windows
+    Explicit,    // MAP_HUGETLB / MEM_LARGE_PAGES, falls back to normal pages
+};
+
+struct FrameStorageOptions
+{
+    size_t alignment = 64; // slot stride alignment, at least a cache line
+    HugePageMode hugePages = HugePageMode::Off;
+    bool lockMemory = false;          // mlock / VirtualLock once prefaulted
+    bool prefaultInBackground = true; // touch every page on a helper thread
+    std::string backingFile;          // map this file instead of anonymous memory when set
+    unsigned writebackIntervalMs = 200; // how often file-backed storage starts writeback
+    int numaNode = -1;                  // allocate anonymous storage on this node; -1 = wherever it is first touched
+};
+
+class FrameStorage
+{
+public:
+    FrameStorage(size_t slotCount, size_t slotSize, const FrameStorageOptions &options = FrameStorageOptions());
+    ~FrameStorage();
+    FrameStorage(const FrameStorage &) = delete;
+    FrameStorage &operator=(const FrameStorage &) = delete;
+
+    uint8_t *slot(size_t index) const { return base_ + index * stride_; }
+    size_t stride() const { return stride_; }
+    size_t bytes() const { return bytes_; }
+
+    bool fileBacked() const { return !options_.backingFile.empty(); }
+    bool usingHugePages() const { return hugePages_; }
+    bool locked() const { return locked_.load(std::memory_order_acquire); }
+    bool prefaulted() const { return prefaulted_.load(std::memory_order_acquire); }
+    // False when pages are left to fault in as frames are first written
+    bool prefaultEnabled() const { return !fileBacked() && (options_.prefaultInBackground || options_.lockMemory); }
+    double allocationMs() const { return allocationMs_; }
+    double prefaultMs() const { return prefaultMs_.load(std::memory_order_acquire); }
+    // Node the first page is on once prefaulted, or the first written slot's
+    // page when nothing is prefaulted; -1 when unknown
+    int residentNode() const { return residentNode_.load(std::memory_order_acquire); }
+    // Called with the first slot written; checks its node when no prefault ran
+    void noteFirstWrite(const uint8_t *slot);
+    void waitForPrefault();
+
+private:
+    void allocate();
+    void mapFile();
+    void release();
+    void prefault();
+    void writeback();
+    void bindToNode();
+    void checkNode(const uint8_t *page);
+
+    FrameStorageOptions options_;
+    size_t stride_;
+    size_t bytes_;
+    size_t mappedBytes_ = 0;
+    uint8_t *base_ = nullptr;
+    bool hugePages_ = false;
+    double allocationMs_ = 0.0;
+    std::atomic<bool> locked_{false};
+    std::atomic<bool> prefaulted_{false};
+    std::atomic<bool> stopPrefault_{false};
+    std::atomic<double> prefaultMs_{0.0};
+    std::atomic<int> residentNode_{-1};
+    std::thread prefaultThread_;
+#ifdef _WIN32
+    void *fileHandle_ = nullptr;
+    void *mappingHandle_ = nullptr;
+#else
+    int fileDescriptor_ = -1;
+#endif
+    bool stopWriteback_ = false;
+    std::mutex writebackMutex_;
+    std::condition_variable writebackCondition_;
+    std::thread writebackThread_;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+// Puts results from several workers back in order. Work is numbered with
+// dense tickets (0, 1, 2, ...) as it is handed out; workers complete tickets
+// in any order and emit is called for each one in ticket order, by whichever
+// worker completes the ticket the buffer was waiting for. Skipped tickets
+// are passed over without an emit.
+// At most window tickets are held: a worker that completes a ticket further
+// ahead waits until the tickets before it are emitted, so one slow frame
+// stalls the others instead of growing the buffer.
+template <typename T>
+class ReorderBuffer
+{
+public:
+    ReorderBuffer(size_t window, std::function<void(T &)> emit)
+        : emit_(std::move(emit)), items_(window), done_(window, false)
+    {
+        if (window == 0)
+            throw std::invalid_argument("ReorderBuffer window must be at least 1");
+    }
+
+    void complete(uint64_t ticket, T item) { finish(ticket, std::optional<T>(std::move(item))); }
+    void skip(uint64_t ticket) { finish(ticket, std::nullopt); }
+
+    // Next ticket to be emitted or skipped
+    uint64_t next() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return next_;
+    }
+    // Most tickets held back at once, and completions that had to wait for room
+    size_t maxHeld() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return maxHeld_;
+    }
+    uint64_t stalls() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stalls_;
+    }
+
+private:
+    void finish(uint64_t ticket, std::optional<T> item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (ticket < next_)
+            throw std::logic_error("ReorderBuffer ticket completed twice");
+        if (ticket >= next_ + items_.size())
+        {
+            ++stalls_;
+            room_.wait(lock, [&]()
+                       { return ticket < next_ + items_.size(); });
+        }
+
+        size_t slot = ticket % items_.size();
+        items_[slot] = std::move(item);
+        done_[slot] = true;
+        if (ticket != next_)
+        {
+            ++held_;
+            maxHeld_ = std::max(maxHeld_, held_);
+            return;
+        }
+
+        // Emit the run of completed tickets starting here
+        while (done_[next_ % items_.size()])
+        {
+            size_t head = next_ % items_.size();
+            if (items_[head])
+                emit_(*items_[head]);
+            items_[head].reset();
+            done_[head] = false;
+            if (next_ != ticket)
+                --held_;
+            ++next_;
+        }
+        room_.notify_all();
+    }
+
+    std::function<void(T &)> emit_;
+    mutable std::mutex mutex_;
+    std::condition_variable room_;
+    std::vector<std::optional<T>> items_;
+    std::vector<bool> done_;
+    uint64_t next_ = 0;
+    size_t held_ = 0;
+    size_t maxHeld_ = 0;
+    uint64_t stalls_ = 0;
+};
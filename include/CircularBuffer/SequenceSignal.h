@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+// A published sequence number that consumers wait on: the producer stores
+// each new sequence and consumers catch up on everything up to it, so a
+// consumer that was busy sees a whole batch at one wake-up. Waiting spins
+// briefly, then parks on the address (futex on Linux, WaitOnAddress on
+// Windows). The producer only makes a wake-up call while a consumer is
+// parked, so a busy pipeline publishes without any system call.
+class SequenceSignal
+{
+public:
+    struct Stats
+    {
+        uint64_t published = 0;
+        uint64_t wakeCalls = 0;   // system calls made by publish and wakeAll
+        uint64_t spinWaits = 0;   // waits satisfied while spinning
+        uint64_t parkedWaits = 0; // waits that parked at least once
+    };
+
+    // Spinning only pays when the producer runs on another core, so a
+    // single-core machine parks straight away
+    explicit SequenceSignal(uint32_t spinIterations = 2000)
+        : spinIterations_(std::thread::hardware_concurrency() > 1 ? spinIterations : 0) {}
+
+    // Raises the sequence to at least sequence; any thread may publish
+    void publish(uint64_t sequence);
+    uint64_t load() const { return sequence_.load(std::memory_order_acquire); }
+
+    // Returns the sequence once it is past seen, or whatever it is at the
+    // timeout or a wakeAll (possibly still seen)
+    uint64_t waitPast(uint64_t seen, std::chrono::microseconds timeout);
+    // Releases every parked waiter, e.g. to let it see a stop flag
+    void wakeAll();
+
+    Stats stats() const;
+    // Back to sequence 0 with cleared statistics; only while nobody waits
+    void reset();
+
+private:
+    void wake();
+
+    uint32_t spinIterations_;
+    alignas(64) std::atomic<uint64_t> sequence_{0};
+    // The word parked on: bumped by every publish and wakeAll
+    alignas(64) std::atomic<uint32_t> word_{0};
+    std::atomic<uint32_t> parked_{0};
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> wakeCalls_{0};
+    std::atomic<uint64_t> spinWaits_{0};
+    std::atomic<uint64_t> parkedWaits_{0};
+};
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Rolling statistics over the last N samples of a ring, maintained on push so
+// reading them never rescans the window:
+// - mean from a running sum
+// - min/max from monotonic deques (amortised O(1))
+// - count above a threshold
+// - approximate percentiles from a log-spaced histogram (fixed bin count)
+struct RollingStatsSnapshot
+{
+    size_t count = 0;
+    double latest = 0.0;
+    double mean = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    size_t aboveThreshold = 0;
+    double aboveThresholdPercent = 0.0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+    double p999 = 0.0;
+};
+
+class RollingStats
+{
+public:
+    static constexpr size_t HISTOGRAM_BINS = 128;
+
+    // Percentiles are resolved to ~10% between histogramMin and histogramMax
+    explicit RollingStats(double threshold = std::numeric_limits<double>::max(),
+                          double histogramMin = 1.0, double histogramMax = 1e6)
+        : threshold_(threshold), logMin_(std::log(histogramMin)),
+          binsPerLog_(HISTOGRAM_BINS / (std::log(histogramMax) - std::log(histogramMin)))
+    {
+        if (histogramMin <= 0.0 || histogramMax <= histogramMin)
+            throw std::invalid_argument("RollingStats histogram range must be positive and increasing");
+        clear();
+    }
+
+    void add(uint64_t sequence, double value)
+    {
+        sum_ += value;
+        if (value > threshold_)
+            ++aboveThreshold_;
+        ++histogram_[binOf(value)];
+        while (!minQueue_.empty() && minQueue_.back().second >= value)
+            minQueue_.pop_back();
+        minQueue_.emplace_back(sequence, value);
+        while (!maxQueue_.empty() && maxQueue_.back().second <= value)
+            maxQueue_.pop_back();
+        maxQueue_.emplace_back(sequence, value);
+        latest_ = value;
+        ++count_;
+    }
+
+    void remove(uint64_t sequence, double value)
+    {
+        sum_ -= value;
+        if (value > threshold_)
+            --aboveThreshold_;
+        --histogram_[binOf(value)];
+        if (!minQueue_.empty() && minQueue_.front().first == sequence)
+            minQueue_.pop_front();
+        if (!maxQueue_.empty() && maxQueue_.front().first == sequence)
+            maxQueue_.pop_front();
+        --count_;
+    }
+
+    void clear()
+    {
+        sum_ = 0.0;
+        latest_ = 0.0;
+        count_ = 0;
+        aboveThreshold_ = 0;
+        histogram_.fill(0);
+        minQueue_.clear();
+        maxQueue_.clear();
+    }
+
+    RollingStatsSnapshot snapshot() const
+    {
+        RollingStatsSnapshot result;
+        result.count = count_;
+        if (count_ == 0)
+            return result;
+        result.latest = latest_;
+        result.mean = sum_ / count_;
+        result.min = minQueue_.front().second;
+        result.max = maxQueue_.front().second;
+        result.aboveThreshold = aboveThreshold_;
+        result.aboveThresholdPercent = (aboveThreshold_ * 100.0) / count_;
+        result.p50 = percentile(0.50);
+        result.p99 = percentile(0.99);
+        result.p999 = percentile(0.999);
+        return result;
+    }
+
+private:
+    size_t binOf(double value) const
+    {
+        if (!(value > 0.0))
+            return 0;
+        double bin = (std::log(value) - logMin_) * binsPerLog_;
+        if (bin < 0.0)
+            return 0;
+        return std::min(static_cast<size_t>(bin), HISTOGRAM_BINS - 1);
+    }
+
+    double binUpperEdge(size_t bin) const { return std::exp(logMin_ + (bin + 1) / binsPerLog_); }
+
+    double percentile(double fraction) const
+    {
+        size_t rank = static_cast<size_t>(std::ceil(fraction * count_));
+        size_t seen = 0;
+        for (size_t bin = 0; bin < HISTOGRAM_BINS; ++bin)
+        {
+            seen += histogram_[bin];
+            if (seen >= rank)
+                return std::min(binUpperEdge(bin), maxQueue_.front().second);
+        }
+        return maxQueue_.front().second;
+    }
+
+    double threshold_;
+    double logMin_;
+    double binsPerLog_;
+    double sum_;
+    double latest_;
+    size_t count_;
+    size_t aboveThreshold_;
+    std::array<uint32_t, HISTOGRAM_BINS> histogram_;
+    std::deque<std::pair<uint64_t, double>> minQueue_;
+    std::deque<std::pair<uint64_t, double>> maxQueue_;
+};
+
+// Fixed-capacity ring of typed records stored column by column (struct of
+// arrays), replacing byte-oriented CircularBuffers that held doubles through
+// reinterpret_cast. The first column feeds a RollingStats instance.
+// All members are internally locked; critical sections are O(1) except for
+// columns(), which copies the window out for plotting.
+template <typename... Columns>
+class TypedRing
+{
+public:
+    using Record = std::tuple<Columns...>;
+
+    explicit TypedRing(size_t capacity, const RollingStats &stats = RollingStats())
+        : capacity_(capacity), stats_(stats)
+    {
+        if (capacity == 0)
+            throw std::invalid_argument("TypedRing requires a non-zero capacity");
+        resizeColumns(std::index_sequence_for<Columns...>{});
+    }
+
+    void push(const Columns &...values)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t slot = pushed_ % capacity_;
+        if (size_ == capacity_)
+        {
+            uint64_t evicted = pushed_ - capacity_;
+            stats_.remove(evicted, static_cast<double>(std::get<0>(columns_)[slot]));
+        }
+        else
+        {
+            ++size_;
+        }
+        assign(slot, std::forward_as_tuple(values...), std::index_sequence_for<Columns...>{});
+        stats_.add(pushed_, static_cast<double>(std::get<0>(columns_)[slot]));
+        ++pushed_;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_ = 0;
+        stats_.clear();
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    // Monotonic count of pushes, also usable as a change counter
+    uint64_t totalPushed() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pushed_;
+    }
+
+    RollingStatsSnapshot stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_.snapshot();
+    }
+
+    // index 0 is the newest record
+    Record get(size_t index) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index >= size_)
+            throw std::out_of_range("Index out of range");
+        return record((pushed_ - 1 - index) % capacity_, std::index_sequence_for<Columns...>{});
+    }
+
+    // Copies every column, oldest record first
+    std::tuple<std::vector<Columns>...> columns() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::tuple<std::vector<Columns>...> result;
+        copyColumns(result, std::index_sequence_for<Columns...>{});
+        return result;
+    }
+
+private:
+    template <size_t... I>
+    void resizeColumns(std::index_sequence<I...>)
+    {
+        (std::get<I>(columns_).resize(capacity_), ...);
+    }
+
+    template <typename Values, size_t... I>
+    void assign(size_t slot, const Values &values, std::index_sequence<I...>)
+    {
+        ((std::get<I>(columns_)[slot] = std::get<I>(values)), ...);
+    }
+
+    template <size_t... I>
+    Record record(size_t slot, std::index_sequence<I...>) const
+    {
+        return Record(std::get<I>(columns_)[slot]...);
+    }
+
+    template <size_t... I>
+    void copyColumns(std::tuple<std::vector<Columns>...> &result, std::index_sequence<I...>) const
+    {
+        size_t first = (pushed_ - size_) % capacity_;
+        (copyColumn(std::get<I>(columns_), std::get<I>(result), first), ...);
+    }
+
+    template <typename T>
+    void copyColumn(const std::vector<T> &column, std::vector<T> &out, size_t first) const
+    {
+        out.reserve(size_);
+        size_t firstChunk = std::min(size_, capacity_ - first);
+        out.insert(out.end(), column.begin() + first, column.begin() + first + firstChunk);
+        out.insert(out.end(), column.begin(), column.begin() + (size_ - firstChunk));
+    }
+
+    size_t capacity_;
+    size_t size_ = 0;
+    uint64_t pushed_ = 0;
+    std::tuple<std::vector<Columns>...> columns_;
+    RollingStats stats_;
+    mutable std::mutex mutex_;
+};
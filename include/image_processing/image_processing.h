@@ -2,6 +2,8 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <filesystem>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <vector>
@@ -10,6 +12,18 @@
 #include <chrono>
 #include <nlohmann/json.hpp>
 #include "CircularBuffer/CircularBuffer.h"
+#include "CircularBuffer/FrameRing.h"
+#include "CircularBuffer/TypedRing.h"
+#include "CircularBuffer/CompressedHistory.h"
+#include "CircularBuffer/ReorderBuffer.h"
+#include "CircularBuffer/BoundedQueue.h"
+#include "mib_grabber/BufferProducer.h"
+#include "mib_grabber/FrameSource.h"
+#include "mib_grabber/FrameLossTracker.h"
+#include "mib_grabber/BufferPoolSizer.h"
+#include "mib_grabber/PixelUnpack.h"
+#include "mib_grabber/ClockSync.h"
+#include "mib_grabber/ThreadTopology.h"
 
 #define M_PI 3.14159265358979323846 // pi
 
@@ -21,22 +35,54 @@ struct ImageParams
 {
     size_t width;
     size_t height;
-    uint64_t pixelFormat;
+    uint64_t pixelFormat; // PFNC code of the source pixels, 0 = 8-bit; the ring always holds 8-bit frames
     size_t imageSize;
     size_t bufferCount;
+    PixelNormalization levels;                  // acquisition.black_level / white_level
+    PixelUnpacker::GenericConvert otherFormats; // for formats without a fast path
+};
+
+// A frame handed to the processing thread, named by its ring sequence so
+// every published frame is either analysed or counted as skipped
+struct FrameWorkItem
+{
+    uint64_t sequence;
+    uint64_t frameId;
+};
+
+enum class ProcessingPolicy
+{
+    EveryFrame, // the processing consumer is pinned: the ring drops new frames rather than evict unanalysed ones
+    LatestOnly, // analyse the newest frame, count the ones passed over as skipped
 };
 
 struct QualifiedResult
 {
     // ContourResult contourResult;
-    int64_t timestamp;
+    int64_t timestamp; // acquisition time (system_clock, us), not processing time
+    uint64_t frameId;
+    uint64_t cameraTimestamp;
     double areaRatio;
     double area;
     double deformability;
+    int cameraId = 0;
 
     cv::Mat originalImage;
 };
 
+// What analysing one frame found. Workers produce these in any order; the
+// trigger, the measurements and the kept frame are applied by emitVerdict in
+// frame order.
+struct FrameVerdict
+{
+    FrameMeta meta;
+    bool valid = false;
+    double areaRatio = 0.0;
+    double area = 0.0;
+    double deformability = 0.0;
+    cv::Mat originalImage; // only for valid frames while results are being recorded
+};
+
 struct ProcessingConfig
 {
     ProcessingConfig(
@@ -60,6 +106,13 @@ struct ProcessingConfig
     int area_threshold_max;
 };
 
+struct ProcessingSnapshot
+{
+    cv::Rect roi;
+    cv::Mat background; // blurred; replaced on change, never written in place
+    ProcessingConfig config;
+};
+
 struct ThreadLocalMats
 {
     cv::Mat original;
@@ -85,14 +138,45 @@ struct SharedResources
     std::atomic<bool> displayNeedsUpdate{false};
     std::atomic<int> currentBatchNumber{0};
 
-    std::atomic<size_t> latestCameraFrame{0}; // for simulated camera
+    bool headless = false; // no display windows; set from config before the threads start
+    ThreadTopology threadTopology; // thread_topology from config, read with headless
+    std::function<void()> stepFrame; // advances a replay in step mode, set by sourceSample
+    std::mutex sourceTelemetryMutex;
+    std::string sourceName;
+    SourceTelemetry sourceTelemetry;
+    FrameLossTracker frameLoss; // per-cause loss counters of the current run, reset by each sample mode
+    // Configuration reload ('F'): armed after the script ran, cleared by the
+    // dispatcher on the first frame taken after the script finished
+    std::atomic<int64_t> reloadStartedUs{0};
+    std::atomic<int64_t> reloadFinishedUs{0};
+    std::atomic<uint64_t> reloadFinishedCameraUs{0}; // 0 while the clock fit is not valid
+    std::atomic<bool> awaitingReloadFrame{false};
+    std::atomic<double> reloadScriptMs{0.0};
+    std::atomic<double> reloadToFirstFrameMs{-1.0};
+    // Camera-side ROI: live runners that can change the sensor window set
+    // cameraRoiEnabled; the keys end the run with a request and the runner
+    // restarts with rings sized for the new frame
+    bool cameraRoiEnabled = false;
+    std::atomic<bool> cameraWindowRequested{false};
+    std::atomic<bool> fullSensorRequested{false};
+    std::string saveDirName; // chosen at the save prompt; preset to skip it on restarts
+    // Multi-camera runs: each camera has its own resources; qualified results
+    // of every camera go to camera 0's, which also runs keyboard and dashboard
+    int cameraId = 0;
+    SharedResources *resultSink = nullptr;    // camera 0's resources, on the other cameras
+    std::vector<SharedResources *> otherCameras; // on camera 0, for the dashboard and batch metadata
     std::atomic<size_t> frameRateCount{0};    // for simulated camera
-    std::queue<size_t> framesToProcess;
-    std::queue<size_t> framesToDisplay;
-    std::mutex displayQueueMutex;
+    // Fixed-size work queue, sized and given its overflow policy by
+    // setupCommonThreads; pushing never blocks on a consumer's lock. The
+    // display needs no queue: it follows the ring's sequence.
+    BoundedQueue<FrameWorkItem> framesToProcess;
+    std::atomic<uint64_t> framesAnalysed{0}; // analyzeFrame calls, audited against the frames received
+    // Ring processing workers take work items one at a time under
+    // processingQueueMutex, so items are numbered in queue order and
+    // verdicts emitted in that order
     std::mutex processingQueueMutex;
-    std::condition_variable displayQueueCondition;
-    std::condition_variable processingQueueCondition;
+    uint64_t nextProcessingTicket = 0;
+    std::unique_ptr<ReorderBuffer<FrameVerdict>> processingOrder;
     // std::vector<std::tuple<double, double>> deformabilities;
     // std::mutex deformabilitiesMutex;
     std::atomic<bool> newScatterDataAvailable{false};
@@ -100,8 +184,11 @@ struct SharedResources
     cv::Mat backgroundFrame;
     cv::Mat blurredBackground;
     std::mutex backgroundFrameMutex;
+    std::atomic<uint64_t> backgroundVersion{0}; // bumped whenever backgroundFrame is replaced
+    // Background-delta encoded history for review, when enabled in config
+    std::unique_ptr<CompressedHistory> compressedHistory;
     cv::Rect roi;
-    std::mutex roiMutex;
+    mutable std::mutex roiMutex; // guards roi once the threads run
 
     std::atomic<bool> running{false};
     std::vector<QualifiedResult> qualifiedResults;
@@ -116,9 +203,17 @@ struct SharedResources
     std::atomic<double> diskSaveTime;
     std::string saveDirectory;
     // metrics
-    CircularBuffer processingTimes{1000, sizeof(double)};                          // Buffer to store last 1000 processing times
-    CircularBuffer deformabilityBuffer{10000, sizeof(std::tuple<double, double>)}; // Buffer for last 1000 deformability measurements
-    std::mutex deformabilityBufferMutex;
+    TypedRing<double> processingTimes{1000, RollingStats(200.0)}; // last 1000 processing times (us), >200us counted
+    TypedRing<double, double> deformabilityBuffer{10000, RollingStats(std::numeric_limits<double>::max(), 1e-4, 1.0)}; // last 10000 (deformability 0..1, area) measurements
+    TypedRing<double> decisionLatencies{1000};                     // frame reaching the ring -> processing decision (us)
+    TypedRing<double> triggerLatencies{1000};                      // frame reaching the ring -> trigger pulse (us)
+    std::atomic<int64_t> triggerFrameSteadyUs{0};                  // hostSteadyUs of the frame that raised processTrigger
+    std::atomic<uint64_t> triggerFrameCameraUs{0};                 // and its camera timestamp
+    TypedRing<double> exposureToTriggerLatencies{1000};            // camera timestamp of the frame -> trigger pulse, camera time (us)
+    std::atomic<uint64_t> lateTriggers{0};                         // scheduled pulses whose camera time had already passed
+    ClockSync clockSync;                                           // camera timestamp <-> host steady clock
+    TypedRing<double> dispatchTimes{10000, RollingStats(50.0, 0.1, 1e6)}; // acquisition loop work per frame (us), >50us counted
+    TypedRing<double> historyEncodeTimes{1000};                    // compressed history encode cost per frame (us)
     std::atomic<double> currentFPS;
     std::atomic<double> dataRate;
     std::atomic<uint64_t> exposureTime;
@@ -142,12 +237,27 @@ struct SharedResources
     std::atomic<bool> processTrigger{false};
 };
 
+// Wraps a leased ring slot in a cv::Mat header without copying the pixels.
+// The Mat is only valid while the lease is held; clone() it to keep the image.
+inline cv::Mat frameView(const FrameLease &lease, size_t height, size_t width)
+{
+    return cv::Mat(static_cast<int>(height), static_cast<int>(width), CV_8UC1, const_cast<uint8_t *>(lease.data()));
+}
+
 // Function declarations
 ImageParams initializeImageParams(const std::string &directory);
+ImageParams initializeSourceParams(const FrameSource &source);
 void loadImages(const std::string &directory, CircularBuffer &cameraBuffer, bool reverseOrder = false);
 void initializeMockBackgroundFrame(SharedResources &shared, const ImageParams &params, const CircularBuffer &cameraBuffer);
-void processFrame(const cv::Mat &inputImage, SharedResources &shared,
+// The ROI (under roiMutex), settings and background (under
+// processingConfigMutex) one frame is processed and filtered with; the ROI is
+// clipped to imageSize
+ProcessingSnapshot takeProcessingSnapshot(SharedResources &shared, cv::Size imageSize);
+void processFrame(const cv::Mat &inputImage, const ProcessingSnapshot &snapshot,
                   cv::Mat &outputImage, ThreadLocalMats &mats);
+// Takes a snapshot, processes with it and returns it for the filter
+ProcessingSnapshot processFrame(const cv::Mat &inputImage, SharedResources &shared,
+                                cv::Mat &outputImage, ThreadLocalMats &mats);
 std::vector<std::vector<cv::Point>> findContours(const cv::Mat &processedImage);
 std::tuple<double, double> calculateMetrics(const std::vector<cv::Point> &contour);
 
@@ -156,19 +266,144 @@ void onTrackbar(int pos, void *userdata);
 
 // void saveQualifiedResultsToDisk(const std::vector<QualifiedResult> &results, const std::string &directory);
 void saveQualifiedResultsToDisk(const std::vector<QualifiedResult> &results, const std::string &directory, const SharedResources &shared);
+// One past the highest batch_N in directory, 0 when it has none
+int nextBatchNumber(const std::string &directory);
+// Creates the run's save directory under outputDir: saveDir, suffixed if it
+// exists, or on a restart (saveDirName already set) the previous run's
+// directory again, with batch numbers carrying on after its last batch
+std::filesystem::path openSaveDirectory(SharedResources &shared, const std::filesystem::path &outputDir,
+                                        const std::string &saveDir);
 
 void convertSavedImagesToStandardFormat(const std::string &binaryImageFile, const std::string &outputDirectory);
 json readConfig(const std::string &filename);
 ProcessingConfig getProcessingConfig(const json &config);
+FrameStorageOptions getFrameStorageOptions(const json &config);
+size_t getFrameRingCapacity(const json &config, size_t bufferCount);
+// Ring slots for a camera other than 0, which is neither displayed nor
+// reviewed: a few per processing worker for the display-rate copies
+size_t getSecondaryRingCapacity(const json &config);
+// frame_ring.processing_policy: "every_frame" or "latest_only"
+ProcessingPolicy getProcessingPolicy(const json &config);
+// frame_ring.<name> (e.g. "processing_queue"): policy
+// ("drop_oldest", "latest" or "block"), capacity and timeout_us over defaults
+BoundedQueueOptions getQueueOptions(const json &config, const std::string &name, const BoundedQueueOptions &defaults);
+ReplayOptions getReplayOptions(const json &config);
+BufferPoolOptions getBufferPoolOptions(const json &config);
+
+struct TelemetryOptions
+{
+    std::chrono::milliseconds interval{500};
+    bool onAcquisitionThread = false; // old inline polling, to compare dispatch jitter
+};
+TelemetryOptions getTelemetryOptions(const json &config);
+
+struct CameraRoiOptions
+{
+    bool enabled = false;   // 'c' pushes the software ROI to the camera, 'C' restores the full sensor
+    double frameRate = 0.0; // after a window change; 0 = the highest the window allows
+};
+CameraRoiOptions getCameraRoiOptions(const json &config);
+
+struct TriggerOptions
+{
+    int64_t delayUs = 0; // pulse at the frame's camera time + delayUs; 0 = as soon as the decision is made
+};
+TriggerOptions getTriggerOptions(const json &config);
+// thread_topology.<role>: cores and priority (1-99 for SCHED_FIFO) for
+// acquisition, trigger, processing, saver, display and metrics
+ThreadTopology getThreadTopology(const json &config);
+// Raw levels mapped to 0 and 255 when frames above 8 bits are reduced
+PixelNormalization getPixelNormalization(const json &config);
+// Source pixels to the 8-bit frames the pipeline analyses
+PixelUnpacker frameUnpacker(const ImageParams &params);
+// Grabber buffers to start with: sized for frameRate when the pool is
+// adaptive, acquisition.buffer_count otherwise
+size_t getInitialBufferCount(const json &config, double frameRate, size_t imageSize);
+// True when acquisition.camera_count is not 1, which runs every camera in
+// callback mode; logs when that replaces a configured pull or ring mode
+bool useMultiCamera(const json &config);
 
 bool updateConfig(const std::string &filename, const std::string &key, const json &value);
 
-void temp_mockSample(const ImageParams &params, CircularBuffer &cameraBuffer, CircularBuffer &circularBuffer, CircularBuffer &processingBuffer, SharedResources &shared);
+// Drives any FrameSource (camera, replay, synthetic) into the ring and queues
+void sourceSample(FrameSource &source, const ImageParams &params, FrameRing &frameRing, SharedResources &shared,
+                  const std::function<void(std::vector<std::thread> &)> &extraThreads = nullptr);
+// With an adaptive pool, the producer's buffers are regrown as the measured
+// frame rate and buffer hold times require
+void producerSample(BufferProducer &producer, const ImageParams &params, FrameRing &frameRing, SharedResources &shared,
+                    size_t workerCount, const BufferPoolOptions &pool,
+                    const std::function<void(std::vector<std::thread> &)> &extraThreads = nullptr);
+// Acquires straight into the ring slots: the producer fills the slots in place
+// and keeps queueDepth of them queued, the rest stay readable as history
+// One camera of a multi-camera run, with its own ring and resources (background, ROI)
+struct CameraChannel
+{
+    int cameraId = 0;
+    BufferProducer *producer = nullptr;
+    ImageParams params;
+    std::unique_ptr<FrameRing> frameRing;
+    std::unique_ptr<SharedResources> shared;
+};
+// Acquires from every camera at once. Each one gets its own analysis workers,
+// so throughput scales with cores; camera 0 drives the keyboard, dashboard,
+// display and the merged result store, whose batches tag results by camera.
+void multiCameraSample(std::vector<CameraChannel> &cameras, size_t workersPerCamera, const BufferPoolOptions &pool,
+                       const std::function<void(std::vector<std::thread> &)> &extraThreads = nullptr);
+void ringAcquisitionSample(BufferProducer &producer, const ImageParams &params, FrameRing &frameRing, SharedResources &shared,
+                           size_t queueDepth, const std::function<void(std::vector<std::thread> &)> &extraThreads = nullptr);
+
+// Reads slow device features (frame rate, data rate, exposure) every interval
+// at low priority and publishes them, off the acquisition thread
+void telemetryPollerThread(SharedResources &shared, std::function<SourceTelemetry()> poll, std::chrono::milliseconds interval);
+void publishTelemetry(SharedResources &shared, const SourceTelemetry &telemetry);
+void printLatencyHistogram(const std::string &title, const std::vector<double> &samplesUs);
+// Frames received against frames analysed, skipped by policy or lost in the pipeline
+void printProcessingAudit(const SharedResources &shared);
+void printQueueStats(const std::string &name, const BoundedQueueStats &stats);
+// How far the processing workers ran ahead of the frame-order emit
+void printReorderSummary(const ReorderBuffer<FrameVerdict> &order);
 
-void simulateCameraThread(CircularBuffer &cameraBuffer, SharedResources &shared, const ImageParams &params);
+// Queues a frame already in the ring for the processing workers
+void publishFrame(SharedResources &shared, uint64_t sequence, uint64_t frameId);
+// Runs a configuration script on the live grabber and arms the
+// reload-to-first-frame measurement completed by noteReloadFrame
+void reloadConfiguration(SharedResources &shared, const std::string &scriptPath);
+// Frames already queued when the script ran are passed over: a frame counts
+// when its camera timestamp is after the script finished, or, without a
+// clock fit, when it reached the host after that
+inline void noteReloadFrame(SharedResources &shared, const FrameMeta &meta)
+{
+    if (!shared.awaitingReloadFrame.load(std::memory_order_relaxed))
+        return;
+    uint64_t finishedCameraUs = shared.reloadFinishedCameraUs.load();
+    bool afterReload = finishedCameraUs != 0 && meta.cameraTimestamp != 0
+                           ? meta.cameraTimestamp >= finishedCameraUs
+                           : meta.hostSteadyUs >= shared.reloadFinishedUs.load();
+    if (afterReload && shared.awaitingReloadFrame.exchange(false))
+        shared.reloadToFirstFrameMs = (meta.hostSteadyUs - shared.reloadStartedUs.load()) / 1000.0;
+}
+// ringProcessing = false when frames are analysed straight from acquisition
+// buffers and the ring only feeds display and review
 void setupCommonThreads(SharedResources &shared, const std::string &saveDir,
-                        const CircularBuffer &circularBuffer, const CircularBuffer &processingBuffer, const ImageParams &params,
-                        std::vector<std::thread> &threads);
+                        FrameRing &frameRing, const ImageParams &params,
+                        std::vector<std::thread> &threads, bool ringProcessing = true);
+// completeFrame fills in the rest of inputImage when only the ROI was
+// unpacked, before a qualified frame is kept
+void analyzeFrame(const cv::Mat &inputImage, const FrameMeta &meta, SharedResources &shared,
+                  cv::Mat &processedImage, ThreadLocalMats &mats,
+                  const std::function<void()> &completeFrame = nullptr);
+// analyzeFrame in two halves for parallel workers: measureFrame only touches
+// the worker's own Mats, emitVerdict applies the result and is called in frame order
+FrameVerdict measureFrame(const cv::Mat &inputImage, const FrameMeta &meta, SharedResources &shared,
+                          cv::Mat &processedImage, ThreadLocalMats &mats,
+                          const std::function<void()> &completeFrame = nullptr);
+// With a snapshot the caller already took, e.g. to unpack just the ROI
+FrameVerdict measureFrame(const cv::Mat &inputImage, const FrameMeta &meta, SharedResources &shared,
+                          const ProcessingSnapshot &snapshot, cv::Mat &processedImage, ThreadLocalMats &mats,
+                          const std::function<void()> &completeFrame = nullptr);
+void emitVerdict(SharedResources &shared, FrameVerdict &verdict);
+// Tickets a worker can run ahead of the oldest unfinished frame
+inline size_t reorderWindow(size_t workerCount) { return 4 * workerCount; }
 void commonSampleLogic(SharedResources &shared, const std::string &SAVE_DIRECTORY,
                        std::function<std::vector<std::thread>(SharedResources &, const std::string &)> setupThreads);
 
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <nlohmann/json.hpp>
+#include "mib_grabber/FrameSource.h"
 
 namespace MenuSystem
 {
@@ -9,9 +12,15 @@ namespace MenuSystem
     void displayMenu();
     void runMockSample();
     void runLiveSample();
+    // Replays the selected source through the mock producer once per
+    // buffer_pool.benchmark_counts entry and prints the loss rate of each
+    void runBufferPoolBenchmark();
     void convertSavedImages();
     void egrabberConfig();
     int runMenu();
     void processAllBatches(const std::string &saveDirectory);
     std::string navigateAndSelectFolder();
+    // Builds the replay source named by acquisition.source in config.json,
+    // prompting for its folder or file; nullptr if the selection was cancelled
+    std::unique_ptr<ReplayFrameSource> selectReplaySource(const nlohmann::json &config);
 } // namespace MenuSystem
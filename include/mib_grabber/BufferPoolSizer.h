@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "CircularBuffer/CircularBuffer.h"
+#include "mib_grabber/BufferProducer.h"
+
+struct BufferPoolOptions
+{
+    bool adaptive = true;                   // false keeps acquisition.buffer_count
+    size_t minBuffers = 4;
+    size_t maxBuffers = 4096;
+    size_t memoryBudgetBytes = 256u << 20;  // all buffers of one grabber
+    double latencyAllowanceUs = 2000.0;     // consumer p99.9 assumed until one is measured
+    double headroom = 2.0;                  // multiplies the buffers in flight at p99.9
+    double growThreshold = 1.25;            // grow only when the target exceeds the pool by this factor
+};
+
+// Sizes a grabber's buffer pool so the frames that arrive while a buffer is
+// held by the consumer (p99.9 hold time / frame interval) fit with headroom,
+// within the memory budget.
+class BufferPoolSizer
+{
+public:
+    BufferPoolSizer(const BufferPoolOptions &options, size_t imageSize);
+
+    size_t maxCount() const { return maxCount_; }
+    size_t target(double frameIntervalUs, double consumerLatencyUs) const;
+    // Before any frame: the frame rate the camera is set to and the allowance
+    size_t initialCount(double frameRate) const;
+    // New pool size, or current if it is large enough
+    size_t grow(size_t current, double frameIntervalUs, double consumerP999Us) const;
+    const BufferPoolOptions &options() const { return options_; }
+
+private:
+    BufferPoolOptions options_;
+    size_t maxCount_;
+};
+
+// Regrows a running producer's pool once a second from the frame rate seen by
+// its loss tracker (received + camera gaps) and the p99.9 of serviceTimes, the
+// time a worker has a buffer from dequeue to requeue. Time spent waiting in a
+// handoff queue is left out: it grows with the pool when the workers fall
+// behind, and more buffers cannot fix that. No growth while QueueDrop rises.
+class BufferPoolAdapter
+{
+public:
+    BufferPoolAdapter(BufferProducer &producer, const BufferPoolSizer &sizer, const FrameLossTracker &loss,
+                      const TypedRing<double> &serviceTimes);
+    void poll();
+
+private:
+    BufferProducer &producer_;
+    const BufferPoolSizer &sizer_;
+    const FrameLossTracker &loss_;
+    const TypedRing<double> &serviceTimes_;
+    std::chrono::steady_clock::time_point lastPoll_;
+    uint64_t lastArrived_ = 0;
+    uint64_t lastQueueDrops_ = 0;
+    bool heldBack_ = false;
+};
+
+struct PoolSweepResult
+{
+    size_t bufferCount = 0;
+    uint64_t received = 0;
+    uint64_t lost = 0;
+    double lossPercent = 0.0;
+    double holdP999Us = 0.0;
+};
+
+// Benchmark: replays frames through a MockBufferProducer at fps once per
+// buffer count, consumed by workers that call consume on every buffer, and
+// reports the frames lost to pool starvation for each count.
+std::vector<PoolSweepResult> sweepBufferPool(const CircularBuffer &frames, size_t imageSize, double fps,
+                                             const std::vector<size_t> &counts, size_t workers,
+                                             std::chrono::milliseconds duration,
+                                             const std::function<void(const AcquiredBuffer &)> &consume);
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "CircularBuffer/FrameRing.h"
+#include "CircularBuffer/TypedRing.h"
+#include "mib_grabber/FrameLossTracker.h"
+
+// Callback-driven acquisition without copying frames out of the driver.
+// A producer owns a pool of buffers (GenTL buffers on a Coaxlink board, plain
+// memory in the mock) and hands each filled buffer to a callback. Consumers
+// analyse the pixels in place and the buffer goes back to the producer's input
+// queue only when the last AcquiredBuffer handle for it is released.
+class BufferProducer;
+
+class AcquiredBuffer
+{
+public:
+    AcquiredBuffer() = default;
+    ~AcquiredBuffer() { release(); }
+    AcquiredBuffer(AcquiredBuffer &&other) noexcept;
+    AcquiredBuffer &operator=(AcquiredBuffer &&other) noexcept;
+    AcquiredBuffer(const AcquiredBuffer &) = delete;
+    AcquiredBuffer &operator=(const AcquiredBuffer &) = delete;
+
+    explicit operator bool() const { return data_ != nullptr; }
+    const uint8_t *data() const { return data_; }
+    const FrameMeta &meta() const { return meta_; }
+    // Requeues the buffer; the pixels must not be touched afterwards
+    void release();
+
+private:
+    friend class BufferProducer;
+    AcquiredBuffer(BufferProducer *producer, size_t index, const uint8_t *data, const FrameMeta &meta)
+        : producer_(producer), index_(index), data_(data), meta_(meta) {}
+
+    BufferProducer *producer_ = nullptr;
+    size_t index_ = 0;
+    const uint8_t *data_ = nullptr;
+    FrameMeta meta_;
+};
+
+class BufferProducer
+{
+public:
+    // Invoked from the producer's own thread(s), possibly concurrently;
+    // it should hand the buffer off rather than process it inline
+    using FrameCallback = std::function<void(AcquiredBuffer &&buffer)>;
+
+    virtual ~BufferProducer() = default;
+
+    virtual void start(FrameCallback onFrame) = 0;
+    virtual void stop() = 0;
+    virtual size_t bufferCount() const = 0;
+    virtual size_t imageSize() const = 0;
+    // PFNC code of the delivered pixels; 0 for plain 8-bit frames
+    virtual uint64_t pixelFormat() const { return 0; }
+
+    // Replaces the producer's own buffers with count caller-owned buffers of
+    // stride bytes starting at base (e.g. FrameRing slots), in the same order,
+    // so the index of a delivered buffer is its position in that array. Only
+    // the first queued buffers are queued; the caller adds the others with
+    // queueExternal. Call before start().
+    virtual void announceExternal(uint8_t *base, size_t stride, size_t count, size_t queued) = 0;
+    // Queues an external buffer that has not been queued since it was announced
+    virtual void queueExternal(size_t index) = 0;
+    // Adds buffers to the running pool until it holds count. Pools never
+    // shrink while acquiring; external buffers cannot grow.
+    virtual void growPool(size_t count) = 0;
+
+    uint64_t delivered() const { return delivered_.load(std::memory_order_relaxed); }
+    size_t outstanding() const { return outstanding_.load(std::memory_order_relaxed); }
+    // Where the producer reports buffers it discards before delivery
+    void setLossTracker(FrameLossTracker *loss) { loss_ = loss; }
+    // Delivery to release of the last handle, over the last 4096 buffers (us)
+    RollingStatsSnapshot holdTimeStats() const { return holdTimes_.stats(); }
+
+protected:
+    // Wraps a filled buffer in a handle that requeues it on release
+    AcquiredBuffer deliver(size_t index, const uint8_t *data, FrameMeta meta)
+    {
+        meta.sequence = delivered_.fetch_add(1, std::memory_order_relaxed) + 1;
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+        meta.hostSteadyUs = steadyNowUs();
+        meta.hostWallUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+        return AcquiredBuffer(this, index, data, meta);
+    }
+
+    virtual void requeue(size_t index) = 0;
+
+    FrameLossTracker *loss_ = nullptr;
+
+private:
+    friend class AcquiredBuffer;
+
+    void returnBuffer(size_t index, int64_t deliveredUs)
+    {
+        holdTimes_.push(static_cast<double>(steadyNowUs() - deliveredUs));
+        outstanding_.fetch_sub(1, std::memory_order_relaxed);
+        requeue(index);
+    }
+
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<size_t> outstanding_{0};
+    TypedRing<double> holdTimes_{4096};
+};
+
+inline AcquiredBuffer::AcquiredBuffer(AcquiredBuffer &&other) noexcept
+    : producer_(other.producer_), index_(other.index_), data_(other.data_), meta_(other.meta_)
+{
+    other.producer_ = nullptr;
+    other.data_ = nullptr;
+}
+
+inline AcquiredBuffer &AcquiredBuffer::operator=(AcquiredBuffer &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        producer_ = other.producer_;
+        index_ = other.index_;
+        data_ = other.data_;
+        meta_ = other.meta_;
+        other.producer_ = nullptr;
+        other.data_ = nullptr;
+    }
+    return *this;
+}
+
+inline void AcquiredBuffer::release()
+{
+    if (producer_ != nullptr)
+    {
+        producer_->returnBuffer(index_, meta_.hostSteadyUs);
+        producer_ = nullptr;
+        data_ = nullptr;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <EGrabber.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Sensor window streamed by the camera, in sensor pixels
+struct CameraWindow
+{
+    int64_t width = 0;
+    int64_t height = 0;
+    int64_t offsetX = 0;
+    int64_t offsetY = 0;
+};
+
+struct CameraWindowLimits
+{
+    int64_t widthMax = 0;
+    int64_t heightMax = 0;
+    int64_t widthMin = 1;
+    int64_t heightMin = 1;
+    int64_t widthInc = 1;
+    int64_t heightInc = 1;
+    int64_t offsetXInc = 1;
+    int64_t offsetYInc = 1;
+};
+
+struct CameraWindowChange
+{
+    CameraWindow before;
+    CameraWindow after;
+    double frameRateBefore = 0.0;
+    double frameRateAfter = 0.0;
+};
+
+// Remote device feature access, so the window logic runs the same against a
+// grabber and against a model of a camera
+struct CameraFeatures
+{
+    std::function<int64_t(const std::string &)> getInteger;
+    std::function<void(const std::string &, int64_t)> setInteger;
+    std::function<double(const std::string &)> getFloat;
+    std::function<void(const std::string &, double)> setFloat;
+};
+
+template <typename CallbackModel>
+CameraFeatures cameraFeatures(Euresys::EGrabber<CallbackModel> &grabber)
+{
+    CameraFeatures features;
+    features.getInteger = [&grabber](const std::string &name)
+    { return grabber.template getInteger<Euresys::RemoteModule>(name); };
+    features.setInteger = [&grabber](const std::string &name, int64_t value)
+    { grabber.template setInteger<Euresys::RemoteModule>(name, value); };
+    features.getFloat = [&grabber](const std::string &name)
+    { return grabber.template getFloat<Euresys::RemoteModule>(name); };
+    features.setFloat = [&grabber](const std::string &name, double value)
+    { grabber.template setFloat<Euresys::RemoteModule>(name, value); };
+    return features;
+}
+
+CameraWindow readCameraWindow(const CameraFeatures &camera);
+// WidthMax/HeightMax and the .Min/.Inc attributes, 1 where a camera has none
+CameraWindowLimits readCameraWindowLimits(const CameraFeatures &camera);
+// Grows the requested window outwards to the camera's increments and keeps
+// it on the sensor, so the requested pixels are always streamed
+CameraWindow alignCameraWindow(const CameraWindow &request, const CameraWindowLimits &limits);
+// Moves the camera to the window, acquisition stopped. The frame rate is
+// lowered to its minimum before the window grows and raised afterwards to
+// frameRate, or the highest the new window allows when frameRate is 0.
+CameraWindowChange applyCameraWindow(const CameraFeatures &camera, const CameraWindow &target, double frameRate);
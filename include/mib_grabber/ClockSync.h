@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+struct ClockSyncOptions
+{
+    size_t blockFrames = 64; // frames per block; the least delayed one is kept
+    size_t blockCount = 32;  // blocks in the fit window
+    // A block minimum further than this from the fit means the camera clock
+    // was reset or jumped; the fit starts over
+    int64_t jumpUs = 100000;
+};
+
+// Snapshot of the fitted relation host = camera + offset + drift * (camera - reference)
+struct ClockEstimate
+{
+    bool valid = false;
+    uint64_t cameraReferenceUs = 0; // camera time of the newest block minimum
+    double offsetUs = 0.0;          // host steady minus camera time at the reference
+    double driftPpm = 0.0;          // how much faster the host clock runs
+    double residualUs = 0.0;        // largest block minimum off the fit
+    uint64_t blocks = 0;            // block minima in the fit
+
+    // Host steady_clock time (us) at which a frame stamped cameraUs arrives
+    // with the least delivery delay seen
+    int64_t hostUs(uint64_t cameraUs) const
+    {
+        double elapsed = static_cast<double>(static_cast<int64_t>(cameraUs - cameraReferenceUs));
+        return static_cast<int64_t>(cameraUs) + static_cast<int64_t>(offsetUs + driftPpm * 1e-6 * elapsed);
+    }
+    // Inverse of hostUs
+    uint64_t cameraUs(int64_t hostSteadyUs) const
+    {
+        double sinceReference = static_cast<double>(hostSteadyUs - hostUs(cameraReferenceUs));
+        return cameraReferenceUs + static_cast<uint64_t>(static_cast<int64_t>(sinceReference / (1.0 + driftPpm * 1e-6)));
+    }
+};
+
+// Relates the camera/grabber timestamp (BUFFER_INFO_TIMESTAMP, us) to the
+// host steady clock. Every frame's arrival is a sample of offset plus a
+// delivery delay that is never negative, so only the least delayed frame of
+// each block is kept and a line is fitted through those minima: its slope is
+// the drift and it tracks the offset continuously. Mapped times are therefore
+// as seen through the fastest delivery; the fixed minimum transfer time from
+// the board is part of the offset.
+class ClockSync
+{
+public:
+    explicit ClockSync(const ClockSyncOptions &options = ClockSyncOptions());
+
+    // One writer (the thread that receives frames); frames with a zero
+    // camera timestamp are ignored
+    void observe(uint64_t cameraUs, int64_t hostSteadyUs);
+    void reset();
+
+    ClockEstimate estimate() const;
+    uint64_t resyncs() const;
+
+private:
+    struct Sample
+    {
+        uint64_t cameraUs;
+        int64_t delta; // host - camera
+    };
+
+    void fit();
+
+    ClockSyncOptions options_;
+    // Writer only
+    size_t blockFill_ = 0;
+    Sample blockMin_{0, 0};
+    std::deque<Sample> minima_;
+
+    mutable std::mutex estimateMutex_;
+    ClockEstimate estimate_;
+    uint64_t resyncs_ = 0;
+};
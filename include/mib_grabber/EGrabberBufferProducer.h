@@ -0,0 +1,50 @@
+#pragma once
+
+#include <EGrabber.h>
+#include <mutex>
+#include <vector>
+#include "mib_grabber/BufferProducer.h"
+
+// Coaxlink acquisition through EGrabber<CallbackMultiThread>. onNewBufferEvent
+// hands the GenTL buffer to the frame callback as-is; the buffer is pushed
+// back to the data stream only once the consumer releases it, so no frame is
+// copied out of driver memory.
+class EGrabberBufferProducer : public Euresys::EGrabber<Euresys::CallbackMultiThread>, public BufferProducer
+{
+public:
+    EGrabberBufferProducer(const Euresys::EGrabberCameraInfo &camera, size_t bufferCount);
+    ~EGrabberBufferProducer() override;
+
+    void start(FrameCallback onFrame) override;
+    void stop() override;
+    size_t bufferCount() const override { return bufferCount_.load(std::memory_order_relaxed); }
+    size_t imageSize() const override { return imageSize_; }
+    uint64_t pixelFormat() const override { return pixelFormat_; }
+    // Revokes the GenTL-allocated buffers and announces the caller's memory
+    // with announceAndQueue(UserMemoryArray), so frames are DMA-written there
+    void announceExternal(uint8_t *base, size_t stride, size_t count, size_t queued) override;
+    void queueExternal(size_t index) override;
+    // GenTL allows announcing and queueing buffers during acquisition
+    void growPool(size_t count) override;
+    size_t width() const { return width_; }
+    size_t height() const { return height_; }
+
+protected:
+    void requeue(size_t index) override;
+
+private:
+    void onNewBufferEvent(const Euresys::NewBufferData &data) override;
+
+    std::atomic<size_t> bufferCount_;
+    Euresys::BufferIndexRange announced_;
+    uint8_t *externalBase_ = nullptr; // set when acquiring into user memory
+    size_t externalStride_ = 0;
+    size_t imageSize_ = 0;
+    uint64_t pixelFormat_ = 0;
+    size_t width_ = 0;
+    size_t height_ = 0;
+    FrameCallback onFrame_;
+    // Buffers handed out and not yet released, indexed by GenTL buffer index
+    std::vector<Euresys::NewBufferData> inFlight_;
+    std::mutex inFlightMutex_;
+};
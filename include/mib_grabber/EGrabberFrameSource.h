@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <EGrabber.h>
+#include "mib_grabber/FrameSource.h"
+
+// PFNC code of the buffers as delivered, after any unpacking by the board.
+// Converted by name, so a grabber reporting another namespace gives the same
+// code in every acquisition mode.
+template <typename CallbackModel>
+uint64_t grabberPixelFormat(Euresys::EGrabber<CallbackModel> &grabber)
+{
+    return grabber.getGenTL().imageGetPixelFormatValue(grabber.getPixelFormat(), Euresys::gc::PIXELFORMAT_NAMESPACE_PFNC_32BIT);
+}
+
+// Slow feature reads over the control channel; call from the telemetry poller
+// only. Frame counts are left to the caller.
+template <typename CallbackModel>
+SourceTelemetry readGrabberTelemetry(Euresys::EGrabber<CallbackModel> &grabber)
+{
+    SourceTelemetry result;
+    result.frameRate = static_cast<double>(grabber.template getInteger<Euresys::StreamModule>("StatisticsFrameRate"));
+    result.dataRate = static_cast<double>(grabber.template getInteger<Euresys::StreamModule>("StatisticsDataRate"));
+    result.exposureTime = static_cast<double>(grabber.template getInteger<Euresys::RemoteModule>("ExposureTime"));
+    return result;
+}
+
+// Live Coaxlink acquisition pulled with EGrabber<CallbackOnDemand>. The
+// returned pixels are the GenTL buffer itself; it is pushed back to the data
+// stream on the next call, once the dispatcher has copied it into the ring.
+class EGrabberFrameSource : public FrameSource
+{
+public:
+    EGrabberFrameSource(Euresys::EGrabber<Euresys::CallbackOnDemand> &grabber, size_t width, size_t height, size_t imageSize);
+    ~EGrabberFrameSource() override;
+
+    std::string name() const override { return "camera"; }
+    size_t width() const override { return width_; }
+    size_t height() const override { return height_; }
+    size_t imageSize() const override { return imageSize_; }
+
+    void start() override;
+    void stop() override;
+    const uint8_t *nextFrame(FrameMeta &meta) override;
+    SourceTelemetry telemetry() override;
+
+private:
+    void releaseCurrent();
+
+    Euresys::EGrabber<Euresys::CallbackOnDemand> &grabber_;
+    size_t width_;
+    size_t height_;
+    size_t imageSize_;
+    Euresys::NewBufferData current_;
+    bool holding_ = false;
+    // Read by the telemetry poller
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> incomplete_{0};
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "CircularBuffer/TypedRing.h"
+
+enum class LossCause
+{
+    CameraGap,     // frame ids missing between consecutive buffers
+    Incomplete,    // buffers the grabber flagged as incomplete
+    Duplicate,     // frame id seen before
+    RingOverwrite, // replaced in the ring before the processing thread analysed it
+    QueueDrop,     // dropped by a full handoff queue or a pinned ring slot
+    Skipped,       // left unanalysed on purpose (latest_only processing); not a loss
+    Count
+};
+
+struct FrameLossSnapshot
+{
+    uint64_t received = 0; // distinct frames that reached the pipeline, including those dropped there later
+    std::array<uint64_t, static_cast<size_t>(LossCause::Count)> lost{};
+    uint64_t totalLost() const;
+    // Frames that never reached the pipeline (camera gaps, incomplete buffers)
+    uint64_t cameraLost() const;
+    // lost / frames the camera sent (received + cameraLost); host-side drops
+    // are already part of received. Duplicates and skips are excluded.
+    double lossPercent() const;
+};
+
+// Per-cause frame loss counters for one acquisition run. Counting is safe
+// from any thread; sampleIfDue() turns the counters into a loss-rate series
+// (percent per second) for the dashboard and saved batches.
+class FrameLossTracker
+{
+public:
+    FrameLossTracker();
+
+    void reset();
+    // Call for every complete buffer, in delivery order. Returns false for a
+    // duplicate, which should not be processed. A frame arriving after a newer
+    // one (concurrent callbacks) fills the gap it was counted in, if that id
+    // is still missing and at most LATE_WINDOW behind the newest; any other
+    // older id is a duplicate. A jump back further than that is taken as the
+    // camera's counter restarting and becomes the new reference.
+    bool observeFrameId(uint64_t frameId);
+    static constexpr uint64_t LATE_WINDOW = 1024;
+    uint64_t frameIdResets() const { return frameIdResets_.load(std::memory_order_relaxed); }
+    void count(LossCause cause, uint64_t frames = 1);
+
+    FrameLossSnapshot snapshot() const;
+    void sampleIfDue(std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+    RollingStatsSnapshot lossRateStats() const { return lossRates_.stats(); }
+    std::vector<double> lossRateHistory() const { return std::get<0>(lossRates_.columns()); } // oldest first
+    std::string summary() const; // one line, for the console
+
+    static const char *causeName(LossCause cause);
+
+private:
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(LossCause::Count)> lost_;
+    std::atomic<uint64_t> received_{0};
+
+    std::mutex frameIdMutex_;
+    bool haveFrameId_ = false;
+    uint64_t lastFrameId_ = 0;
+    std::set<uint64_t> missing_; // gap ids within LATE_WINDOW of lastFrameId_
+    std::atomic<uint64_t> frameIdResets_{0};
+
+    std::mutex sampleMutex_;
+    std::chrono::steady_clock::time_point lastSample_;
+    FrameLossSnapshot lastSnapshot_;
+    // Last 10 minutes of per-second loss, seconds with any loss counted
+    TypedRing<double> lossRates_{600, RollingStats(0.0, 1e-4, 100.0)};
+};
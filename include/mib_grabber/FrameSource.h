@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "CircularBuffer/CircularBuffer.h"
+#include "CircularBuffer/FrameRing.h"
+#include "mib_grabber/FrameLossTracker.h"
+#include "mib_grabber/ReplayEngine.h"
+
+// Figures shown on the dashboard, polled off the acquisition thread
+struct SourceTelemetry
+{
+    double frameRate = 0.0;
+    double dataRate = 0.0;
+    double exposureTime = 0.0;
+    // Frame accounting since start; see ReplayStats for replayed sources
+    uint64_t delivered = 0;
+    uint64_t coalesced = 0;
+    uint64_t dropped = 0;
+    double meanLatenessUs = 0.0;
+    double maxLatenessUs = 0.0;
+};
+
+// Where frames come from: a live camera, frames replayed from disk or
+// generated frames. sourceSample() drives any of them into the ring and the
+// processing/display queues, so every acquisition mode shares one dispatch
+// path and the pipeline runs without a camera.
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+
+    virtual std::string name() const = 0;
+    virtual size_t width() const = 0;
+    virtual size_t height() const = 0;
+    virtual size_t imageSize() const = 0;
+
+    virtual void start() {}
+    virtual void stop() {}
+    // Blocks until the next frame is due. Returns nullptr when no usable frame
+    // arrived (timeout or incomplete buffer); otherwise the pixels stay valid
+    // until the next call. Host timestamps are left to the ring, frame id gaps
+    // and duplicates to the dispatcher.
+    virtual const uint8_t *nextFrame(FrameMeta &meta) = 0;
+    // May read slow device features; called from the telemetry poller while
+    // another thread is in nextFrame, never concurrently with itself
+    virtual SourceTelemetry telemetry() = 0;
+    // Advances a source that is waiting for manual steps
+    virtual void step() {}
+    // Called by the dispatcher around a pause, so a paced source does not
+    // count the paused time as frames that fell due
+    virtual void pause() {}
+    virtual void resume() {}
+
+    // Where the source reports frames it discards itself
+    void setLossTracker(FrameLossTracker *loss) { loss_ = loss; }
+
+protected:
+    FrameLossTracker *loss_ = nullptr;
+};
+
+// Replays frames held in memory in order, looping, paced by a ReplayEngine.
+// Backs the directory, images.bin and synthetic sources.
+class ReplayFrameSource : public FrameSource
+{
+public:
+    ReplayFrameSource(std::string name, std::unique_ptr<CircularBuffer> frames,
+                      size_t width, size_t height, const ReplayOptions &options);
+
+    std::string name() const override { return name_; }
+    size_t width() const override { return width_; }
+    size_t height() const override { return height_; }
+    size_t imageSize() const override { return width_ * height_; }
+    const CircularBuffer &frames() const { return *frames_; }
+
+    void start() override;
+    const uint8_t *nextFrame(FrameMeta &meta) override;
+    SourceTelemetry telemetry() override;
+    void step() override { engine_.step(); }
+    void pause() override { engine_.pause(); }
+    void resume() override { engine_.resume(); }
+    ReplayStats replayStats() const { return engine_.stats(); }
+
+    // Frames are replayed in file name order
+    static std::unique_ptr<ReplayFrameSource> fromDirectory(const std::string &directory, const ReplayOptions &options);
+    // Frames saved by saveQualifiedResultsToDisk; images of another size are skipped
+    static std::unique_ptr<ReplayFrameSource> fromImagesBin(const std::string &path, const ReplayOptions &options);
+    // Noisy channel background with a cell crossing it every cycleFrames frames
+    static std::unique_ptr<ReplayFrameSource> synthetic(size_t width, size_t height, size_t cycleFrames, const ReplayOptions &options);
+
+private:
+    std::string name_;
+    std::unique_ptr<CircularBuffer> frames_;
+    size_t width_;
+    size_t height_;
+    ReplayEngine engine_;
+    std::atomic<uint64_t> telemetryFrames_{0};
+    std::chrono::steady_clock::time_point telemetryStart_;
+};
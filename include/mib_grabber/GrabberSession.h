@@ -0,0 +1,107 @@
+#pragma once
+
+#include <EGrabber.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Outcome of a configuration reload
+struct ReloadResult
+{
+    size_t liveGrabbers = 0;     // grabbers acquiring when the script ran; 0 when one was opened for it
+    double scriptMs = 0.0;       // time spent in runScript
+    double firstFrameMs = -1.0;  // reload start to the first frame, -1 if not measured here
+};
+
+// Process-wide GenTL session. Owns the EGenTL handle and the camera discovery,
+// which is run once and reused until invalidated, so opening a camera or
+// reloading a configuration script does not rescan the hardware. Sample modes
+// attach the grabbers they acquire with; scripts and feature writes then go to
+// those grabbers instead of a second grabber opened on the same camera.
+class GrabberSession
+{
+public:
+    static GrabberSession &instance();
+
+    Euresys::EGenTL &genTL();
+    // Discovers on first use and after invalidateDiscovery()
+    Euresys::EGrabberDiscovery &discovery();
+    // Call when cameras were plugged or unplugged; the next discovery() rescans
+    void invalidateDiscovery();
+    int cameraCount() { return discovery().cameraCount(); }
+    Euresys::EGrabberCameraInfo camera(int index) { return discovery().cameras(index); }
+
+    void selectCamera(int index) { selectedCamera_ = index; }
+    int selectedCamera() const { return selectedCamera_; }
+
+    // Registration of a running grabber, removed when it goes out of scope
+    class Attachment
+    {
+    public:
+        Attachment() = default;
+        Attachment(GrabberSession *session, uint64_t id) : session_(session), id_(id) {}
+        Attachment(Attachment &&other) noexcept : session_(other.session_), id_(other.id_) { other.session_ = nullptr; }
+        Attachment &operator=(Attachment &&other) noexcept;
+        ~Attachment() { release(); }
+        void release();
+
+    private:
+        GrabberSession *session_ = nullptr;
+        uint64_t id_ = 0;
+    };
+
+    template <typename CallbackModel>
+    Attachment attach(Euresys::EGrabber<CallbackModel> &grabber, int cameraIndex);
+
+    // Runs a .js configuration script on the attached grabbers. With none
+    // attached, opens the selected camera, runs the script there and times the
+    // first frame after it.
+    ReloadResult runScript(const std::string &path);
+    // Remote (camera) feature writes on every attached grabber; false if none
+    bool setFloat(const std::string &feature, double value);
+    bool setInteger(const std::string &feature, int64_t value);
+
+private:
+    GrabberSession() = default;
+
+    struct LiveGrabber
+    {
+        uint64_t id;
+        int cameraIndex;
+        std::function<void(const std::string &)> runScript;
+        std::function<void(const std::string &, double)> setFloat;
+        std::function<void(const std::string &, int64_t)> setInteger;
+    };
+
+    void detach(uint64_t id);
+    ReloadResult runScriptOnSelected(const std::string &path);
+
+    std::unique_ptr<Euresys::EGenTL> genTL_;
+    std::unique_ptr<Euresys::EGrabberDiscovery> discovery_;
+    bool discovered_ = false;
+    int selectedCamera_ = -1;
+    std::mutex discoveryMutex_;
+    std::vector<LiveGrabber> live_;
+    uint64_t nextId_ = 1;
+    std::mutex liveMutex_; // live_ and script runs; taken before discoveryMutex_
+};
+
+template <typename CallbackModel>
+GrabberSession::Attachment GrabberSession::attach(Euresys::EGrabber<CallbackModel> &grabber, int cameraIndex)
+{
+    std::lock_guard<std::mutex> lock(liveMutex_);
+    LiveGrabber live;
+    live.id = nextId_++;
+    live.cameraIndex = cameraIndex;
+    live.runScript = [&grabber](const std::string &path)
+    { grabber.runScript(path); };
+    live.setFloat = [&grabber](const std::string &feature, double value)
+    { grabber.template setFloat<Euresys::RemoteModule>(feature, value); };
+    live.setInteger = [&grabber](const std::string &feature, int64_t value)
+    { grabber.template setInteger<Euresys::RemoteModule>(feature, value); };
+    live_.push_back(std::move(live));
+    return Attachment(this, live_.back().id);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "CircularBuffer/CircularBuffer.h"
+#include "mib_grabber/BufferProducer.h"
+
+// Software stand-in for a CallbackMultiThread grabber, so the callback path
+// runs without a Coaxlink board. Replays the frames of a CircularBuffer at a
+// fixed rate into a small pool of buffers. Like the camera, a frame that
+// arrives while no buffer is queued is lost and counted as starved.
+class MockBufferProducer : public BufferProducer
+{
+public:
+    MockBufferProducer(const CircularBuffer &source, size_t imageSize, size_t bufferCount, double targetFps);
+    ~MockBufferProducer() override;
+
+    void start(FrameCallback onFrame) override;
+    void stop() override;
+    size_t bufferCount() const override { return bufferCount_.load(std::memory_order_relaxed); }
+    size_t imageSize() const override { return imageSize_; }
+    void announceExternal(uint8_t *base, size_t stride, size_t count, size_t queued) override;
+    void queueExternal(size_t index) override { requeue(index); }
+    void growPool(size_t count) override;
+    uint64_t starved() const { return starved_.load(std::memory_order_relaxed); }
+
+protected:
+    void requeue(size_t index) override;
+
+private:
+    void run();
+
+    const CircularBuffer &source_;
+    size_t imageSize_;
+    std::chrono::nanoseconds frameInterval_;
+    std::vector<std::vector<uint8_t>> ownBuffers_;
+    std::vector<uint8_t *> buffers_; // guarded by queueMutex_ once running
+    std::atomic<size_t> bufferCount_{0};
+    bool external_ = false;
+    std::deque<size_t> inputQueue_;
+    std::mutex queueMutex_;
+    FrameCallback onFrame_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> starved_{0};
+    std::thread thread_;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Maps raw camera levels to 8 bits: black and below -> 0, white and above
+// -> 255, linear in between. white 0 means the format's maximum, so the
+// default is a plain shift down to the top 8 bits.
+struct PixelNormalization
+{
+    uint16_t black = 0;
+    uint16_t white = 0;
+};
+
+// Converts frames in a camera pixel format to the 8-bit frames the pipeline
+// analyses, ring rows and ROI windows alike, in one pass over the raw data.
+// Mono8/10/12/14/16 and the packed Mono10p/12p/14p and GigE Vision
+// Mono10Packed/Mono12Packed have vectorised fast paths; any other format
+// needs a generic converter (FormatConverter) passed in.
+class PixelUnpacker
+{
+public:
+    // Whole raw frame in, whole 8-bit frame out
+    using GenericConvert = std::function<void(const uint8_t *raw, uint8_t *mono8)>;
+
+    // pixelFormat 0 is taken as Mono8 (frames that are 8-bit already)
+    PixelUnpacker(uint64_t pixelFormat, size_t width, size_t height,
+                  PixelNormalization normalization = PixelNormalization(), GenericConvert generic = nullptr);
+
+    static bool hasFastPath(uint64_t pixelFormat);
+    static std::string formatName(uint64_t pixelFormat);
+
+    uint64_t pixelFormat() const { return pixelFormat_; }
+    size_t width() const { return width_; }
+    size_t height() const { return height_; }
+    size_t bitsPerPixel() const { return bits_; }
+    size_t rawRowBytes() const { return rowBytes_; }
+    size_t rawSize() const { return rowBytes_ * height_; }
+    // 8-bit frames with nothing to remap: a plain copy does
+    bool passthrough() const { return passthrough_; }
+
+    // Whole frame into a width x height 8-bit image with rows dstStride apart
+    void unpack(const uint8_t *raw, uint8_t *dst, size_t dstStride) const;
+    // Only the pixels of a window (widened to whole packing groups); dst is
+    // still the whole 8-bit frame, other pixels are left as they were
+    void unpackRegion(const uint8_t *raw, uint8_t *dst, size_t dstStride,
+                      size_t x, size_t y, size_t cols, size_t rows) const;
+
+private:
+    enum class Layout
+    {
+        Bytes,       // Mono8
+        Words,       // Mono10/12/14/16 in 16-bit little-endian containers
+        PackedLsb,   // PFNC Mono10p/12p/14p: little-endian bit stream
+        PackedGvsp,  // GigE Vision Mono10Packed/Mono12Packed: 2 pixels in 3 bytes
+        Generic
+    };
+
+    void unpackRow(const uint8_t *rawRow, uint8_t *dstRow, size_t x, size_t cols) const;
+
+    uint64_t pixelFormat_;
+    size_t width_;
+    size_t height_;
+    Layout layout_ = Layout::Generic;
+    size_t bits_ = 8;
+    size_t groupPixels_ = 1;
+    size_t groupBytes_ = 1;
+    size_t rowBytes_ = 0;
+    bool passthrough_ = false;
+    // out = clamp(raw - black, 0, range) << shift, times scale / 65536
+    uint16_t black_ = 0;
+    uint16_t range_ = 255;
+    int shift_ = 0;
+    uint16_t scale_ = 0;
+    GenericConvert generic_;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+enum class ReplayMode
+{
+    Realtime, // frame k is due at start + k / targetFps
+    Unpaced,  // as fast as the pipeline takes frames, for throughput runs
+    Step,     // one frame per step() call
+};
+
+// What happens to frames that fell due while the pipeline was still busy
+enum class ReplayOverrun
+{
+    Queue,  // deliver them late, in order; beyond maxBacklog the oldest are dropped
+    Latest, // deliver only the newest, the rest are coalesced into it
+};
+
+struct ReplayOptions
+{
+    ReplayMode mode = ReplayMode::Realtime;
+    ReplayOverrun overrun = ReplayOverrun::Queue;
+    double targetFps = 5000.0;
+    size_t maxBacklog = 64; // like a camera buffer pool
+#ifdef _WIN32
+    std::chrono::microseconds spinWindow{2000}; // the default timer tick is far coarser than a frame
+#else
+    std::chrono::microseconds spinWindow{100};
+#endif
+};
+
+struct ReplayStats
+{
+    uint64_t delivered = 0;
+    uint64_t coalesced = 0;
+    uint64_t dropped = 0;
+    double meanLatenessUs = 0.0; // delivery time behind schedule, Realtime only
+    double maxLatenessUs = 0.0;
+};
+
+// Schedules the frame sequence of a replayed source. Every scheduled frame
+// index is accounted for exactly once as delivered, coalesced or dropped, and
+// delivered indices are strictly increasing, so a run at a given rate and
+// pipeline speed is reproducible. Waiting sleeps until spinWindow before the
+// deadline and spins the rest, instead of spinning the whole interval.
+class ReplayEngine
+{
+public:
+    explicit ReplayEngine(const ReplayOptions &options = ReplayOptions());
+
+    void start();
+    // Waits for the next frame and returns its schedule index. Returns false
+    // only in Step mode, when no step was requested within timeout.
+    bool next(uint64_t &index, std::chrono::milliseconds timeout = std::chrono::milliseconds(100));
+    void step(size_t frames = 1);
+    // The schedule stands still between pause() and resume(): frames due
+    // after the pause are due that much later. Same thread as next().
+    void pause();
+    void resume();
+
+    ReplayStats stats() const;
+    const ReplayOptions &options() const { return options_; }
+
+private:
+    void waitUntil(std::chrono::steady_clock::time_point deadline) const;
+
+    ReplayOptions options_;
+    std::chrono::nanoseconds interval_;
+    std::chrono::steady_clock::time_point origin_;
+    uint64_t nextIndex_ = 0;
+    bool paused_ = false;
+    std::chrono::steady_clock::time_point pausedAt_;
+
+    std::mutex stepMutex_;
+    std::condition_variable stepCondition_;
+    size_t pendingSteps_ = 0;
+
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> coalesced_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<double> totalLatenessUs_{0.0};
+    std::atomic<double> maxLatenessUs_{0.0};
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Where one role's threads run: the cores they may use and, optionally, a
+// real-time priority. An empty placement leaves a thread as the OS started it.
+struct ThreadPlacement
+{
+    std::vector<int> cores; // empty = any core
+    int priority = 0;       // 1-99 runs the thread SCHED_FIFO (time-critical on Windows); 0 = normal
+    bool empty() const { return cores.empty() && priority == 0; }
+};
+
+enum class ThreadRole
+{
+    Acquisition, // the dispatcher loop, or the grabber's callback threads
+    Trigger,
+    Processing,
+    Saver,
+    Display,
+    Metrics,
+};
+const char *threadRoleName(ThreadRole role);
+
+// A placement per role. Processing workers and the two trigger threads get
+// one core each, thread i on cores[i % cores.size()], so they do not migrate
+// between caches and spinning threads do not queue behind each other; every
+// other role may run on any of its cores.
+struct ThreadTopology
+{
+    ThreadPlacement acquisition;
+    ThreadPlacement trigger;
+    ThreadPlacement processing;
+    ThreadPlacement saver;
+    ThreadPlacement display;
+    ThreadPlacement metrics;
+    size_t processingThreads = 1; // workers over all cameras
+
+    const ThreadPlacement &placement(ThreadRole role) const;
+    // The placement the index-th thread of role is given
+    ThreadPlacement placementFor(ThreadRole role, size_t index) const;
+    // Threads started in role: the pulse loop and the process-trigger loop
+    // for Trigger, processingThreads for Processing, one otherwise
+    size_t threadCount(ThreadRole role) const;
+    bool empty() const;
+};
+
+// What a thread ended up with, read back from the OS after a placement
+struct AppliedPlacement
+{
+    std::vector<int> cores; // the thread's affinity
+    int priority = 0;       // real-time priority, 0 when scheduled normally
+    int currentCore = -1;
+    bool matches = false;   // cores and priority are what was asked for
+    std::string error;      // the first call that failed, if any
+};
+
+// Applies placement to the calling thread, then reads it back and compares
+AppliedPlacement applyThreadPlacement(const ThreadPlacement &placement);
+// Applies the placement of the index-th thread of role and logs what was
+// applied, with a warning when the OS did not grant it
+void placeCurrentThread(const ThreadTopology &topology, ThreadRole role, size_t index = 0);
+// Problems visible before any thread starts: cores this machine does not
+// have, real-time roles sharing a core with another role and real-time roles
+// with more threads than cores
+std::vector<std::string> checkThreadTopology(const ThreadTopology &topology, unsigned coreCount);
+void printThreadTopology(const ThreadTopology &topology);
+// NUMA node of a logical core, -1 when unknown
+int numaNodeOfCore(int core);
+std::string describeCores(const std::vector<int> &cores);
+
+// Starts fn(args...) on a new thread that first takes the placement of the
+// index-th thread of role
+template <typename Fn, typename... Args>
+std::thread placedThread(const ThreadTopology &topology, ThreadRole role, size_t index, Fn &&fn, Args &&...args)
+{
+    return std::thread([topology, role, index](auto &&fn, auto &&...args)
+                       {
+                           placeCurrentThread(topology, role, index);
+                           std::invoke(fn, args...); },
+                       std::forward<Fn>(fn), std::forward<Args>(args)...);
+}
+
+// Places the calling thread for the lifetime of this object and then puts
+// back the affinity and scheduling it had, for loops that run on a thread
+// borrowed from the caller
+class ScopedThreadPlacement
+{
+public:
+    ScopedThreadPlacement(const ThreadTopology &topology, ThreadRole role, size_t index = 0);
+    ~ScopedThreadPlacement();
+    ScopedThreadPlacement(const ScopedThreadPlacement &) = delete;
+    ScopedThreadPlacement &operator=(const ScopedThreadPlacement &) = delete;
+
+private:
+    bool placed_ = false;
+    std::vector<int> previousCores_;
+    int previousPolicy_ = 0;
+    int previousPriority_ = 0;
+};
+
+// Places threads the caller does not start, such as a grabber's callback
+// threads, on their first call to enter(); later calls cost one compare
+class CallbackThreadPlacement
+{
+public:
+    CallbackThreadPlacement(const ThreadTopology &topology, ThreadRole role);
+    void enter();
+
+private:
+    ThreadTopology topology_;
+    ThreadRole role_;
+    uint64_t id_;
+};
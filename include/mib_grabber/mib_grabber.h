@@ -2,6 +2,7 @@
 
 #include <EGrabber.h>
 #include "CircularBuffer/CircularBuffer.h"
+#include "CircularBuffer/FrameRing.h"
 #include "image_processing/image_processing.h"
 
 struct GrabberParams
@@ -17,7 +18,8 @@ struct GrabberParams
 void configure_js(std::string config_path);
 GrabberParams initializeGrabber(Euresys::EGrabber<Euresys::CallbackOnDemand> &grabber);
 void initializeBackgroundFrame(SharedResources &shared, const ImageParams &params);
-void temp_sample(Euresys::EGrabber<Euresys::CallbackOnDemand> &grabber, const ImageParams &params, CircularBuffer &circularBuffer, CircularBuffer &processingBuffer, SharedResources &shared);
-void hybrid_sample(Euresys::EGrabber<Euresys::CallbackOnDemand> &grabber, const ImageParams &params, CircularBuffer &cameraBuffer, CircularBuffer &circularBuffer, CircularBuffer &processingBuffer, SharedResources &shared);
+void temp_sample(Euresys::EGrabber<Euresys::CallbackOnDemand> &grabber, const ImageParams &params, FrameRing &frameRing, SharedResources &shared);
+void hybrid_sample(Euresys::EGrabber<Euresys::CallbackOnDemand> &grabber, const ImageParams &params, FrameSource &source, FrameRing &frameRing, SharedResources &shared);
+void runCallbackSample(const Euresys::EGrabberCameraInfo &camera, const json &config);
 void runHybridSample();
 int mib_grabber_main();
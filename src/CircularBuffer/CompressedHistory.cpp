@@ -0,0 +1,219 @@
+#include "CircularBuffer/CompressedHistory.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    const size_t BLOCK_SIZE = 16;
+
+    enum BlockMode : uint8_t
+    {
+        ZERO_BLOCK = 0,
+        TWO_BIT_BLOCK = 1,  // deltas in [-2, 1]
+        FOUR_BIT_BLOCK = 2, // deltas in [-8, 7]
+        RAW_BLOCK = 3,
+    };
+
+    size_t modeBytes(size_t blocks) { return (blocks + 3) / 4; }
+}
+
+CompressedHistory::CompressedHistory(size_t byteBudget, size_t imageSize)
+    : imageSize_(imageSize), arena_(byteBudget), scratch_(maxEncodedSize(imageSize))
+{
+    if (imageSize == 0 || byteBudget < maxEncodedSize(imageSize))
+        throw std::invalid_argument("CompressedHistory budget must hold at least one uncompressed frame");
+}
+
+size_t CompressedHistory::maxEncodedSize(size_t imageSize)
+{
+    size_t blocks = imageSize / BLOCK_SIZE;
+    return modeBytes(blocks) + imageSize;
+}
+
+size_t CompressedHistory::encode(const uint8_t *frame, const uint8_t *background, size_t imageSize, uint8_t *output)
+{
+    size_t blocks = imageSize / BLOCK_SIZE;
+    uint8_t *modes = output;
+    uint8_t *payload = output + modeBytes(blocks);
+    std::memset(modes, 0, modeBytes(blocks));
+
+    for (size_t b = 0; b < blocks; ++b)
+    {
+        const uint8_t *pixels = frame + b * BLOCK_SIZE;
+        const uint8_t *reference = background + b * BLOCK_SIZE;
+        // Unsigned reductions over the biased deltas vectorise cleanly
+        uint8_t delta[BLOCK_SIZE];
+        uint8_t any = 0, range2 = 0, range4 = 0;
+        for (size_t i = 0; i < BLOCK_SIZE; ++i)
+        {
+            delta[i] = static_cast<uint8_t>(pixels[i] - reference[i]);
+            any |= delta[i];
+            range2 = std::max(range2, static_cast<uint8_t>(delta[i] + 2));
+            range4 = std::max(range4, static_cast<uint8_t>(delta[i] + 8));
+        }
+
+        uint8_t mode;
+        if (any == 0)
+        {
+            mode = ZERO_BLOCK;
+        }
+        else if (range2 < 4)
+        {
+            mode = TWO_BIT_BLOCK;
+            for (size_t i = 0; i < BLOCK_SIZE / 4; ++i)
+            {
+                payload[i] = static_cast<uint8_t>(((delta[4 * i] + 2) & 3) | (((delta[4 * i + 1] + 2) & 3) << 2) |
+                                                  (((delta[4 * i + 2] + 2) & 3) << 4) | (((delta[4 * i + 3] + 2) & 3) << 6));
+            }
+            payload += BLOCK_SIZE / 4;
+        }
+        else if (range4 < 16)
+        {
+            mode = FOUR_BIT_BLOCK;
+            for (size_t i = 0; i < BLOCK_SIZE / 2; ++i)
+                payload[i] = static_cast<uint8_t>(((delta[2 * i] + 8) & 15) | (((delta[2 * i + 1] + 8) & 15) << 4));
+            payload += BLOCK_SIZE / 2;
+        }
+        else
+        {
+            mode = RAW_BLOCK;
+            std::memcpy(payload, delta, BLOCK_SIZE);
+            payload += BLOCK_SIZE;
+        }
+        modes[b / 4] |= static_cast<uint8_t>(mode << (2 * (b % 4)));
+    }
+
+    // Trailing bytes that do not fill a block are stored as raw deltas
+    for (size_t i = blocks * BLOCK_SIZE; i < imageSize; ++i)
+        *payload++ = static_cast<uint8_t>(frame[i] - background[i]);
+
+    return static_cast<size_t>(payload - output);
+}
+
+void CompressedHistory::decode(const uint8_t *encoded, const uint8_t *background, size_t imageSize, uint8_t *output)
+{
+    size_t blocks = imageSize / BLOCK_SIZE;
+    const uint8_t *modes = encoded;
+    const uint8_t *payload = encoded + modeBytes(blocks);
+
+    for (size_t b = 0; b < blocks; ++b)
+    {
+        const uint8_t *reference = background + b * BLOCK_SIZE;
+        uint8_t *pixels = output + b * BLOCK_SIZE;
+        switch ((modes[b / 4] >> (2 * (b % 4))) & 3)
+        {
+        case ZERO_BLOCK:
+            std::memcpy(pixels, reference, BLOCK_SIZE);
+            break;
+        case TWO_BIT_BLOCK:
+            for (size_t i = 0; i < BLOCK_SIZE; ++i)
+                pixels[i] = static_cast<uint8_t>(reference[i] + ((payload[i / 4] >> (2 * (i % 4))) & 3) - 2);
+            payload += BLOCK_SIZE / 4;
+            break;
+        case FOUR_BIT_BLOCK:
+            for (size_t i = 0; i < BLOCK_SIZE; ++i)
+                pixels[i] = static_cast<uint8_t>(reference[i] + ((payload[i / 2] >> (4 * (i % 2))) & 15) - 8);
+            payload += BLOCK_SIZE / 2;
+            break;
+        default:
+            for (size_t i = 0; i < BLOCK_SIZE; ++i)
+                pixels[i] = static_cast<uint8_t>(reference[i] + payload[i]);
+            payload += BLOCK_SIZE;
+            break;
+        }
+    }
+
+    for (size_t i = blocks * BLOCK_SIZE; i < imageSize; ++i)
+        output[i] = static_cast<uint8_t>(background[i] + *payload++);
+}
+
+void CompressedHistory::setBackground(const uint8_t *background)
+{
+    auto copy = std::make_shared<const std::vector<uint8_t>>(background, background + imageSize_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    background_ = std::move(copy);
+}
+
+bool CompressedHistory::hasBackground() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return background_ != nullptr;
+}
+
+size_t CompressedHistory::push(const uint8_t *frame, const FrameMeta &meta)
+{
+    // Single writer: scratch_ is only touched here, so encode outside the lock
+    std::shared_ptr<const std::vector<uint8_t>> background;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        background = background_;
+    }
+    if (!background)
+        return 0;
+    size_t length = encode(frame, background->data(), imageSize_, scratch_.data());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (writeOffset_ + length > arena_.size())
+    {
+        // Wrap: whatever is left past the write offset is from the previous lap
+        evictOverlapping(writeOffset_, arena_.size());
+        writeOffset_ = 0;
+    }
+    evictOverlapping(writeOffset_, writeOffset_ + length);
+    std::memcpy(arena_.data() + writeOffset_, scratch_.data(), length);
+    entries_.push_back(Entry{writeOffset_, length, meta, std::move(background)});
+    writeOffset_ += length;
+    bytesUsed_ += length;
+    return length;
+}
+
+void CompressedHistory::evictOverlapping(size_t start, size_t end)
+{
+    // Entries older than the write offset sit at or after it, in order
+    while (!entries_.empty() && entries_.front().offset >= start && entries_.front().offset < end)
+    {
+        bytesUsed_ -= entries_.front().length;
+        entries_.pop_front();
+    }
+}
+
+void CompressedHistory::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    writeOffset_ = 0;
+    bytesUsed_ = 0;
+}
+
+bool CompressedHistory::decode(size_t index, uint8_t *destination, FrameMeta *meta) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index >= entries_.size())
+        return false;
+    const Entry &entry = entries_[entries_.size() - 1 - index];
+    decode(arena_.data() + entry.offset, entry.background->data(), imageSize_, destination);
+    if (meta != nullptr)
+        *meta = entry.meta;
+    return true;
+}
+
+size_t CompressedHistory::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+size_t CompressedHistory::bytesUsed() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytesUsed_;
+}
+
+double CompressedHistory::compressionRatio() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (bytesUsed_ == 0)
+        return 0.0;
+    return static_cast<double>(entries_.size() * imageSize_) / bytesUsed_;
+}
@@ -0,0 +1,376 @@
+#include "CircularBuffer/FrameRing.h"
+#include <algorithm>
+#include <cstring>
+
+FrameRing::FrameRing(size_t size, size_t imageSize, const FrameStorageOptions &storageOptions)
+    : storage_(size, imageSize, storageOptions),
+      slots_(size), metas_(size), size_(size), imageSize_(imageSize), startedAt_(std::chrono::steady_clock::now())
+{
+}
+
+bool FrameRing::push(const uint8_t *data, const FrameMeta &meta)
+{
+    return pushWith(meta, [this, data](uint8_t *slot)
+                    { std::memcpy(slot, data, imageSize_); });
+}
+
+uint8_t *FrameRing::beginPush(uint64_t &sequence)
+{
+    if (acquisition_)
+        throw std::logic_error("FrameRing slots are filled by the grabber; use commit()");
+    sequence = head_.load(std::memory_order_relaxed) + 1;
+    SlotState &slot = slots_[slotOf(sequence)];
+
+    // A pinned consumer that has not reached the frame we would evict wins
+    if (sequence > size_ && evictionBlocked(sequence - size_))
+    {
+        consumerDrops_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // Mark the slot as being written before touching the pixels. The stamp
+    // store and the pin check are both seq_cst so that a concurrent lease()
+    // either sees the odd stamp or the writer sees its pin.
+    uint64_t previousStamp = slot.stamp.load(std::memory_order_relaxed);
+    slot.stamp.store(2 * sequence - 1, std::memory_order_seq_cst);
+    if (slot.pins.load(std::memory_order_seq_cst) != 0)
+    {
+        slot.stamp.store(previousStamp, std::memory_order_release);
+        pinnedDrops_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return storage_.slot(slotOf(sequence));
+}
+
+void FrameRing::endPush(uint64_t sequence, const FrameMeta &meta)
+{
+    SlotState &slot = slots_[slotOf(sequence)];
+    FrameMeta &slotMeta = metas_[slotOf(sequence)];
+    slotMeta = meta;
+    slotMeta.sequence = sequence;
+    if (slotMeta.hostSteadyUs == 0)
+        slotMeta.hostSteadyUs = steadyNowUs();
+    if (slotMeta.hostWallUs == 0)
+        slotMeta.hostWallUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                                  std::chrono::system_clock::now().time_since_epoch())
+                                  .count();
+
+    slot.stamp.store(2 * sequence, std::memory_order_release);
+    head_.store(sequence, std::memory_order_release);
+    if (sequence == 1)
+    {
+        storage_.noteFirstWrite(storage_.slot(slotOf(sequence)));
+        firstFrameMs_.store(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startedAt_).count(),
+                            std::memory_order_release);
+    }
+}
+
+void FrameRing::attachAcquisition(size_t queueDepth, std::function<void(size_t slot)> requeue)
+{
+    if (queueDepth == 0 || queueDepth >= size_)
+        throw std::invalid_argument("Acquisition queue depth must be between 1 and the ring size - 1");
+    acquisition_ = std::make_unique<AcquisitionState>(size_);
+    acquisition_->queueDepth = queueDepth;
+    acquisition_->nextUnqueuedSlot = queueDepth;
+    acquisition_->requeue = std::move(requeue);
+    reclaimedUpTo_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    queuedSlots_.store(queueDepth, std::memory_order_release);
+}
+
+bool FrameRing::commit(size_t slotIndex, const FrameMeta &meta)
+{
+    if (!acquisition_ || slotIndex >= size_)
+        return false;
+    uint64_t sequence = head_.load(std::memory_order_relaxed) + 1;
+    SlotState &slot = slots_[slotIndex];
+
+    // The grabber has already written the pixels; only the metadata and the
+    // stamp are published here, in the same order as push()
+    FrameMeta &slotMeta = metas_[slotIndex];
+    slotMeta = meta;
+    slotMeta.sequence = sequence;
+    if (slotMeta.hostSteadyUs == 0)
+        slotMeta.hostSteadyUs = steadyNowUs();
+    if (slotMeta.hostWallUs == 0)
+        slotMeta.hostWallUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                                  std::chrono::system_clock::now().time_since_epoch())
+                                  .count();
+    acquisition_->sequenceSlots[(sequence - 1) % size_].store(slotIndex, std::memory_order_release);
+    slot.stamp.store(2 * sequence, std::memory_order_release);
+    head_.store(sequence, std::memory_order_release);
+    queuedSlots_.fetch_sub(1, std::memory_order_relaxed);
+    if (sequence == 1)
+    {
+        storage_.noteFirstWrite(storage_.slot(slotIndex));
+        firstFrameMs_.store(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startedAt_).count(),
+                            std::memory_order_release);
+    }
+
+    reclaim(true);
+    return true;
+}
+
+void FrameRing::reclaim(bool wait) const
+{
+    // Called after every commit and whenever a reader lets go of a frame that
+    // may have been holding the queue back
+    std::unique_lock<std::mutex> lock(acquisition_->reclaimMutex, std::defer_lock);
+    if (wait)
+        lock.lock();
+    else if (!lock.try_lock())
+        return;
+
+    uint64_t head = head_.load(std::memory_order_acquire);
+    while (queuedSlots_.load(std::memory_order_relaxed) < acquisition_->queueDepth)
+    {
+        // Slots that never held a frame go first, until the whole ring is in use
+        if (acquisition_->nextUnqueuedSlot < size_)
+        {
+            queuedSlots_.fetch_add(1, std::memory_order_relaxed);
+            acquisition_->requeue(acquisition_->nextUnqueuedSlot++);
+            continue;
+        }
+
+        uint64_t sequence = reclaimedUpTo_.load(std::memory_order_relaxed) + 1;
+        if (sequence > head || evictionBlocked(sequence))
+            break;
+
+        // Same handshake as push(): mark the slot as being written, then
+        // back off if a lease got in first
+        size_t slotIndex = slotOf(sequence);
+        SlotState &slot = slots_[slotIndex];
+        slot.stamp.store(2 * sequence - 1, std::memory_order_seq_cst);
+        if (slot.pins.load(std::memory_order_seq_cst) != 0)
+        {
+            slot.stamp.store(2 * sequence, std::memory_order_release);
+            requeueStalls_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+
+        reclaimedUpTo_.store(sequence, std::memory_order_release);
+        queuedSlots_.fetch_add(1, std::memory_order_relaxed);
+        acquisition_->requeue(slotIndex);
+    }
+}
+
+void FrameRing::releasePin(size_t slot) const
+{
+    slots_[slot].pins.fetch_sub(1, std::memory_order_release);
+    if (acquisition_)
+        reclaim(false);
+}
+
+void FrameRing::clear()
+{
+    clearedAt_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+const uint8_t *FrameRing::getPointer(size_t index) const
+{
+    if (index >= size())
+        throw std::out_of_range("Index out of range");
+    uint64_t sequence = head_.load(std::memory_order_acquire) - index;
+    return storage_.slot(slotOf(sequence));
+}
+
+bool FrameRing::read(size_t index, uint8_t *destination, FrameMeta *meta) const
+{
+    uint64_t head = head_.load(std::memory_order_acquire);
+    if (index >= size())
+        return false;
+    return readSequence(head - index, destination, meta);
+}
+
+bool FrameRing::readSequence(uint64_t sequence, uint8_t *destination, FrameMeta *meta) const
+{
+    uint64_t head = head_.load(std::memory_order_acquire);
+    if (sequence == 0 || sequence > head || sequence <= clearedAt_.load(std::memory_order_acquire) ||
+        sequence <= reclaimedUpTo_.load(std::memory_order_acquire) || head - sequence >= size_)
+        return false;
+
+    const SlotState &slot = slots_[slotOf(sequence)];
+    uint64_t before = slot.stamp.load(std::memory_order_acquire);
+    if (before != 2 * sequence)
+    {
+        // Already overwritten (or being overwritten) by a newer frame
+        tornReads_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    std::memcpy(destination, storage_.slot(slotOf(sequence)), imageSize_);
+    FrameMeta metaCopy = metas_[slotOf(sequence)];
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = slot.stamp.load(std::memory_order_relaxed);
+    if (after != before)
+    {
+        tornReads_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (meta != nullptr)
+        *meta = metaCopy;
+    return true;
+}
+
+FrameLease FrameRing::lease(size_t index) const
+{
+    uint64_t head = head_.load(std::memory_order_acquire);
+    if (index >= size())
+        return FrameLease();
+    return leaseSequence(head - index);
+}
+
+FrameLease FrameRing::leaseSequence(uint64_t sequence) const
+{
+    uint64_t head = head_.load(std::memory_order_acquire);
+    if (sequence == 0 || sequence > head || sequence <= clearedAt_.load(std::memory_order_acquire) ||
+        sequence <= reclaimedUpTo_.load(std::memory_order_acquire) || head - sequence >= size_)
+        return FrameLease();
+
+    size_t slotIndex = slotOf(sequence);
+    const SlotState &slot = slots_[slotIndex];
+    slot.pins.fetch_add(1, std::memory_order_seq_cst);
+    if (slot.stamp.load(std::memory_order_seq_cst) != 2 * sequence)
+    {
+        slot.pins.fetch_sub(1, std::memory_order_release);
+        tornReads_.fetch_add(1, std::memory_order_relaxed);
+        return FrameLease();
+    }
+    return FrameLease(this, slotIndex, storage_.slot(slotIndex), &metas_[slotIndex], sequence);
+}
+
+size_t FrameRing::registerConsumer(const std::string &name, ConsumerMode mode)
+{
+    size_t id = consumerCount_.load(std::memory_order_relaxed);
+    if (id >= MAX_CONSUMERS)
+        throw std::length_error("Too many FrameRing consumers");
+    ConsumerState &consumer = consumers_[id];
+    consumer.name = name;
+    consumer.mode = mode;
+    consumer.cursor.store(head_.load(std::memory_order_acquire), std::memory_order_relaxed);
+    consumer.skipped.store(0, std::memory_order_relaxed);
+    consumerCount_.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+bool FrameRing::evictionBlocked(uint64_t evictedSequence) const
+{
+    size_t count = consumerCount_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (consumers_[i].mode == ConsumerMode::Pinned &&
+            consumers_[i].cursor.load(std::memory_order_acquire) < evictedSequence)
+            return true;
+    }
+    return false;
+}
+
+FrameLease FrameRing::next(size_t consumer)
+{
+    ConsumerState &state = consumers_.at(consumer);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t sequence = state.cursor.load(std::memory_order_relaxed) + 1;
+    if (sequence > head)
+        return FrameLease();
+
+    // Lossy consumers that were lapped resume at the oldest frame still held
+    uint64_t oldest = std::max<uint64_t>(head > size_ ? head - size_ + 1 : 1,
+                                         reclaimedUpTo_.load(std::memory_order_acquire) + 1);
+    if (sequence < oldest)
+    {
+        state.skipped.fetch_add(oldest - sequence, std::memory_order_relaxed);
+        sequence = oldest;
+    }
+
+    FrameLease lease = leaseSequence(sequence);
+    if (!lease)
+        state.skipped.fetch_add(1, std::memory_order_relaxed);
+    state.cursor.store(sequence, std::memory_order_release);
+    if (acquisition_ && state.mode == ConsumerMode::Pinned)
+        reclaim(false);
+    return lease;
+}
+
+FrameLease FrameRing::latest(size_t consumer)
+{
+    ConsumerState &state = consumers_.at(consumer);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t cursor = state.cursor.load(std::memory_order_relaxed);
+    if (head <= cursor)
+        return FrameLease();
+
+    FrameLease lease = leaseSequence(head);
+    if (!lease)
+        return FrameLease();
+    state.skipped.fetch_add(head - cursor - 1, std::memory_order_relaxed);
+    state.cursor.store(head, std::memory_order_release);
+    return lease;
+}
+
+FrameLease FrameRing::take(size_t consumer, uint64_t sequence)
+{
+    ConsumerState &state = consumers_.at(consumer);
+    uint64_t cursor = state.cursor.load(std::memory_order_relaxed);
+    FrameLease lease = leaseSequence(sequence);
+    if (sequence > cursor)
+    {
+        state.skipped.fetch_add(sequence - cursor - (lease ? 1 : 0), std::memory_order_relaxed);
+        state.cursor.store(sequence, std::memory_order_release);
+        if (acquisition_ && state.mode == ConsumerMode::Pinned)
+            reclaim(false);
+    }
+    return lease;
+}
+
+ConsumerStats FrameRing::consumerStats(size_t consumer) const
+{
+    const ConsumerState &state = consumers_.at(consumer);
+    uint64_t cursor = state.cursor.load(std::memory_order_acquire);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    return ConsumerStats{state.name, state.mode, cursor, head > cursor ? head - cursor : 0,
+                         state.skipped.load(std::memory_order_relaxed)};
+}
+
+FrameLease::FrameLease(FrameLease &&other) noexcept
+    : ring_(other.ring_), slot_(other.slot_), data_(other.data_), meta_(other.meta_), sequence_(other.sequence_)
+{
+    other.ring_ = nullptr;
+    other.data_ = nullptr;
+}
+
+FrameLease &FrameLease::operator=(FrameLease &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        ring_ = other.ring_;
+        slot_ = other.slot_;
+        data_ = other.data_;
+        meta_ = other.meta_;
+        sequence_ = other.sequence_;
+        other.ring_ = nullptr;
+        other.data_ = nullptr;
+    }
+    return *this;
+}
+
+void FrameLease::release()
+{
+    if (ring_ != nullptr)
+    {
+        ring_->releasePin(slot_);
+        ring_ = nullptr;
+        data_ = nullptr;
+    }
+}
+
+uint64_t FrameRing::latestSequence() const { return head_.load(std::memory_order_acquire); }
+
+size_t FrameRing::size() const
+{
+    uint64_t hiddenUpTo = std::max(clearedAt_.load(std::memory_order_acquire), reclaimedUpTo_.load(std::memory_order_acquire));
+    uint64_t available = head_.load(std::memory_order_acquire) - hiddenUpTo;
+    return static_cast<size_t>(std::min<uint64_t>(available, size_));
+}
+
+bool FrameRing::isFull() const { return size() == size_; }
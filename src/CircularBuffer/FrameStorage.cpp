@@ -0,0 +1,351 @@
+#include "CircularBuffer/FrameStorage.h"
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace
+{
+    size_t roundUp(size_t value, size_t multiple)
+    {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    size_t systemPageSize()
+    {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwPageSize;
+#else
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+
+    // Faults a page in for writing without changing its contents, so it is
+    // safe even if the acquisition thread is already filling that slot.
+    void touchPage(uint8_t *page)
+    {
+        reinterpret_cast<std::atomic<uint32_t> *>(page)->fetch_add(0, std::memory_order_relaxed);
+    }
+}
+
+FrameStorage::FrameStorage(size_t slotCount, size_t slotSize, const FrameStorageOptions &options)
+    : options_(options)
+{
+    if (slotCount == 0 || slotSize == 0)
+        throw std::invalid_argument("FrameStorage requires a non-zero slot count and slot size");
+    if (options_.alignment < 64 || (options_.alignment & (options_.alignment - 1)) != 0)
+        throw std::invalid_argument("FrameStorage alignment must be a power of two of at least 64");
+
+    stride_ = roundUp(slotSize, options_.alignment);
+    bytes_ = stride_ * slotCount;
+
+    auto start = std::chrono::steady_clock::now();
+    if (fileBacked())
+        mapFile();
+    else
+        allocate();
+    allocationMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (fileBacked())
+    {
+        // Prefaulting or locking would pull the whole history into RAM, which
+        // is what the file is there to avoid
+        writebackThread_ = std::thread(&FrameStorage::writeback, this);
+    }
+    else if (options_.prefaultInBackground)
+    {
+        prefaultThread_ = std::thread(&FrameStorage::prefault, this);
+    }
+    else if (options_.lockMemory)
+    {
+        // Locking faults everything in, which is exactly the startup cost we
+        // otherwise move off the critical path
+        prefault();
+    }
+}
+
+FrameStorage::~FrameStorage()
+{
+    stopPrefault_ = true;
+    if (prefaultThread_.joinable())
+        prefaultThread_.join();
+    {
+        std::lock_guard<std::mutex> lock(writebackMutex_);
+        stopWriteback_ = true;
+    }
+    writebackCondition_.notify_all();
+    if (writebackThread_.joinable())
+        writebackThread_.join();
+    release();
+}
+
+void FrameStorage::waitForPrefault()
+{
+    if (prefaultThread_.joinable())
+        prefaultThread_.join();
+}
+
+void FrameStorage::allocate()
+{
+    void *memory = nullptr;
+#ifdef _WIN32
+    auto commit = [this](DWORD flags) -> void *
+    {
+        if (options_.numaNode >= 0)
+            return VirtualAllocExNuma(GetCurrentProcess(), nullptr, mappedBytes_, flags, PAGE_READWRITE,
+                                      static_cast<DWORD>(options_.numaNode));
+        return VirtualAlloc(nullptr, mappedBytes_, flags, PAGE_READWRITE);
+    };
+    if (options_.hugePages == HugePageMode::Explicit)
+    {
+        // Requires SeLockMemoryPrivilege; silently falls back when missing
+        SIZE_T largePage = GetLargePageMinimum();
+        if (largePage != 0)
+        {
+            mappedBytes_ = roundUp(bytes_, largePage);
+            memory = commit(MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES);
+            hugePages_ = memory != nullptr;
+        }
+    }
+    if (memory == nullptr)
+    {
+        mappedBytes_ = roundUp(bytes_, systemPageSize());
+        memory = commit(MEM_RESERVE | MEM_COMMIT);
+    }
+    if (memory == nullptr)
+        throw std::bad_alloc();
+#else
+#ifdef MAP_HUGETLB
+    if (options_.hugePages == HugePageMode::Explicit)
+    {
+        const size_t hugePageSize = 2 * 1024 * 1024;
+        mappedBytes_ = roundUp(bytes_, hugePageSize);
+        memory = mmap(nullptr, mappedBytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory == MAP_FAILED)
+            memory = nullptr;
+        hugePages_ = memory != nullptr;
+    }
+#endif
+    if (memory == nullptr)
+    {
+        mappedBytes_ = roundUp(bytes_, systemPageSize());
+        memory = mmap(nullptr, mappedBytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+            throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+        if (options_.hugePages != HugePageMode::Off)
+            hugePages_ = madvise(memory, mappedBytes_, MADV_HUGEPAGE) == 0;
+#endif
+    }
+#endif
+    if (options_.hugePages == HugePageMode::Explicit && !hugePages_)
+        std::cerr << "Huge pages unavailable for frame storage, using normal pages" << std::endl;
+    base_ = static_cast<uint8_t *>(memory);
+    bindToNode();
+}
+
+void FrameStorage::bindToNode()
+{
+    // Windows allocates on the node directly; here the policy is set before
+    // anything faults a page in
+#if defined(__linux__) && defined(SYS_mbind)
+    if (options_.numaNode < 0)
+        return;
+    const size_t bitsPerWord = sizeof(unsigned long) * CHAR_BIT;
+    const size_t node = static_cast<size_t>(options_.numaNode);
+    std::vector<unsigned long> nodeMask(node / bitsPerWord + 1, 0);
+    nodeMask[node / bitsPerWord] |= 1UL << (node % bitsPerWord);
+    // Preferred rather than bound: a full node spills over instead of
+    // failing a page fault in the acquisition loop
+    if (syscall(SYS_mbind, base_, mappedBytes_, MPOL_PREFERRED, nodeMask.data(),
+                nodeMask.size() * bitsPerWord + 1, 0) != 0)
+        std::cerr << "Could not bind frame storage to NUMA node " << node << ": " << std::strerror(errno) << std::endl;
+#endif
+}
+
+void FrameStorage::noteFirstWrite(const uint8_t *slot)
+{
+    // Otherwise prefault() checks once every page is in
+    if (!prefaultEnabled())
+        checkNode(slot);
+}
+
+void FrameStorage::checkNode(const uint8_t *page)
+{
+    if (options_.numaNode < 0)
+        return;
+    int node = -1;
+#ifdef _WIN32
+    PSAPI_WORKING_SET_EX_INFORMATION info{};
+    info.VirtualAddress = const_cast<uint8_t *>(page);
+    if (QueryWorkingSetEx(GetCurrentProcess(), &info, sizeof(info)) && info.VirtualAttributes.Valid)
+        node = static_cast<int>(info.VirtualAttributes.Node);
+#elif defined(__linux__) && defined(SYS_get_mempolicy)
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0, page, MPOL_F_NODE | MPOL_F_ADDR) != 0)
+        node = -1;
+#endif
+    residentNode_ = node;
+    if (node == options_.numaNode)
+        std::cout << "Frame storage on NUMA node " << node << std::endl;
+    else
+        std::cerr << "Frame storage asked for NUMA node " << options_.numaNode << " but is on node " << node << std::endl;
+}
+
+void FrameStorage::mapFile()
+{
+    mappedBytes_ = roundUp(bytes_, systemPageSize());
+    const std::string &path = options_.backingFile;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Could not open frame history file: " + path);
+    fileHandle_ = file;
+
+    // Creating the mapping with an explicit size extends the file to it
+    ULARGE_INTEGER size;
+    size.QuadPart = mappedBytes_;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, size.HighPart, size.LowPart, nullptr);
+    if (mapping == nullptr)
+    {
+        release();
+        throw std::runtime_error("Could not size frame history file: " + path);
+    }
+    mappingHandle_ = mapping;
+
+    base_ = static_cast<uint8_t *>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, mappedBytes_));
+    if (base_ == nullptr)
+    {
+        release();
+        throw std::runtime_error("Could not map frame history file: " + path);
+    }
+#else
+    fileDescriptor_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fileDescriptor_ < 0)
+        throw std::runtime_error("Could not open frame history file: " + path);
+
+    // Reserve the blocks up front: running out of disk halfway through a
+    // session would otherwise surface as SIGBUS on the acquisition thread
+    if (ftruncate(fileDescriptor_, static_cast<off_t>(mappedBytes_)) != 0 ||
+        posix_fallocate(fileDescriptor_, 0, static_cast<off_t>(mappedBytes_)) != 0)
+    {
+        release();
+        throw std::runtime_error("Could not preallocate frame history file: " + path);
+    }
+
+    void *memory = mmap(nullptr, mappedBytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor_, 0);
+    if (memory == MAP_FAILED)
+    {
+        release();
+        throw std::runtime_error("Could not map frame history file: " + path);
+    }
+    base_ = static_cast<uint8_t *>(memory);
+#endif
+    std::cout << "Frame history mapped from " << path << " (" << (mappedBytes_ >> 20) << " MB)" << std::endl;
+}
+
+void FrameStorage::release()
+{
+#ifdef _WIN32
+    if (base_ != nullptr)
+    {
+        if (locked_)
+            VirtualUnlock(base_, mappedBytes_);
+        if (mappingHandle_ != nullptr)
+            UnmapViewOfFile(base_);
+        else
+            VirtualFree(base_, 0, MEM_RELEASE);
+    }
+    if (mappingHandle_ != nullptr)
+        CloseHandle(mappingHandle_);
+    if (fileHandle_ != nullptr)
+        CloseHandle(fileHandle_);
+    mappingHandle_ = nullptr;
+    fileHandle_ = nullptr;
+#else
+    if (base_ != nullptr)
+        munmap(base_, mappedBytes_);
+    if (fileDescriptor_ >= 0)
+        close(fileDescriptor_);
+    fileDescriptor_ = -1;
+#endif
+    base_ = nullptr;
+}
+
+void FrameStorage::writeback()
+{
+    // Start writeout of dirty history pages on a fixed period. Left alone,
+    // dirty pages pile up until the kernel throttles whichever thread is
+    // dirtying them, which here is the acquisition thread.
+    const auto interval = std::chrono::milliseconds(options_.writebackIntervalMs);
+    std::unique_lock<std::mutex> lock(writebackMutex_);
+    while (!writebackCondition_.wait_for(lock, interval, [this]
+                                         { return stopWriteback_; }))
+    {
+#ifdef _WIN32
+        FlushViewOfFile(base_, 0);
+#elif defined(SYNC_FILE_RANGE_WRITE)
+        sync_file_range(fileDescriptor_, 0, 0, SYNC_FILE_RANGE_WRITE);
+#else
+        msync(base_, mappedBytes_, MS_ASYNC);
+#endif
+    }
+}
+
+void FrameStorage::prefault()
+{
+    auto start = std::chrono::steady_clock::now();
+    bool populated = false;
+#if !defined(_WIN32) && defined(MADV_POPULATE_WRITE)
+    populated = madvise(base_, mappedBytes_, MADV_POPULATE_WRITE) == 0;
+#endif
+    if (!populated)
+    {
+        const size_t page = systemPageSize();
+        for (size_t offset = 0; offset < mappedBytes_; offset += page)
+        {
+            if (stopPrefault_.load(std::memory_order_relaxed))
+                return;
+            touchPage(base_ + offset);
+        }
+    }
+
+    if (options_.lockMemory)
+    {
+#ifdef _WIN32
+        SIZE_T minimum = 0, maximum = 0;
+        HANDLE process = GetCurrentProcess();
+        if (GetProcessWorkingSetSize(process, &minimum, &maximum))
+            SetProcessWorkingSetSize(process, minimum + mappedBytes_, maximum + mappedBytes_);
+        locked_ = VirtualLock(base_, mappedBytes_) != 0;
+#else
+        locked_ = mlock(base_, mappedBytes_) == 0;
+#endif
+        if (!locked_)
+            std::cerr << "Could not lock frame storage in memory" << std::endl;
+    }
+
+    checkNode(base_);
+    prefaultMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    prefaulted_ = true;
+}
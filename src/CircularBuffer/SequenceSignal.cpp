@@ -0,0 +1,135 @@
+#include "CircularBuffer/SequenceSignal.h"
+#include <climits>
+#include <thread>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    inline void cpuRelax()
+    {
+#if defined(_M_X64) || defined(_M_IX86)
+        YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    // Sleeps while *word still holds expected, up to timeout; returns early
+    // on a wake-up, a changed word or spuriously
+    void parkOn(std::atomic<uint32_t> &word, uint32_t expected, std::chrono::microseconds timeout)
+    {
+#ifdef _WIN32
+        DWORD milliseconds = static_cast<DWORD>((timeout.count() + 999) / 1000);
+        WaitOnAddress(&word, &expected, sizeof(expected), milliseconds);
+#else
+        timespec relative;
+        relative.tv_sec = static_cast<time_t>(timeout.count() / 1000000);
+        relative.tv_nsec = static_cast<long>(timeout.count() % 1000000 * 1000);
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, &relative, nullptr, 0);
+#endif
+    }
+
+    void wakeAllOn(std::atomic<uint32_t> &word)
+    {
+#ifdef _WIN32
+        WakeByAddressAll(&word);
+#else
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+    }
+}
+
+void SequenceSignal::publish(uint64_t sequence)
+{
+    uint64_t current = sequence_.load(std::memory_order_relaxed);
+    while (current < sequence &&
+           !sequence_.compare_exchange_weak(current, sequence, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+    published_.fetch_add(1, std::memory_order_relaxed);
+    wake();
+}
+
+void SequenceSignal::wakeAll()
+{
+    wake();
+}
+
+void SequenceSignal::wake()
+{
+    word_.fetch_add(1, std::memory_order_release);
+    // Pairs with the fence in waitPast: either the waiter sees the new
+    // sequence before parking, or this sees it parked
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked_.load(std::memory_order_relaxed) == 0)
+        return;
+    wakeCalls_.fetch_add(1, std::memory_order_relaxed);
+    wakeAllOn(word_);
+}
+
+uint64_t SequenceSignal::waitPast(uint64_t seen, std::chrono::microseconds timeout)
+{
+    uint64_t sequence = load();
+    for (uint32_t i = 0; i < spinIterations_ && sequence <= seen; ++i)
+    {
+        cpuRelax();
+        sequence = load();
+    }
+    if (sequence > seen)
+    {
+        spinWaits_.fetch_add(1, std::memory_order_relaxed);
+        return sequence;
+    }
+
+    parkedWaits_.fetch_add(1, std::memory_order_relaxed);
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true)
+    {
+        uint32_t word = word_.load(std::memory_order_acquire);
+        parked_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        sequence = load();
+        auto now = std::chrono::steady_clock::now();
+        if (sequence > seen || now >= deadline)
+        {
+            parked_.fetch_sub(1, std::memory_order_relaxed);
+            return sequence;
+        }
+        parkOn(word_, word, std::chrono::duration_cast<std::chrono::microseconds>(deadline - now));
+        parked_.fetch_sub(1, std::memory_order_relaxed);
+        // A publish or a wakeAll; spurious wake-ups park again
+        if (word_.load(std::memory_order_acquire) != word)
+            return load();
+    }
+}
+
+SequenceSignal::Stats SequenceSignal::stats() const
+{
+    Stats stats;
+    stats.published = published_.load(std::memory_order_relaxed);
+    stats.wakeCalls = wakeCalls_.load(std::memory_order_relaxed);
+    stats.spinWaits = spinWaits_.load(std::memory_order_relaxed);
+    stats.parkedWaits = parkedWaits_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SequenceSignal::reset()
+{
+    sequence_.store(0, std::memory_order_relaxed);
+    published_.store(0, std::memory_order_relaxed);
+    wakeCalls_.store(0, std::memory_order_relaxed);
+    spinWaits_.store(0, std::memory_order_relaxed);
+    parkedWaits_.store(0, std::memory_order_relaxed);
+}
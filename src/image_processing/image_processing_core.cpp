@@ -18,29 +18,52 @@ ThreadLocalMats initializeThreadMats(int height, int width, SharedResources &sha
     return mats;
 }
 
-void processFrame(const cv::Mat &inputImage, SharedResources &shared,
-                  cv::Mat &outputImage, ThreadLocalMats &mats)
+ProcessingSnapshot takeProcessingSnapshot(SharedResources &shared, cv::Size imageSize)
 {
-    std::lock_guard<std::mutex> lock(shared.processingConfigMutex);
-    cv::Rect roi = shared.roi;
+    // Copies and a reference to the background, so several workers can
+    // process at once without holding either lock. The background is
+    // replaced, never written in place, so the reference stays valid.
+    ProcessingSnapshot snapshot;
+    {
+        std::lock_guard<std::mutex> lock(shared.roiMutex);
+        snapshot.roi = shared.roi;
+    }
+    {
+        std::lock_guard<std::mutex> lock(shared.processingConfigMutex);
+        snapshot.background = shared.blurredBackground;
+        snapshot.config = shared.processingConfig;
+    }
     // Ensure ROI is within image bounds
-    roi &= cv::Rect(0, 0, inputImage.cols, inputImage.rows);
-    // Direct access to background
-    cv::Mat blurred_bg = shared.blurredBackground(roi);
+    snapshot.roi &= cv::Rect(0, 0, imageSize.width, imageSize.height);
+    return snapshot;
+}
+
+ProcessingSnapshot processFrame(const cv::Mat &inputImage, SharedResources &shared,
+                                cv::Mat &outputImage, ThreadLocalMats &mats)
+{
+    ProcessingSnapshot snapshot = takeProcessingSnapshot(shared, inputImage.size());
+    processFrame(inputImage, snapshot, outputImage, mats);
+    return snapshot;
+}
+
+void processFrame(const cv::Mat &inputImage, const ProcessingSnapshot &snapshot,
+                  cv::Mat &outputImage, ThreadLocalMats &mats)
+{
+    const cv::Rect roi = snapshot.roi & cv::Rect(0, 0, inputImage.cols, inputImage.rows);
+    const ProcessingConfig &config = snapshot.config;
+    cv::Mat blurred_bg = snapshot.background(roi);
     // Process only ROI area
     auto roiArea = inputImage(roi);
     cv::GaussianBlur(roiArea, mats.blurred_target(roi),
-                     cv::Size(shared.processingConfig.gaussian_blur_size,
-                              shared.processingConfig.gaussian_blur_size),
-                     0);
+                     cv::Size(config.gaussian_blur_size, config.gaussian_blur_size), 0);
     cv::subtract(blurred_bg, mats.blurred_target(roi), mats.bg_sub(roi));
     cv::threshold(mats.bg_sub(roi), mats.binary(roi),
-                  shared.processingConfig.bg_subtract_threshold, 255, cv::THRESH_BINARY);
+                  config.bg_subtract_threshold, 255, cv::THRESH_BINARY);
     // Combine operations to reduce memory transfers
     cv::morphologyEx(mats.binary(roi), mats.dilate1(roi), cv::MORPH_CLOSE, mats.kernel,
-                     cv::Point(-1, -1), shared.processingConfig.morph_iterations);
+                     cv::Point(-1, -1), config.morph_iterations);
     cv::morphologyEx(mats.dilate1(roi), outputImage(roi), cv::MORPH_OPEN, mats.kernel,
-                     cv::Point(-1, -1), shared.processingConfig.morph_iterations);
+                     cv::Point(-1, -1), config.morph_iterations);
 
     if (roi.width != inputImage.cols || roi.height != inputImage.rows)
     {
@@ -1,9 +1,10 @@
 #include "image_processing/image_processing.h"
 #include "CircularBuffer/CircularBuffer.h"
+#include "CircularBuffer/FrameRing.h"
 #include "mib_grabber/mib_grabber.h"
+#include "mib_grabber/GrabberSession.h"
 #include <chrono>
 #include <iostream>
-#include <conio.h>
 #include <filesystem>
 #include <fstream>   // Add this for file operations
 #include <string>    // Add this for std::string
@@ -15,11 +16,18 @@
 #include <matplot/matplot.h>
 #include <thread>
 #include <atomic>
+#include <deque>
+#include <iomanip>
+#include <sstream>
 #ifdef _WIN32
 #include <windows.h>
+#include <conio.h>
 #else
 #include <pthread.h>
 #include <sched.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <unistd.h>
 #endif
 
 using json = nlohmann::json;
@@ -132,101 +140,22 @@ FilterResult filterProcessedImage(const cv::Mat &processedImage, const cv::Rect
     return result;
 }
 
-void simulateCameraThread(
-    CircularBuffer &cameraBuffer, SharedResources &shared,
-    const ImageParams &params)
-{
-    using clock = std::chrono::high_resolution_clock;
-
-    size_t currentIndex = 0;
-    size_t totalFrames = cameraBuffer.size();
-    auto lastFrameTime = clock::now();
-    auto fpsStartTime = clock::now();
-    size_t frameCount = 0;
-    const int simCameraTargetFPS = 5000;
-    const std::chrono::nanoseconds frameInterval(1000000000 / simCameraTargetFPS);
-
-    while (!shared.done)
-    {
-        auto now = clock::now();
-        if (!shared.paused && (now - lastFrameTime) >= frameInterval)
-        {
-            const uint8_t *imageData = cameraBuffer.getPointer(currentIndex);
-            if (imageData != nullptr)
-            {
-                shared.latestCameraFrame.store(currentIndex, std::memory_order_release);
-                currentIndex = (currentIndex + 1) % totalFrames;
-                lastFrameTime = now;
-                if (++frameCount % 5000 == 0)
-                {
-                }
-            }
-            else
-            {
-                std::cout << "Invalid frame at index: " << currentIndex << std::endl;
-            }
-        }
-
-        if (std::chrono::duration_cast<std::chrono::seconds>(now - fpsStartTime).count() >= 5)
-        {
-            double fps = frameCount / std::chrono::duration<double>(now - fpsStartTime).count();
-            shared.currentFPS.store(fps, std::memory_order_release);
-            frameCount = 0;
-            fpsStartTime = now;
-        }
-        shared.updated = true;
-    }
-    std::cout << "Camera thread interrupted." << std::endl;
-}
-
-void metricDisplayThread(SharedResources &shared)
+void metricDisplayThread(SharedResources &shared, const FrameRing &frameRing)
 {
     using namespace ftxui;
     std::this_thread::sleep_for(std::chrono::milliseconds(100)); // sleep for 1ms to allow other things to be printed first
 
-    auto calculateProcessingMetrics = [](const CircularBuffer &processingTimes)
-    {
-        double avgTime = 0.0, maxTime = 0.0, minTime = std::numeric_limits<double>::max();
-        double instantTime = 0.0;
-        size_t highLatencyCount = 0;            // Count of times above 200us
-        const double LATENCY_THRESHOLD = 200.0; // 200us threshold
-
-        size_t count = processingTimes.size();
-        if (count > 0)
-        {
-            // Get latest value for instant time
-            instantTime = *reinterpret_cast<const double *>(processingTimes.getPointer(0));
-
-            // Calculate statistics
-            for (size_t i = 0; i < count; i++)
-            {
-                const double *timePtr = reinterpret_cast<const double *>(processingTimes.getPointer(i));
-                double time = *timePtr;
-                avgTime += time;
-                maxTime = std::max(maxTime, time);
-                minTime = std::min(minTime, time);
-                if (time > LATENCY_THRESHOLD)
-                {
-                    highLatencyCount++;
-                }
-            }
-            avgTime /= count;
-        }
-
-        double highLatencyPercentage = count > 0 ? (highLatencyCount * 100.0) / count : 0.0;
-        return std::make_tuple(instantTime, avgTime, maxTime, minTime, highLatencyPercentage);
-    };
     auto calculateDeformabilityBufferRate = [](const SharedResources &shared)
     {
         // Calculate the rate of new sets added to the deformability buffer
         static auto lastCheckTime = std::chrono::steady_clock::now();
-        static size_t lastBufferCount = 0;
+        static uint64_t lastBufferCount = 0;
 
         auto now = std::chrono::steady_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - lastCheckTime).count();
 
-        size_t currentBufferCount = shared.deformabilityBuffer.size();
-        size_t addedCount = currentBufferCount - lastBufferCount;
+        uint64_t currentBufferCount = shared.deformabilityBuffer.totalPushed();
+        uint64_t addedCount = currentBufferCount - lastBufferCount;
 
         double rate = duration > 0 ? static_cast<double>(addedCount) / duration : 0.0;
 
@@ -236,15 +165,40 @@ void metricDisplayThread(SharedResources &shared)
         return rate;
     };
 
+    auto render_clock = [&]()
+    {
+        ClockEstimate clock = shared.clockSync.estimate();
+        if (!clock.valid)
+            return hbox({text("Camera Clock: "), text("not synchronised")});
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(1) << clock.driftPpm << " ppm drift, fit +/-" << clock.residualUs << " us";
+        return hbox({text("Camera Clock: "), text(line.str())});
+    };
+
+    auto render_queue = [](const std::string &name, const BoundedQueueStats &stats)
+    {
+        return hbox({text(name + ": "), text(std::to_string(stats.size) + "/" + std::to_string(stats.capacity) +
+                                             ", high " + std::to_string(stats.highWater) + ", " +
+                                             std::to_string(stats.dropped) + " dropped, " +
+                                             std::to_string(stats.coalesced) + " coalesced")});
+    };
+
     auto render_processing_metrics = [&]()
     {
-        auto [instantTime, avgTime, maxTime, minTime, highLatencyPct] = calculateProcessingMetrics(shared.processingTimes);
+        // Rolling statistics are maintained on push, reading them is O(1)
+        RollingStatsSnapshot times = shared.processingTimes.stats();
         double rate = calculateDeformabilityBufferRate(shared);
 
-        return window(text("Processing Metrics"), vbox({hbox({text("Avg Processing Time: "), text(std::to_string((int)avgTime) + " us")}),
-                                                        hbox({text("Max Processing Time: "), text(std::to_string((int)maxTime) + " us")}),
-                                                        hbox({text("High Latency (>200us): "), text(std::to_string(highLatencyPct) + "%")}),
-                                                        hbox({text("Processing Queue Size: "), text(std::to_string(shared.framesToProcess.size()) + " frames")}),
+        return window(text("Processing Metrics"), vbox({hbox({text("Avg Processing Time: "), text(std::to_string((int)times.mean) + " us")}),
+                                                        hbox({text("Max Processing Time: "), text(std::to_string((int)times.max) + " us")}),
+                                                        hbox({text("P99 Processing Time: "), text(std::to_string((int)times.p99) + " us")}),
+                                                        hbox({text("High Latency (>200us): "), text(std::to_string(times.aboveThresholdPercent) + "%")}),
+                                                        hbox({text("Frame-to-Decision P99: "), text(std::to_string((int)shared.decisionLatencies.stats().p99) + " us")}),
+                                                        hbox({text("Frame-to-Trigger P99: "), text(std::to_string((int)shared.triggerLatencies.stats().p99) + " us")}),
+                                                        hbox({text("Exposure-to-Trigger P99: "), text(std::to_string((int)shared.exposureToTriggerLatencies.stats().p99) + " us, " +
+                                                                                                     std::to_string(shared.lateTriggers.load()) + " late")}),
+                                                        render_clock(),
+                                                        render_queue("Processing Queue", shared.framesToProcess.stats()),
                                                         hbox({text("Deformability Buffer Size: "), text(std::to_string(shared.deformabilityBuffer.size()) + " sets")}),
                                                         hbox({text("Processed Trigger: "), text(shared.processTrigger.load() ? "Yes" : "No")}),
                                                         hbox({text("Deformability: "), text(std::to_string(shared.frameDeformabilities.load()))}),
@@ -252,6 +206,98 @@ void metricDisplayThread(SharedResources &shared)
                                                         hbox({text("Area Ratio: "), text(std::to_string(shared.frameAreaRatios.load()))})}));
     };
 
+    auto render_ring_metrics = [&]()
+    {
+        Elements rows;
+        rows.push_back(hbox({text("Ring Frames: "), text(std::to_string(frameRing.size()) + "/" + std::to_string(frameRing.capacity()))}));
+        {
+            std::lock_guard<std::mutex> lock(shared.sourceTelemetryMutex);
+            if (!shared.sourceName.empty())
+            {
+                const SourceTelemetry &source = shared.sourceTelemetry;
+                rows.push_back(hbox({text("Source (" + shared.sourceName + "): "),
+                                     text(std::to_string(source.delivered) + " delivered, " + std::to_string(source.coalesced) +
+                                          " coalesced, " + std::to_string(source.dropped) + " dropped")}));
+                RollingStatsSnapshot dispatch = shared.dispatchTimes.stats();
+                if (dispatch.count > 0)
+                    rows.push_back(hbox({text("Dispatch Work: "),
+                                         text(std::to_string((int)dispatch.p99) + " us p99, " + std::to_string((int)dispatch.p999) +
+                                              " us p99.9, " + std::to_string((int)dispatch.max) + " us max")}));
+                if (source.maxLatenessUs > 0)
+                    rows.push_back(hbox({text("Replay Lateness: "),
+                                         text(std::to_string((int)source.meanLatenessUs) + " us mean, " +
+                                              std::to_string((int)source.maxLatenessUs) + " us max")}));
+            }
+        }
+        for (size_t i = 0; i < frameRing.consumerCount(); ++i)
+        {
+            ConsumerStats stats = frameRing.consumerStats(i);
+            rows.push_back(hbox({text(stats.name + " Lag: "),
+                                 text(std::to_string(stats.lag) + " frames, " + std::to_string(stats.skipped) + " skipped")}));
+        }
+        rows.push_back(hbox({text("Dropped (pinned): "), text(std::to_string(frameRing.pinnedDrops() + frameRing.consumerDrops()))}));
+        const FrameStorage &storage = frameRing.storage();
+        double firstFrameMs = frameRing.startupToFirstFrameMs();
+        rows.push_back(hbox({text("Startup to First Frame: "), text(firstFrameMs < 0 ? "waiting" : std::to_string((int)firstFrameMs) + " ms")}));
+        if (shared.compressedHistory)
+        {
+            const CompressedHistory &history = *shared.compressedHistory;
+            RollingStatsSnapshot encode = shared.historyEncodeTimes.stats();
+            rows.push_back(hbox({text("Compressed History: "),
+                                 text(std::to_string(history.size()) + " frames, " +
+                                      std::to_string(history.compressionRatio()).substr(0, 4) + "x, " +
+                                      std::to_string(history.bytesUsed() >> 20) + "/" + std::to_string(history.byteBudget() >> 20) + " MB")}));
+            rows.push_back(hbox({text("History Encode: "),
+                                 text(std::to_string((int)encode.mean) + " us mean, " + std::to_string((int)encode.p99) + " us p99")}));
+        }
+        if (storage.fileBacked())
+        {
+            rows.push_back(hbox({text("History File: "), text(std::to_string(storage.bytes() >> 20) + " MB mapped")}));
+        }
+        else
+        {
+            std::string prefault = !storage.prefaultEnabled() ? "off"
+                                   : storage.prefaulted()     ? std::to_string((int)storage.prefaultMs()) + " ms"
+                                                              : "in progress";
+            rows.push_back(hbox({text("Prefault: "), text(prefault)}));
+            rows.push_back(hbox({text("Huge Pages / Locked: "), text(std::string(storage.usingHugePages() ? "Yes" : "No") + " / " + (storage.locked() ? "Yes" : "No"))}));
+        }
+        return window(text("Frame Ring"), vbox(std::move(rows)));
+    };
+
+    auto render_frame_loss = [&]()
+    {
+        FrameLossSnapshot loss = shared.frameLoss.snapshot();
+        RollingStatsSnapshot rates = shared.frameLoss.lossRateStats();
+        Elements rows;
+        rows.push_back(hbox({text("Frames Received: "), text(std::to_string(loss.received))}));
+        rows.push_back(hbox({text("Frames Analysed: "), text(std::to_string(shared.framesAnalysed.load()))}));
+        for (size_t i = 0; i < loss.lost.size(); ++i)
+        {
+            rows.push_back(hbox({text(std::string(FrameLossTracker::causeName(static_cast<LossCause>(i))) + ": "),
+                                 text(std::to_string(loss.lost[i]))}));
+        }
+        rows.push_back(hbox({text("Loss Rate (run): "), text(std::to_string(loss.lossPercent()) + "%")}));
+        rows.push_back(hbox({text("Loss Rate (1 s / max): "),
+                             text(std::to_string(rates.latest) + "% / " + std::to_string(rates.max) + "%")}));
+        return window(text("Frame Loss"), vbox(std::move(rows)));
+    };
+
+    auto render_cameras = [&]()
+    {
+        Elements rows;
+        std::vector<SharedResources *> cameras = {&shared};
+        cameras.insert(cameras.end(), shared.otherCameras.begin(), shared.otherCameras.end());
+        for (SharedResources *camera : cameras)
+        {
+            FrameLossSnapshot loss = camera->frameLoss.snapshot();
+            rows.push_back(hbox({text("Camera " + std::to_string(camera->cameraId) + ": "),
+                                 text(std::to_string(loss.received) + " frames, " + std::to_string(loss.lossPercent()) +
+                                      "% lost, p99 " + std::to_string((int)camera->processingTimes.stats().p99) + " us")}));
+        }
+        return window(text("Cameras"), vbox(std::move(rows)));
+    };
+
     auto render_config_metrics = [&]()
     {
         return window(text("Configuration"), vbox({hbox({text("Current FPS: "),
@@ -272,7 +318,11 @@ void metricDisplayThread(SharedResources &shared)
                                                    hbox({text("Area Min Threshold: "),
                                                          text(std::to_string(shared.processingConfig.area_threshold_min))}),
                                                    hbox({text("Area Max Threshold: "),
-                                                         text(std::to_string(shared.processingConfig.area_threshold_max))})}));
+                                                         text(std::to_string(shared.processingConfig.area_threshold_max))}),
+                                                   hbox({text("Last Reload: "),
+                                                         text(shared.reloadScriptMs.load() <= 0 ? std::string("-")
+                                                                                                : std::to_string((int)shared.reloadScriptMs.load()) + " ms script, " +
+                                                                                                      (shared.reloadToFirstFrameMs.load() < 0 ? std::string("waiting") : std::to_string((int)shared.reloadToFirstFrameMs.load()) + " ms to first frame"))})}));
     };
 
     auto render_status = [&]()
@@ -310,22 +360,33 @@ void metricDisplayThread(SharedResources &shared)
                                                          text("  R: Toggle data recording"),
                                                          text("  S: Save all frames to disk"),
                                                          text("  F: Configure eGrabber settings"),
+                                                         text("  N: Next frame (replay step mode)"),
                                                          text("ROI: Click and drag to select region"),
+                                                         text("  c: Crop the camera to the ROI (camera_roi)"),
+                                                         text("  C: Restore the full sensor"),
                                                      }));
     };
 
     std::string reset_position;
     while (!shared.done)
     {
+        shared.frameLoss.sampleIfDue();
+        for (SharedResources *camera : shared.otherCameras)
+            camera->frameLoss.sampleIfDue();
         if (shared.updated)
         {
-            auto document = hbox({
+            Elements panels = {
                 render_processing_metrics(),
+                render_ring_metrics(),
+                render_frame_loss(),
                 render_config_metrics(),
                 // render_roi(),
                 render_status(),
                 render_keyboard_instructions(),
-            });
+            };
+            if (!shared.otherCameras.empty())
+                panels.insert(panels.begin() + 3, render_cameras());
+            auto document = hbox(std::move(panels));
 
             auto screen = Screen::Create(Dimension::Full(), Dimension::Fit(document));
             Render(screen, document);
@@ -338,111 +399,241 @@ void metricDisplayThread(SharedResources &shared)
     }
 }
 
+FrameVerdict measureFrame(const cv::Mat &inputImage, const FrameMeta &meta, SharedResources &shared,
+                          cv::Mat &processedImage, ThreadLocalMats &mats, const std::function<void()> &completeFrame)
+{
+    return measureFrame(inputImage, meta, shared, takeProcessingSnapshot(shared, inputImage.size()),
+                        processedImage, mats, completeFrame);
+}
+
+FrameVerdict measureFrame(const cv::Mat &inputImage, const FrameMeta &meta, SharedResources &shared,
+                          const ProcessingSnapshot &snapshot, cv::Mat &processedImage, ThreadLocalMats &mats,
+                          const std::function<void()> &completeFrame)
+{
+    size_t width = inputImage.cols;
+    size_t height = inputImage.rows;
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    FrameVerdict verdict;
+    verdict.meta = meta;
+    shared.framesAnalysed++;
+
+    // Check if ROI is the same as the full image
+    if (static_cast<size_t>(snapshot.roi.width) != width && static_cast<size_t>(snapshot.roi.height) != height)
+    {
+        // Preprocess Image using the optimized processFrame function
+        processFrame(inputImage, snapshot, processedImage, mats);
+        auto filterResult = filterProcessedImage(processedImage, snapshot.roi, snapshot.config);
+
+        if (!filterResult.touchesBorder && filterResult.isValid)
+        {
+            verdict.valid = true;
+            verdict.areaRatio = filterResult.areaRatio;
+            verdict.area = filterResult.area;
+            verdict.deformability = filterResult.deformability;
+            // The frame is only readable while the worker holds it
+            const SharedResources &sink = shared.resultSink ? *shared.resultSink : shared;
+            if (sink.running)
+            {
+                if (completeFrame)
+                    completeFrame();
+                verdict.originalImage = inputImage.clone();
+            }
+        }
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+    double processingTime = duration.count();
+
+    // Just store the processing time
+    shared.processingTimes.push(processingTime);
+    return verdict;
+}
+
+void emitVerdict(SharedResources &shared, FrameVerdict &verdict)
+{
+    const size_t BUFFER_THRESHOLD = 1000; // Adjust as needed
+    const FrameMeta &meta = verdict.meta;
+
+    shared.validProcessingFrame = verdict.valid;
+    if (verdict.valid)
+    {
+        // The trigger threads watch camera 0, so another camera raises the
+        // trigger there, with its timestamp moved onto camera 0's clock through
+        // both clock fits (0 until both are valid: the pulse then uses host time)
+        SharedResources &trigger = shared.resultSink ? *shared.resultSink : shared;
+        uint64_t frameCameraUs = meta.cameraTimestamp;
+        if (&trigger != &shared)
+        {
+            ClockEstimate own = shared.clockSync.estimate();
+            ClockEstimate target = trigger.clockSync.estimate();
+            frameCameraUs = own.valid && target.valid ? target.cameraUs(own.hostUs(meta.cameraTimestamp)) : 0;
+        }
+        trigger.triggerFrameSteadyUs = meta.hostSteadyUs;
+        trigger.triggerFrameCameraUs = frameCameraUs;
+        trigger.processTrigger = true;
+        {
+            shared.deformabilityBuffer.push(verdict.deformability, verdict.area);
+            shared.frameAreaRatios.store(verdict.areaRatio);
+            // apply sorting function to give signal to EGrabber
+            shared.newScatterDataAvailable = true;
+            shared.scatterDataCondition.notify_one();
+
+            // Another camera's results go to the merged store on camera 0
+            SharedResources &sink = shared.resultSink ? *shared.resultSink : shared;
+            if (sink.running && !verdict.originalImage.empty())
+            {
+                QualifiedResult qualifiedResult;
+                qualifiedResult.timestamp = meta.hostWallUs;
+                qualifiedResult.frameId = meta.frameId;
+                qualifiedResult.cameraTimestamp = meta.cameraTimestamp;
+                qualifiedResult.areaRatio = verdict.areaRatio;
+                qualifiedResult.area = verdict.area;
+                qualifiedResult.deformability = verdict.deformability;
+                qualifiedResult.cameraId = shared.cameraId;
+                qualifiedResult.originalImage = std::move(verdict.originalImage);
+
+                std::lock_guard<std::mutex> qualifiedResultsLock(sink.qualifiedResultsMutex);
+                auto &currentBuffer = sink.usingBuffer1 ? sink.qualifiedResultsBuffer1
+                                                        : sink.qualifiedResultsBuffer2;
+                currentBuffer.push_back(std::move(qualifiedResult));
+
+                if (currentBuffer.size() >= BUFFER_THRESHOLD && !sink.savingInProgress)
+                {
+                    sink.usingBuffer1 = !sink.usingBuffer1;
+                    sink.savingInProgress = true;
+                    sink.currentBatchNumber++;
+                    sink.savingCondition.notify_one();
+                }
+            }
+        }
+    }
+
+    shared.decisionLatencies.push(static_cast<double>(steadyNowUs() - meta.hostSteadyUs));
+    shared.updated = true;
+}
+
+void analyzeFrame(const cv::Mat &inputImage, const FrameMeta &meta, SharedResources &shared,
+                  cv::Mat &processedImage, ThreadLocalMats &mats, const std::function<void()> &completeFrame)
+{
+    FrameVerdict verdict = measureFrame(inputImage, meta, shared, processedImage, mats, completeFrame);
+    emitVerdict(shared, verdict);
+}
+
 void processingThreadTask(
     std::mutex &processingQueueMutex,
-    std::condition_variable &processingQueueCondition,
-    std::queue<size_t> &framesToProcess,
-    const CircularBuffer &processingBuffer,
+    BoundedQueue<FrameWorkItem> &framesToProcess,
+    FrameRing &frameRing, size_t consumer, ProcessingPolicy policy,
     size_t width, size_t height, SharedResources &shared)
 {
-    shared.currentBatchNumber = 0;
     // Pre-allocate memory for images
-    cv::Mat inputImage(height, width, CV_8UC1);
     cv::Mat processedImage(height, width, CV_8UC1);
     ThreadLocalMats mats = initializeThreadMats(height, width, shared);
-    const size_t BUFFER_THRESHOLD = 1000; // Adjust as needed
-    // const size_t area_threshold = 10;
-    const uint8_t processedColor = 255; // grey scaled cell color
-    shared.processTrigger = false;
+    ReorderBuffer<FrameVerdict> &order = *shared.processingOrder;
 
     while (!shared.done)
     {
-        std::unique_lock<std::mutex> lock(processingQueueMutex);
-        processingQueueCondition.wait(lock, [&]()
-                                      { return !framesToProcess.empty() || shared.done || shared.paused; });
-
-        if (shared.done)
-            break;
-
-        if (!framesToProcess.empty() && !shared.paused)
+        if (shared.paused)
         {
-            // size_t frame = framesToProcess.front(); //retrieve content of queue
-            framesToProcess.pop();
-            lock.unlock();
-
-            auto startTime = std::chrono::high_resolution_clock::now();
-            shared.validProcessingFrame = false;
-            auto imageData = processingBuffer.get(0);
-            inputImage = cv::Mat(height, width, CV_8UC1, imageData.data());
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
 
-            // Check if ROI is the same as the full image
-            if (static_cast<size_t>(shared.roi.width) != width && static_cast<size_t>(shared.roi.height) != height)
+        // One worker at a time waits on the queue, the others on the lock
+        std::unique_lock<std::mutex> lock(processingQueueMutex);
+        FrameWorkItem item;
+        if (!framesToProcess.popWait(item, std::chrono::milliseconds(10)))
+            continue;
+        // Latest-only: everything queued behind the newest item is passed over
+        uint64_t skipped = 0;
+        if (policy == ProcessingPolicy::LatestOnly)
+        {
+            FrameWorkItem newer;
+            while (framesToProcess.tryPop(newer))
             {
-                // Preprocess Image using the optimized processFrame function
-                processFrame(inputImage, shared, processedImage, mats);
-                auto filterResult = filterProcessedImage(processedImage, shared.roi, shared.processingConfig);
-
-                if (!filterResult.touchesBorder && filterResult.isValid)
-                {
-                    shared.processTrigger = true;
-                    shared.validProcessingFrame = true;
-                    auto plotMetrics = std::make_tuple(filterResult.deformability, filterResult.area);
-                    {
-                        std::lock_guard<std::mutex> circularitiesLock(shared.deformabilityBufferMutex);
-                        shared.deformabilityBuffer.push(reinterpret_cast<const uint8_t *>(&plotMetrics));
-                        shared.frameAreaRatios.store(filterResult.areaRatio);
-                        // apply sorting function to give signal to EGrabber
-                        shared.newScatterDataAvailable = true;
-                        shared.scatterDataCondition.notify_one();
-
-                        if (shared.running)
-                        {
-                            QualifiedResult qualifiedResult;
-                            qualifiedResult.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
-                                                            std::chrono::system_clock::now().time_since_epoch())
-                                                            .count();
-                            qualifiedResult.areaRatio = filterResult.areaRatio;
-                            qualifiedResult.area = filterResult.area;
-                            qualifiedResult.deformability = filterResult.deformability;
-                            qualifiedResult.originalImage = inputImage.clone();
-
-                            std::lock_guard<std::mutex> qualifiedResultsLock(shared.qualifiedResultsMutex);
-                            auto &currentBuffer = shared.usingBuffer1 ? shared.qualifiedResultsBuffer1
-                                                                      : shared.qualifiedResultsBuffer2;
-                            currentBuffer.push_back(std::move(qualifiedResult));
-
-                            if (currentBuffer.size() >= BUFFER_THRESHOLD && !shared.savingInProgress)
-                            {
-                                shared.usingBuffer1 = !shared.usingBuffer1;
-                                shared.savingInProgress = true;
-                                shared.currentBatchNumber++;
-                                shared.savingCondition.notify_one();
-                            }
-                        }
-                    }
-                }
+                item = newer;
+                ++skipped;
             }
+        }
+        // Pin the named slot and analyse it in place; the writer will not
+        // reuse it until released. Taken under the lock so the consumer
+        // cursor and the tickets follow the queue order.
+        FrameLease lease = frameRing.take(consumer, item.sequence);
+        uint64_t ticket = shared.nextProcessingTicket++;
+        lock.unlock();
+        if (skipped > 0)
+            shared.frameLoss.count(LossCause::Skipped, skipped);
+
+        if (!lease)
+        {
+            // Only a lossy consumer can be lapped before it gets to the frame
+            shared.frameLoss.count(LossCause::RingOverwrite);
+            order.skip(ticket);
+            continue;
+        }
+        FrameVerdict verdict = measureFrame(frameView(lease, height, width), lease.meta(), shared, processedImage, mats);
+        lease.release();
+        order.complete(ticket, std::move(verdict));
+    }
+    std::cout << "Processing thread interrupted." << std::endl;
+}
 
-            auto endTime = std::chrono::high_resolution_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
-            double processingTime = duration.count();
+void historyThreadTask(FrameRing &frameRing, size_t consumer, SharedResources &shared)
+{
+    // Encodes frames into the compressed history off the acquisition thread.
+    // The history consumer is lossy: if encoding falls behind, frames are skipped.
+    CompressedHistory &history = *shared.compressedHistory;
+    uint64_t backgroundVersion = ~0ull;
 
-            // Just store the processing time
-            shared.processingTimes.push(reinterpret_cast<const uint8_t *>(&processingTime));
-            shared.updated = true;
+    while (!shared.done)
+    {
+        uint64_t version = shared.backgroundVersion.load();
+        if (version != backgroundVersion)
+        {
+            std::lock_guard<std::mutex> lock(shared.backgroundFrameMutex);
+            const cv::Mat &background = shared.backgroundFrame;
+            if (background.isContinuous() && background.total() * background.elemSize() == history.imageSize())
+                history.setBackground(background.data);
+            backgroundVersion = version;
         }
-        else
+
+        // Hold the history still while it is being reviewed
+        FrameLease lease;
+        if (!shared.paused)
+            lease = frameRing.next(consumer);
+        if (!lease)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+        if (history.push(lease.data(), lease.meta()) > 0)
         {
-            lock.unlock();
+            shared.historyEncodeTimes.push(
+                std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count());
         }
     }
-    std::cout << "Processing thread interrupted." << std::endl;
+    std::cout << "History thread interrupted." << std::endl;
+}
+
+// Paused review reads from the compressed history when it is enabled,
+// otherwise straight from the frame ring. index 0 is the newest frame.
+size_t reviewFrameCount(const FrameRing &frameRing, const SharedResources &shared)
+{
+    return shared.compressedHistory ? shared.compressedHistory->size() : frameRing.size();
+}
+
+bool readReviewFrame(const FrameRing &frameRing, const SharedResources &shared, size_t index, cv::Mat &image)
+{
+    if (shared.compressedHistory)
+        return shared.compressedHistory->decode(index, image.data);
+    return frameRing.read(index, image.data);
 }
 
 void displayThreadTask(
-    std::queue<size_t> &framesToDisplay,
-    std::mutex &displayQueueMutex,
-    const CircularBuffer &circularBuffer,
+    FrameRing &frameRing, size_t consumer,
     size_t width,
     size_t height,
     size_t bufferCount,
@@ -456,9 +647,9 @@ void displayThreadTask(
     ThreadLocalMats mats = initializeThreadMats(height, width, shared);
 
     // Pre-allocate memory for images
-    cv::Mat image(height, width, CV_8UC1);
     cv::Mat processedImage(height, width, CV_8UC1);
     cv::Mat displayImage(height, width, CV_8UC3);
+    cv::Mat reviewImage(height, width, CV_8UC1);
 
     cv::namedWindow("Live Feed", cv::WINDOW_AUTOSIZE);
     cv::resizeWindow("Live Feed", width, height);
@@ -554,14 +745,12 @@ void displayThreadTask(
         {
             if (now >= nextFrameTime)
             {
-                std::unique_lock<std::mutex> lock(displayQueueMutex);
-                if (!framesToDisplay.empty())
+                // The ring's sequence is the only signal needed: latest() is
+                // empty until a frame newer than the last one shown arrives
+                FrameLease lease = frameRing.latest(consumer);
+                if (lease)
                 {
-                    framesToDisplay.pop();
-                    lock.unlock();
-
-                    auto imageData = circularBuffer.get(0);
-                    image = cv::Mat(height, width, CV_8UC1, imageData.data());
+                    cv::Mat image = frameView(lease, height, width);
                     processFrame(image, shared, processedImage, mats);
                     updateDisplay(image, processedImage);
                     shouldUpdate = true;
@@ -579,14 +768,14 @@ void displayThreadTask(
             if (shared.displayNeedsUpdate)
             {
                 int index = shared.currentFrameIndex;
-                if (index >= 0 && index < circularBuffer.size())
+                if (index >= 0 && index < reviewFrameCount(frameRing, shared))
                 {
                     shared.validDisplayFrame = false;
                     shared.displayFrameTouchedBorder = false;
                     shared.hasMultipleContours = false;
-                    auto imageData = circularBuffer.get(index);
-                    if (!imageData.empty())
+                    if (readReviewFrame(frameRing, shared, index, reviewImage))
                     {
+                        const cv::Mat &image = reviewImage;
 
                         // read config to enable hot reloading of image processing parameters
                         json config = readConfig("config.json");
@@ -596,9 +785,8 @@ void displayThreadTask(
                         shared.processingConfig = newConfig;
                         shared.processingConfigMutex.unlock();
 
-                        image = cv::Mat(height, width, CV_8UC1, imageData.data());
-                        processFrame(image, shared, processedImage, mats);
-                        auto filterResult = filterProcessedImage(processedImage, shared.roi, shared.processingConfig);
+                        ProcessingSnapshot snapshot = processFrame(image, shared, processedImage, mats);
+                        auto filterResult = filterProcessedImage(processedImage, snapshot.roi, snapshot.config);
                         shared.hasMultipleContours = filterResult.hasMultipleContours;
                         shared.displayFrameTouchedBorder = filterResult.touchesBorder;
 
@@ -700,29 +888,10 @@ void updateScatterPlot(SharedResources &shared)
 
                 bool needsUpdate = false;
                 {
-                    std::lock_guard<std::mutex> lock(shared.deformabilityBufferMutex);
                     if (shared.newScatterDataAvailable && shared.deformabilityBuffer.size() > 0)
                     {
-                        x.clear();
-                        y.clear();
-
-                        size_t size = shared.deformabilityBuffer.size();
-                        if (x.capacity() < size)
-                        {
-                            x.reserve(size);
-                            y.reserve(size);
-                        }
-
-                        for (size_t i = 0; i < size; i++)
-                        {
-                            const auto *metrics = reinterpret_cast<const std::tuple<double, double> *>(
-                                shared.deformabilityBuffer.getPointer(i));
-                            if (metrics)
-                            {
-                                x.push_back(std::get<1>(*metrics)); // area
-                                y.push_back(std::get<0>(*metrics)); // deformability
-                            }
-                        }
+                        // Column snapshot: deformability, area
+                        std::tie(y, x) = shared.deformabilityBuffer.columns();
 
                         if (!x.empty() && !y.empty())
                         {
@@ -788,30 +957,102 @@ void updateScatterPlot(SharedResources &shared)
     std::cout << "Scatter plot thread interrupted." << std::endl;
 }
 
+// Non-blocking single key reads from the console. On POSIX the terminal is
+// switched out of line mode while the keyboard thread runs.
+class ConsoleKeys
+{
+public:
+#ifdef _WIN32
+    int poll() { return _kbhit() ? _getch() : -1; }
+#else
+    ConsoleKeys()
+    {
+        if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved_) == 0)
+        {
+            termios raw = saved_;
+            raw.c_lflag &= ~(ICANON | ECHO);
+            raw.c_cc[VMIN] = 0;
+            raw.c_cc[VTIME] = 0;
+            restore_ = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+        }
+    }
+    ~ConsoleKeys()
+    {
+        if (restore_)
+            tcsetattr(STDIN_FILENO, TCSANOW, &saved_);
+    }
+    int poll()
+    {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(STDIN_FILENO, &readable);
+        timeval timeout{0, 0};
+        unsigned char ch;
+        if (select(STDIN_FILENO + 1, &readable, nullptr, nullptr, &timeout) > 0 && read(STDIN_FILENO, &ch, 1) == 1)
+            return ch;
+        return -1;
+    }
+
+private:
+    termios saved_{};
+    bool restore_ = false;
+#endif
+};
+
+void reloadConfiguration(SharedResources &shared, const std::string &scriptPath)
+{
+    // Applied to the running grabber through the session; no rediscovery
+    shared.reloadStartedUs = steadyNowUs();
+    shared.reloadToFirstFrameMs = -1.0;
+    try
+    {
+        ReloadResult result = GrabberSession::instance().runScript(scriptPath);
+        int64_t finishedUs = steadyNowUs();
+        ClockEstimate clock = shared.clockSync.estimate();
+        shared.reloadFinishedUs = finishedUs;
+        shared.reloadFinishedCameraUs = clock.valid ? clock.cameraUs(finishedUs) : 0;
+        shared.reloadScriptMs = std::max(result.scriptMs, 0.001);
+        shared.reloadToFirstFrameMs = result.firstFrameMs;
+        shared.awaitingReloadFrame = result.liveGrabbers > 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Configuration error: " << e.what() << std::endl;
+    }
+}
+
 void keyboardHandlingThread(
-    const CircularBuffer &circularBuffer,
+    const FrameRing &frameRing,
     size_t bufferCount, size_t width, size_t height,
     SharedResources &shared)
 {
+    auto endRun = [&]()
+    {
+        shared.done = true;
+        shared.framesToProcess.wakeAll();
+        shared.savingCondition.notify_all();
+    };
+
     auto handleKeypress = [&](int key)
     {
         if (key == 27)
         { // ESC key
-            shared.done = true;
-            shared.displayQueueCondition.notify_all();
-            shared.processingQueueCondition.notify_all();
-            shared.savingCondition.notify_all();
+            endRun();
         }
         else if (key == 32)
         { // Space bar
             shared.paused = !shared.paused;
             if (shared.paused)
             {
-                shared.currentFrameIndex = circularBuffer.size() - 1;
+                // The compressed history holds a variable number of frames
+                int frameCount = static_cast<int>(reviewFrameCount(frameRing, shared));
+                if (!shared.headless)
+                    cv::setTrackbarMax("Frame", "Live Feed", std::max(frameCount - 1, 1));
+                shared.currentFrameIndex = frameCount - 1;
                 shared.displayNeedsUpdate = true;
             }
         }
-        else if ((key == 'd' || key == 'D') && shared.paused && shared.currentFrameIndex < circularBuffer.size() - 1)
+        else if ((key == 'd' || key == 'D') && shared.paused && shared.currentFrameIndex < (int)reviewFrameCount(frameRing, shared) - 1)
         {
             shared.currentFrameIndex++;
             shared.displayNeedsUpdate = true;
@@ -823,7 +1064,14 @@ void keyboardHandlingThread(
         }
         else if (key == 'f' || key == 'F')
         {
-            configure_js("egrabberConfig.js");
+            reloadConfiguration(shared, "egrabberConfig.js");
+        }
+        else if ((key == 'c' || key == 'C') && shared.cameraRoiEnabled)
+        {
+            // The frame size changes, so the run ends and the runner restarts it
+            shared.fullSensorRequested = key == 'C';
+            shared.cameraWindowRequested = true;
+            endRun();
         }
         else if (key == 'p' || key == 'P')
         {
@@ -853,13 +1101,15 @@ void keyboardHandlingThread(
             std::filesystem::path currentSaveDir = outputDir / std::to_string(folderNum);
             std::filesystem::create_directory(currentSaveDir);
 
-            size_t frameCount = circularBuffer.size();
+            size_t frameCount = frameRing.size();
             // std::cout << "Saving " << frameCount << " frames..." << std::endl;
 
             for (size_t i = 0; i < frameCount; ++i)
             {
-                auto imageData = circularBuffer.get(frameCount - 1 - i); // Start from oldest frame
-                cv::Mat image(height, width, CV_8UC1, imageData.data());
+                FrameLease lease = frameRing.lease(frameCount - 1 - i); // Start from oldest frame
+                if (!lease)
+                    continue;
+                cv::Mat image = frameView(lease, height, width);
 
                 std::ostringstream oss;
                 oss << "frame_" << std::setw(5) << std::setfill('0') << i << ".png";
@@ -873,11 +1123,17 @@ void keyboardHandlingThread(
         }
         else if ((key == 'b' || key == 'B') && shared.paused)
         {
-            auto backgroundImageData = circularBuffer.get(shared.currentFrameIndex);
+            cv::Mat backgroundImage(height, width, CV_8UC1);
+            if (readReviewFrame(frameRing, shared, shared.currentFrameIndex, backgroundImage))
             {
                 std::lock_guard<std::mutex> lock(shared.backgroundFrameMutex);
-                shared.backgroundFrame = cv::Mat(height, width, CV_8UC1, backgroundImageData.data()).clone();
-                cv::GaussianBlur(shared.backgroundFrame, shared.blurredBackground, cv::Size(shared.processingConfig.gaussian_blur_size, shared.processingConfig.gaussian_blur_size), 0);
+                shared.backgroundFrame = backgroundImage;
+                // Blur into a new Mat: workers still hold the old one
+                cv::Mat blurred;
+                std::lock_guard<std::mutex> configLock(shared.processingConfigMutex);
+                cv::GaussianBlur(shared.backgroundFrame, blurred, cv::Size(shared.processingConfig.gaussian_blur_size, shared.processingConfig.gaussian_blur_size), 0);
+                shared.blurredBackground = blurred;
+                shared.backgroundVersion++;
             }
             shared.displayNeedsUpdate = true;
         }
@@ -889,6 +1145,10 @@ void keyboardHandlingThread(
         {
             shared.running = !shared.running;
         }
+        else if ((key == 'n' || key == 'N') && shared.stepFrame)
+        {
+            shared.stepFrame();
+        }
         shared.updated = true;
     };
 
@@ -896,13 +1156,12 @@ void keyboardHandlingThread(
     shared.keyboardCallback = handleKeypress;
 
     // Handle console input
+    ConsoleKeys console;
     while (!shared.done)
     {
-        if (_kbhit())
-        {
-            int ch = _getch();
+        int ch = console.poll();
+        if (ch >= 0)
             handleKeypress(ch);
-        }
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
     std::cout << "Keyboard handling thread interrupted." << std::endl;
@@ -959,6 +1218,33 @@ void resultSavingThread(SharedResources &shared, const std::string &saveDirector
     std::cout << "Result saving thread interrupted." << std::endl;
 }
 
+std::filesystem::path openSaveDirectory(SharedResources &shared, const std::filesystem::path &outputDir,
+                                        const std::string &saveDir)
+{
+    shared.saveDirectory = (outputDir / saveDir).string();
+    std::filesystem::path fullPath;
+    if (shared.saveDirName.empty())
+    {
+        // Automatically increment the directory name if it already exists
+        fullPath = outputDir / saveDir;
+        int suffix = 1;
+        while (std::filesystem::exists(fullPath))
+        {
+            fullPath = outputDir / (saveDir + "_" + std::to_string(suffix));
+            suffix++;
+        }
+        shared.saveDirName = fullPath.filename().string();
+    }
+    else
+    {
+        // A restart goes on in the directory of the run before it
+        fullPath = outputDir / shared.saveDirName;
+    }
+    std::filesystem::create_directories(fullPath);
+    shared.currentBatchNumber = nextBatchNumber(fullPath.string());
+    return fullPath;
+}
+
 void commonSampleLogic(SharedResources &shared, const std::string &SAVE_DIRECTORY,
                        std::function<std::vector<std::thread>(SharedResources &, const std::string &)> setupThreads)
 {
@@ -1008,14 +1294,22 @@ void commonSampleLogic(SharedResources &shared, const std::string &SAVE_DIRECTOR
     ProcessingConfig processingConfig = getProcessingConfig(config);
     std::string saveDir = config["save_directory"];
 
-    std::cout << "Current save directory: " << saveDir << std::endl;
-    std::cout << "Choose save directory option:\n";
-    std::cout << "1: Use current directory\n";
-    std::cout << "2: Enter new directory\n";
-    std::cout << "3: Use testing directory (will overwrite existing)\n";
-    std::cout << "Choice: ";
-    int choice;
-    std::cin >> choice;
+    // A restart after a camera window change keeps the directory chosen before
+    int choice = 1;
+    if (shared.saveDirName.empty())
+    {
+        std::cout << "Current save directory: " << saveDir << std::endl;
+        std::cout << "Choose save directory option:\n";
+        std::cout << "1: Use current directory\n";
+        std::cout << "2: Enter new directory\n";
+        std::cout << "3: Use testing directory (will overwrite existing)\n";
+        std::cout << "Choice: ";
+        std::cin >> choice;
+    }
+    else
+    {
+        saveDir = shared.saveDirName;
+    }
 
     if (choice == 2)
     {
@@ -1038,30 +1332,14 @@ void commonSampleLogic(SharedResources &shared, const std::string &SAVE_DIRECTOR
         updateConfig("config.json", "save_directory", saveDir);
     }
 
-    // Create full path within output directory
-    std::filesystem::path fullPath = outputDir / saveDir;
-    std::string basePath = fullPath.string();
-    shared.saveDirectory = basePath;
-
-    // Automatically increment the directory name if it already exists
-    int suffix = 1;
-    while (std::filesystem::exists(fullPath))
-    {
-        fullPath = outputDir / (saveDir + "_" + std::to_string(suffix));
-        suffix++;
-    }
-
-    // Create the subdirectory
-    std::filesystem::create_directories(fullPath);
-
+    std::filesystem::path fullPath = openSaveDirectory(shared, outputDir, saveDir);
     std::cout << "Using save directory: " << fullPath.string() << std::endl;
 
     // Call the setup function passed as parameter
     std::vector<std::thread> threads = setupThreads(shared, fullPath.string());
 
     // Wait for completion
-    shared.displayQueueCondition.notify_all();
-    shared.processingQueueCondition.notify_all();
+    shared.framesToProcess.wakeAll();
     shared.savingCondition.notify_all();
     std::cout << "Joining threads..." << std::endl;
     for (auto &thread : threads)
@@ -1070,29 +1348,179 @@ void commonSampleLogic(SharedResources &shared, const std::string &SAVE_DIRECTOR
     }
 }
 
+void publishFrame(SharedResources &shared, uint64_t sequence, uint64_t frameId)
+{
+    // Work items pushed out of a full queue: coalesced ones were passed
+    // over by the latest-only policy, the rest are dropped frames
+    size_t lost = shared.framesToProcess.push(FrameWorkItem{sequence, frameId});
+    if (lost > 0)
+        shared.frameLoss.count(shared.framesToProcess.options().policy == OverflowPolicy::CoalesceLatest
+                                   ? LossCause::Skipped
+                                   : LossCause::QueueDrop,
+                               lost);
+}
+
+void publishTelemetry(SharedResources &shared, const SourceTelemetry &telemetry)
+{
+    shared.currentFPS = telemetry.frameRate;
+    shared.dataRate = telemetry.dataRate;
+    shared.exposureTime = static_cast<uint64_t>(telemetry.exposureTime);
+    {
+        std::lock_guard<std::mutex> lock(shared.sourceTelemetryMutex);
+        shared.sourceTelemetry = telemetry;
+    }
+    shared.updated = true;
+}
+
+void telemetryPollerThread(SharedResources &shared, std::function<SourceTelemetry()> poll, std::chrono::milliseconds interval)
+{
+    // Yield to acquisition and processing whenever they want the core
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(SCHED_IDLE)
+    sched_param param{};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+    auto nextPoll = std::chrono::steady_clock::now();
+    while (!shared.done)
+    {
+        if (std::chrono::steady_clock::now() >= nextPoll)
+        {
+            try
+            {
+                publishTelemetry(shared, poll());
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Telemetry poll failed: " << e.what() << std::endl;
+            }
+            nextPoll = std::chrono::steady_clock::now() + interval;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+void printProcessingAudit(const SharedResources &shared)
+{
+    FrameLossSnapshot loss = shared.frameLoss.snapshot();
+    auto lost = [&](LossCause cause)
+    { return loss.lost[static_cast<size_t>(cause)]; };
+    uint64_t analysed = shared.framesAnalysed.load();
+    uint64_t accounted = analysed + lost(LossCause::Skipped) + lost(LossCause::RingOverwrite) + lost(LossCause::QueueDrop);
+    std::cout << "Processing audit: " << loss.received << " received = " << analysed << " analysed + "
+              << lost(LossCause::Skipped) << " skipped + " << lost(LossCause::RingOverwrite) << " overwritten + "
+              << lost(LossCause::QueueDrop) << " dropped";
+    if (loss.received > accounted)
+        std::cout << " + " << loss.received - accounted << " still queued at stop";
+    std::cout << std::endl;
+    if (shared.processingOrder)
+    {
+        printQueueStats("Processing queue", shared.framesToProcess.stats());
+        printReorderSummary(*shared.processingOrder);
+    }
+}
+
+void printQueueStats(const std::string &name, const BoundedQueueStats &stats)
+{
+    std::cout << name << ": " << stats.pushed << " pushed, high water " << stats.highWater << "/" << stats.capacity
+              << ", " << stats.dropped << " dropped, " << stats.coalesced << " coalesced" << std::endl;
+}
+
+void printReorderSummary(const ReorderBuffer<FrameVerdict> &order)
+{
+    std::cout << "Result order: at most " << order.maxHeld() << " verdicts held for an earlier frame, "
+              << order.stalls() << " workers stalled on a full window" << std::endl;
+}
+
+void printLatencyHistogram(const std::string &title, const std::vector<double> &samplesUs)
+{
+    if (samplesUs.empty())
+        return;
+    // Decades from 1 us to 100 ms
+    const char *labels[] = {"< 1 us", "1-10 us", "10-100 us", "0.1-1 ms", "1-10 ms", "10-100 ms", ">= 100 ms"};
+    size_t counts[7] = {};
+    double maxUs = 0.0;
+    for (double us : samplesUs)
+    {
+        size_t bin = 0;
+        for (double edge = 1.0; bin < 6 && us >= edge; edge *= 10.0)
+            ++bin;
+        ++counts[bin];
+        maxUs = std::max(maxUs, us);
+    }
+    std::cout << title << " (" << samplesUs.size() << " frames, max " << static_cast<int>(maxUs) << " us):" << std::endl;
+    for (size_t i = 0; i < 7; ++i)
+    {
+        if (counts[i] == 0)
+            continue;
+        double percent = 100.0 * counts[i] / samplesUs.size();
+        std::cout << "  " << std::setw(10) << labels[i] << " " << std::setw(8) << counts[i] << "  "
+                  << std::string(static_cast<size_t>(percent / 2.0) + 1, '#') << std::endl;
+    }
+}
+
 void setupCommonThreads(SharedResources &shared, const std::string &saveDir,
-                        const CircularBuffer &circularBuffer, const CircularBuffer &processingBuffer, const ImageParams &params,
-                        std::vector<std::thread> &threads)
+                        FrameRing &frameRing, const ImageParams &params,
+                        std::vector<std::thread> &threads, bool ringProcessing)
 {
-    // Create processing thread first and set its priority
-    threads.emplace_back(processingThreadTask,
-                         std::ref(shared.processingQueueMutex), std::ref(shared.processingQueueCondition),
-                         std::ref(shared.framesToProcess), std::ref(processingBuffer),
-                         params.width, params.height, std::ref(shared));
-    // Create remaining threads with normal priority
-    threads.emplace_back(displayThreadTask, std::ref(shared.framesToDisplay),
-                         std::ref(shared.displayQueueMutex), std::ref(circularBuffer),
-                         params.width, params.height, params.bufferCount, std::ref(shared));
+    // Every frame is pushed once; each consumer follows the ring with its own cursor
+    json config = readConfig("config.json");
+    shared.headless = config.value("headless", false);
+    shared.threadTopology = getThreadTopology(config);
+    printThreadTopology(shared.threadTopology);
+    const ThreadTopology &topology = shared.threadTopology;
+    size_t compressedHistoryMb = config["frame_ring"].value("compressed_history_mb", 0);
+    if (compressedHistoryMb > 0)
+    {
+        shared.compressedHistory = std::make_unique<CompressedHistory>(compressedHistoryMb << 20, params.imageSize);
+        size_t historyConsumer = frameRing.registerConsumer("history");
+        threads.emplace_back(historyThreadTask, std::ref(frameRing), historyConsumer, std::ref(shared));
+    }
+
+    // Create processing threads first. Every worker has its own Mats and
+    // pulls the next work item from the shared queue; verdicts are emitted
+    // in frame order.
+    // Every-frame processing holds at most a ring's worth of unanalysed
+    // frames, so its queue never has to block; latest-only keeps just the
+    // newest item.
+    if (ringProcessing)
+    {
+        ProcessingPolicy policy = getProcessingPolicy(config);
+        shared.framesToProcess.reset(getQueueOptions(
+            config, "processing_queue",
+            policy == ProcessingPolicy::EveryFrame
+                ? BoundedQueueOptions{frameRing.capacity(), OverflowPolicy::BlockWithTimeout}
+                : BoundedQueueOptions{1, OverflowPolicy::CoalesceLatest}));
+        size_t workerCount = std::max<size_t>(config["acquisition"].value("processing_workers", 1), 1);
+        size_t processingConsumer = frameRing.registerConsumer(
+            "processing", policy == ProcessingPolicy::EveryFrame ? ConsumerMode::Pinned : ConsumerMode::Lossy);
+        shared.processTrigger = false;
+        shared.nextProcessingTicket = 0;
+        shared.processingOrder = std::make_unique<ReorderBuffer<FrameVerdict>>(
+            reorderWindow(workerCount), [&shared](FrameVerdict &verdict)
+            { emitVerdict(shared, verdict); });
+        for (size_t w = 0; w < workerCount; ++w)
+            threads.push_back(placedThread(topology, ThreadRole::Processing, w, processingThreadTask,
+                                           std::ref(shared.processingQueueMutex), std::ref(shared.framesToProcess), std::ref(frameRing), processingConsumer, policy,
+                                           params.width, params.height, std::ref(shared)));
+    }
+    // Each thread takes its role's cores and priority from thread_topology
+    // before it starts work; unplaced roles keep the OS defaults
+    if (!shared.headless)
+    {
+        size_t displayConsumer = frameRing.registerConsumer("display");
+        threads.push_back(placedThread(topology, ThreadRole::Display, 0, displayThreadTask, std::ref(frameRing), displayConsumer,
+                                       params.width, params.height, frameRing.capacity(), std::ref(shared)));
+    }
 
     threads.emplace_back(keyboardHandlingThread,
-                         std::ref(circularBuffer), params.bufferCount, params.width, params.height, std::ref(shared));
+                         std::cref(frameRing), frameRing.capacity(), params.width, params.height, std::ref(shared));
 
-    threads.emplace_back(resultSavingThread, std::ref(shared), saveDir);
-    threads.emplace_back(metricDisplayThread, std::ref(shared));
+    threads.push_back(placedThread(topology, ThreadRole::Saver, 0, resultSavingThread, std::ref(shared), saveDir));
+    threads.push_back(placedThread(topology, ThreadRole::Metrics, 0, metricDisplayThread, std::ref(shared), std::cref(frameRing)));
 
     // Read from json to check if scatterplot is enabled
-    json config = readConfig("config.json");
-    bool scatterPlotEnabled = config.value("scatter_plot_enabled", false);
+    bool scatterPlotEnabled = config.value("scatter_plot_enabled", false) && !shared.headless;
 
     if (scatterPlotEnabled)
     {
@@ -1100,43 +1528,496 @@ void setupCommonThreads(SharedResources &shared, const std::string &saveDir,
     }
 }
 
-void temp_mockSample(const ImageParams &params, CircularBuffer &cameraBuffer, CircularBuffer &circularBuffer, CircularBuffer &processingBuffer, SharedResources &shared)
+void sourceSample(FrameSource &source, const ImageParams &params, FrameRing &frameRing, SharedResources &shared,
+                  const std::function<void(std::vector<std::thread> &)> &extraThreads)
 {
+    {
+        std::lock_guard<std::mutex> lock(shared.sourceTelemetryMutex);
+        shared.sourceName = source.name();
+        shared.sourceTelemetry = SourceTelemetry();
+    }
+    shared.stepFrame = [&source]()
+    { source.step(); };
+    shared.frameLoss.reset();
+    shared.framesAnalysed = 0;
+    shared.clockSync.reset();
+    shared.dispatchTimes.clear();
+    source.setLossTracker(&shared.frameLoss);
+    TelemetryOptions telemetry = getTelemetryOptions(readConfig("config.json"));
+    PixelUnpacker unpacker = frameUnpacker(params);
+    // The poller and the final totals may both ask; sources are not reentrant
+    std::mutex sourceTelemetryCall;
+    std::function<SourceTelemetry()> pollTelemetry = [&]()
+    {
+        std::lock_guard<std::mutex> lock(sourceTelemetryCall);
+        return source.telemetry();
+    };
     commonSampleLogic(shared, "default_save_directory", [&](SharedResources &shared, const std::string &saveDir)
                       {
                           std::vector<std::thread> threads;
-                          setupCommonThreads(shared, saveDir, circularBuffer, processingBuffer, params, threads);
-
-                          threads.emplace_back(simulateCameraThread,
-                                               std::ref(cameraBuffer), std::ref(shared), std::ref(params));
-
-                          size_t lastProcessedFrame = 0;
+                          setupCommonThreads(shared, saveDir, frameRing, params, threads);
+                          if (extraThreads)
+                              extraThreads(threads);
+
+                          // After the save prompt, so operator typing is not startup time
+                          frameRing.markAcquisitionStart();
+                          source.start();
+                          // Feature reads can take milliseconds over the control channel, so by
+                          // default they run on their own thread and this loop only moves frames
+                          if (!telemetry.onAcquisitionThread)
+                              threads.emplace_back(telemetryPollerThread, std::ref(shared), pollTelemetry, telemetry.interval);
+                          // The loop below is the acquisition thread, placed until it returns.
+                          // Threads inherit their creator's affinity and SCHED_FIFO, so
+                          // the source's and the poller's are started first.
+                          ScopedThreadPlacement placement(shared.threadTopology, ThreadRole::Acquisition);
+                          auto nextTelemetry = std::chrono::steady_clock::now();
+                          bool frameInHand = false;
+                          bool sourcePaused = false;
+                          auto workStart = std::chrono::steady_clock::now();
                           while (!shared.done)
                           {
                               if (shared.paused)
                               {
+                                  if (!sourcePaused)
+                                      source.pause();
+                                  sourcePaused = true;
                                   std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                  frameInHand = false;
                                   continue;
                               }
-                              size_t latestFrame = shared.latestCameraFrame.load(std::memory_order_acquire);
-                              if (latestFrame != lastProcessedFrame)
+                              if (sourcePaused)
+                                  source.resume();
+                              sourcePaused = false;
+
+                              if (telemetry.onAcquisitionThread && std::chrono::steady_clock::now() >= nextTelemetry)
+                              {
+                                  publishTelemetry(shared, pollTelemetry());
+                                  nextTelemetry = std::chrono::steady_clock::now() + telemetry.interval;
+                              }
+
+                              // Work done for the previous frame, up to asking for the next one
+                              if (frameInHand)
+                              {
+                                  shared.dispatchTimes.push(std::chrono::duration<double, std::micro>(
+                                                                std::chrono::steady_clock::now() - workStart)
+                                                                .count());
+                                  frameInHand = false;
+                              }
+
+                              FrameMeta meta;
+                              const uint8_t *imageData = source.nextFrame(meta);
+                              if (imageData == nullptr || !shared.frameLoss.observeFrameId(meta.frameId))
+                                  continue;
+                              meta.hostSteadyUs = steadyNowUs();
+                              shared.clockSync.observe(meta.cameraTimestamp, meta.hostSteadyUs);
+                              noteReloadFrame(shared, meta);
+                              workStart = std::chrono::steady_clock::now();
+                              frameInHand = true;
+                              // Frames above 8 bits are reduced on their way into the slot, no extra pass
+                              bool pushed = unpacker.passthrough()
+                                                ? frameRing.push(imageData, meta)
+                                                : frameRing.pushWith(meta, [&](uint8_t *slot)
+                                                                     { unpacker.unpack(imageData, slot, params.width); });
+                              if (!pushed)
+                              {
+                                  shared.frameLoss.count(LossCause::QueueDrop);
+                                  continue;
+                              }
+                              publishFrame(shared, frameRing.latestSequence(), meta.frameId);
+                          }
+                          source.stop();
+                          SourceTelemetry totals = pollTelemetry();
+                          std::cout << "Frame source '" << source.name() << "': " << totals.delivered << " delivered, "
+                                    << totals.coalesced << " coalesced, " << totals.dropped << " dropped" << std::endl;
+                          std::cout << "Frame loss: " << shared.frameLoss.summary() << std::endl;
+                          printProcessingAudit(shared);
+                          printLatencyHistogram("Acquisition loop work per frame", std::get<0>(shared.dispatchTimes.columns()));
+                          return threads; });
+    source.setLossTracker(nullptr);
+    shared.stepFrame = nullptr;
+}
+
+namespace
+{
+    // One producer's path to analysis: filled buffers wait in a handoff queue
+    // for a worker, which analyses them in place; a display-rate copy goes to
+    // the ring for display and review. The run flags (done, paused) come from
+    // control, so several pipelines can follow one keyboard.
+    class ProducerPipeline
+    {
+    public:
+        ProducerPipeline(BufferProducer &producer, const ImageParams &params, FrameRing &frameRing,
+                         SharedResources &shared, const SharedResources &control,
+                         size_t workerCount, const BufferPoolOptions &pool)
+            : producer_(producer), params_(params), frameRing_(frameRing), shared_(shared), control_(control),
+              workerCount_(std::max<size_t>(workerCount, 1)), unpacker_(frameUnpacker(params)),
+              handoffCapacity_(std::max<size_t>(producer.bufferCount() / 2, 1)),
+              order_(reorderWindow(workerCount_), [this](FrameVerdict &verdict)
+                     { emitVerdict(shared_, verdict); })
+        {
+            shared_.frameLoss.reset();
+            shared_.framesAnalysed = 0;
+            shared_.clockSync.reset();
+            producer_.setLossTracker(&shared_.frameLoss);
+            if (pool.adaptive)
+            {
+                sizer_ = std::make_unique<BufferPoolSizer>(pool, producer_.imageSize());
+                adapter_ = std::make_unique<BufferPoolAdapter>(producer_, *sizer_, shared_.frameLoss, serviceTimes_);
+            }
+        }
+
+        ~ProducerPipeline()
+        {
+            stop();
+            producer_.setLossTracker(nullptr);
+        }
+
+        void start()
+        {
+            // Cameras take consecutive processing cores; control holds the
+            // topology read by setupCommonThreads
+            const ThreadTopology &topology = control_.threadTopology;
+            for (size_t w = 0; w < workerCount_; ++w)
+                workers_.push_back(placedThread(topology, ThreadRole::Processing,
+                                                static_cast<size_t>(shared_.cameraId) * workerCount_ + w,
+                                                &ProducerPipeline::work, this));
+
+            acquisitionPlacement_ = std::make_unique<CallbackThreadPlacement>(topology, ThreadRole::Acquisition);
+            frameRing_.markAcquisitionStart();
+            producer_.start([this](AcquiredBuffer &&buffer)
+                            {
+                acquisitionPlacement_->enter();
+                AcquiredBuffer dropped;
+                {
+                    std::lock_guard<std::mutex> lock(handoffMutex_);
+                    if (!shared_.frameLoss.observeFrameId(buffer.meta().frameId))
+                        return;
+                    shared_.clockSync.observe(buffer.meta().cameraTimestamp, buffer.meta().hostSteadyUs);
+                    noteReloadFrame(shared_, buffer.meta());
+                    // Buffers stay owned by the producer, so the queue is capped well
+                    // below the pool size and the oldest frame is dropped (and its
+                    // buffer requeued) when it is full
+                    if (handoff_.size() >= handoffCapacity_)
+                    {
+                        dropped = std::move(handoff_.front());
+                        handoff_.pop_front();
+                        handoffDrops_++;
+                        shared_.frameLoss.count(LossCause::QueueDrop);
+                    }
+                    handoff_.push_back(std::move(buffer));
+                }
+                handoffCondition_.notify_one(); });
+        }
+
+        // Regrows an adaptive pool; call periodically while running
+        void poll()
+        {
+            if (adapter_)
+                adapter_->poll();
+        }
+
+        void stop()
+        {
+            if (workers_.empty())
+                return;
+            producer_.stop();
+            {
+                std::lock_guard<std::mutex> lock(handoffMutex_);
+                stopping_ = true;
+                handoff_.clear();
+            }
+            handoffCondition_.notify_all();
+            for (auto &worker : workers_)
+                worker.join();
+            workers_.clear();
+        }
+
+        void printSummary(const std::string &label) const
+        {
+            std::cout << label << ": " << producer_.delivered() << " frames delivered, "
+                      << handoffDrops_ << " dropped waiting for a worker, " << producer_.bufferCount()
+                      << " buffers, p99.9 hold " << static_cast<int>(producer_.holdTimeStats().p999) << " us, p99.9 service "
+                      << static_cast<int>(serviceTimes_.stats().p999) << " us" << std::endl;
+            std::cout << "Frame loss: " << shared_.frameLoss.summary() << std::endl;
+            printProcessingAudit(shared_);
+            printReorderSummary(order_);
+        }
+
+    private:
+        // The pixels processFrame reads: the ROI and the blur kernel around it
+        cv::Rect analysedWindow(const ProcessingSnapshot &snapshot) const
+        {
+            int margin = snapshot.config.gaussian_blur_size;
+            cv::Rect window(snapshot.roi.x - margin, snapshot.roi.y - margin,
+                            snapshot.roi.width + 2 * margin, snapshot.roi.height + 2 * margin);
+            return window & cv::Rect(0, 0, static_cast<int>(params_.width), static_cast<int>(params_.height));
+        }
+
+        void work()
+        {
+            cv::Mat processedImage(params_.height, params_.width, CV_8UC1);
+            ThreadLocalMats mats = initializeThreadMats(params_.height, params_.width, shared_);
+            // Frames above 8 bits: only the analysed window is unpacked per
+            // frame, the rest only for frames that are kept
+            cv::Mat unpacked(static_cast<int>(params_.height), static_cast<int>(params_.width), CV_8UC1);
+            const uint8_t *raw = nullptr;
+            std::function<void()> completeFrame;
+            if (!unpacker_.passthrough())
+                completeFrame = [&]()
+                { unpacker_.unpack(raw, unpacked.data, unpacked.step); };
+            while (true)
+            {
+                AcquiredBuffer buffer;
+                uint64_t ticket;
+                {
+                    std::unique_lock<std::mutex> lock(handoffMutex_);
+                    handoffCondition_.wait(lock, [&]()
+                                           { return !handoff_.empty() || stopping_; });
+                    if (handoff_.empty())
+                        break;
+                    buffer = std::move(handoff_.front());
+                    handoff_.pop_front();
+                    ticket = nextTicket_++;
+                }
+                int64_t dequeuedUs = steadyNowUs();
+                if (control_.paused)
+                {
+                    shared_.frameLoss.count(LossCause::Skipped);
+                    order_.skip(ticket);
+                    continue;
+                }
+
+                raw = buffer.data();
+                // One snapshot both picks the pixels to unpack and analyses them
+                ProcessingSnapshot snapshot = takeProcessingSnapshot(
+                    shared_, cv::Size(static_cast<int>(params_.width), static_cast<int>(params_.height)));
+                FrameVerdict verdict;
+                if (unpacker_.passthrough())
+                {
+                    cv::Mat image(static_cast<int>(params_.height), static_cast<int>(params_.width), CV_8UC1,
+                                  const_cast<uint8_t *>(raw));
+                    verdict = measureFrame(image, buffer.meta(), shared_, snapshot, processedImage, mats);
+                }
+                else
+                {
+                    cv::Rect window = analysedWindow(snapshot);
+                    unpacker_.unpackRegion(raw, unpacked.data, unpacked.step, window.x, window.y, window.width, window.height);
+                    verdict = measureFrame(unpacked, buffer.meta(), shared_, snapshot, processedImage, mats, completeFrame);
+                }
+                order_.complete(ticket, std::move(verdict));
+
+                // The ring only feeds display and review, at display rate
+                std::unique_lock<std::mutex> ringLock(ringMutex_, std::try_to_lock);
+                if (ringLock && std::chrono::steady_clock::now() >= nextRingPush_)
+                {
+                    nextRingPush_ = std::chrono::steady_clock::now() + std::chrono::microseconds(1000000 / 60);
+                    frameRing_.pushWith(buffer.meta(), [&](uint8_t *slot)
+                                        { unpacker_.unpack(raw, slot, params_.width); });
+                }
+                serviceTimes_.push(static_cast<double>(steadyNowUs() - dequeuedUs));
+            }
+        }
+
+        BufferProducer &producer_;
+        const ImageParams &params_;
+        FrameRing &frameRing_;
+        SharedResources &shared_;
+        const SharedResources &control_;
+        size_t workerCount_;
+        PixelUnpacker unpacker_;
+        // Sized from the starting pool, so it does not grow with the pool
+        size_t handoffCapacity_;
+        // Dequeue to requeue per buffer (us), what the pool is sized from
+        TypedRing<double> serviceTimes_{4096};
+        // Verdicts leave in the order the frames left the handoff queue
+        ReorderBuffer<FrameVerdict> order_;
+        uint64_t nextTicket_ = 0; // under handoffMutex_
+        std::unique_ptr<BufferPoolSizer> sizer_;
+        std::unique_ptr<BufferPoolAdapter> adapter_;
+        std::unique_ptr<CallbackThreadPlacement> acquisitionPlacement_;
+
+        std::deque<AcquiredBuffer> handoff_;
+        std::mutex handoffMutex_;
+        std::condition_variable handoffCondition_;
+        bool stopping_ = false;
+        std::atomic<uint64_t> handoffDrops_{0};
+
+        std::mutex ringMutex_;
+        std::chrono::steady_clock::time_point nextRingPush_;
+        std::vector<std::thread> workers_;
+    };
+}
+
+void producerSample(BufferProducer &producer, const ImageParams &params, FrameRing &frameRing, SharedResources &shared,
+                    size_t workerCount, const BufferPoolOptions &pool,
+                    const std::function<void(std::vector<std::thread> &)> &extraThreads)
+{
+    ProducerPipeline pipeline(producer, params, frameRing, shared, shared, workerCount, pool);
+    commonSampleLogic(shared, "default_save_directory", [&](SharedResources &shared, const std::string &saveDir)
+                      {
+                          std::vector<std::thread> threads;
+                          setupCommonThreads(shared, saveDir, frameRing, params, threads, false);
+                          if (extraThreads)
+                              extraThreads(threads);
+
+                          pipeline.start();
+                          while (!shared.done)
+                          {
+                              std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                              pipeline.poll();
+                          }
+                          pipeline.stop();
+                          pipeline.printSummary("Callback acquisition");
+                          return threads; });
+}
+
+void multiCameraSample(std::vector<CameraChannel> &cameras, size_t workersPerCamera, const BufferPoolOptions &pool,
+                       const std::function<void(std::vector<std::thread> &)> &extraThreads)
+{
+    if (cameras.empty())
+        throw std::invalid_argument("Multi-camera sampling needs at least one camera");
+
+    SharedResources &control = *cameras.front().shared;
+    control.otherCameras.clear();
+    std::vector<std::unique_ptr<ProducerPipeline>> pipelines;
+    for (size_t i = 0; i < cameras.size(); ++i)
+    {
+        CameraChannel &camera = cameras[i];
+        camera.shared->cameraId = camera.cameraId;
+        if (i > 0)
+        {
+            // Only camera 0 has display windows; the others are analysed and counted
+            camera.shared->headless = true;
+            camera.shared->resultSink = &control;
+            control.otherCameras.push_back(camera.shared.get());
+        }
+        pipelines.push_back(std::make_unique<ProducerPipeline>(*camera.producer, camera.params, *camera.frameRing,
+                                                               *camera.shared, control, workersPerCamera, pool));
+    }
+
+    commonSampleLogic(control, "default_save_directory", [&](SharedResources &shared, const std::string &saveDir)
+                      {
+                          std::vector<std::thread> threads;
+                          setupCommonThreads(shared, saveDir, *cameras.front().frameRing, cameras.front().params, threads, false);
+                          if (extraThreads)
+                              extraThreads(threads);
+
+                          for (auto &pipeline : pipelines)
+                              pipeline->start();
+                          while (!shared.done)
+                          {
+                              std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                              for (auto &pipeline : pipelines)
+                                  pipeline->poll();
+                          }
+                          for (size_t i = 0; i < pipelines.size(); ++i)
+                          {
+                              pipelines[i]->stop();
+                              pipelines[i]->printSummary("Camera " + std::to_string(cameras[i].cameraId));
+                          }
+                          return threads; });
+    control.otherCameras.clear();
+}
+
+void ringAcquisitionSample(BufferProducer &producer, const ImageParams &params, FrameRing &frameRing, SharedResources &shared,
+                           size_t queueDepth, const std::function<void(std::vector<std::thread> &)> &extraThreads)
+{
+    // Handles of the frames currently published in the ring, by slot. The ring
+    // drops a handle (requeueing the slot to the producer) once no reader can
+    // still see that frame. Readers can outlive this function, so the state is
+    // shared with the requeue callback and closed on shutdown.
+    struct HeldSlots
+    {
+        std::mutex mutex;
+        std::vector<AcquiredBuffer> buffers;
+        bool closed = false;
+    };
+    // The ring is read as 8-bit frames, so the grabber has to deliver them
+    if (!frameUnpacker(params).passthrough())
+        throw std::invalid_argument("Ring acquisition needs Mono8 frames without black/white levels; the camera sends " +
+                                    PixelUnpacker::formatName(params.pixelFormat) + ", use the callback mode");
+    auto held = std::make_shared<HeldSlots>();
+    held->buffers.resize(frameRing.capacity());
+
+    frameRing.attachAcquisition(queueDepth, [held, &producer](size_t slot)
+                                {
+        AcquiredBuffer buffer;
+        {
+            std::lock_guard<std::mutex> lock(held->mutex);
+            if (held->closed)
+                return;
+            // A slot that never held a frame was left out of the initial queue
+            if (!held->buffers[slot])
+            {
+                producer.queueExternal(slot);
+                return;
+            }
+            buffer = std::move(held->buffers[slot]);
+        }
+        buffer.release(); });
+
+    // The grabber now writes straight into the ring slots
+    uint8_t *base = frameRing.slotData(0);
+    const size_t stride = frameRing.storage().stride();
+    producer.announceExternal(base, stride, frameRing.capacity(), queueDepth);
+    shared.frameLoss.reset();
+    shared.framesAnalysed = 0;
+    shared.clockSync.reset();
+    producer.setLossTracker(&shared.frameLoss);
+
+    commonSampleLogic(shared, "default_save_directory", [&](SharedResources &shared, const std::string &saveDir)
+                      {
+                          std::vector<std::thread> threads;
+                          setupCommonThreads(shared, saveDir, frameRing, params, threads);
+                          if (extraThreads)
+                              extraThreads(threads);
+
+                          std::mutex commitMutex;
+                          CallbackThreadPlacement acquisitionPlacement(shared.threadTopology, ThreadRole::Acquisition);
+                          frameRing.markAcquisitionStart();
+                          producer.start([&](AcquiredBuffer &&buffer)
+                                         {
+                              acquisitionPlacement.enter();
+                              size_t slot = static_cast<size_t>(buffer.data() - base) / stride;
+                              FrameMeta meta = buffer.meta();
+                              {
+                                  std::lock_guard<std::mutex> lock(commitMutex);
+                                  if (!shared.frameLoss.observeFrameId(meta.frameId))
+                                      return; // the handle requeues the slot
+                                  shared.clockSync.observe(meta.cameraTimestamp, meta.hostSteadyUs);
+                              }
+                              noteReloadFrame(shared, meta);
                               {
-                                  const uint8_t *imageData = cameraBuffer.getPointer(latestFrame);
-                                  if (imageData != nullptr)
-                                  {
-                                      circularBuffer.push(imageData);
-                                      processingBuffer.push(imageData);
-                                      {
-                                          std::lock_guard<std::mutex> displayLock(shared.displayQueueMutex);
-                                          std::lock_guard<std::mutex> processingLock(shared.processingQueueMutex);
-                                          shared.framesToProcess.push(latestFrame);
-                                          shared.framesToDisplay.push(latestFrame);
-                                      }
-                                      shared.displayQueueCondition.notify_one();
-                                      shared.processingQueueCondition.notify_one();
-                                      lastProcessedFrame = latestFrame;
-                                  }
+                                  std::lock_guard<std::mutex> lock(held->mutex);
+                                  held->buffers[slot] = std::move(buffer);
                               }
+                              uint64_t sequence = 0;
+                              {
+                                  // CallbackMultiThread may deliver concurrently; the ring has one writer
+                                  std::lock_guard<std::mutex> lock(commitMutex);
+                                  frameRing.commit(slot, meta);
+                                  sequence = frameRing.latestSequence();
+                              }
+                              publishFrame(shared, sequence, meta.frameId); });
+
+                          while (!shared.done)
+                          {
+                              std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                          }
+
+                          producer.stop();
+                          std::vector<AcquiredBuffer> remaining;
+                          {
+                              std::lock_guard<std::mutex> lock(held->mutex);
+                              held->closed = true;
+                              remaining.swap(held->buffers);
                           }
+                          remaining.clear();
+
+                          std::cout << "Ring acquisition: " << producer.delivered() << " frames delivered, "
+                                    << frameRing.requeueStalls() << " requeue stalls on held frames" << std::endl;
+                          std::cout << "Frame loss: " << shared.frameLoss.summary() << std::endl;
+                          printProcessingAudit(shared);
                           return threads; });
+    producer.setLossTracker(nullptr);
 }
@@ -7,6 +7,7 @@
 #include <future>
 #include <vector>
 #include "menu_system/menu_system.h"
+#include <PFNC.h>
 
 ImageParams initializeImageParams(const std::string &directory)
 {
@@ -24,7 +25,7 @@ ImageParams initializeImageParams(const std::string &directory)
             {
                 params.width = image.cols;
                 params.height = image.rows;
-                params.pixelFormat = image.type();
+                params.pixelFormat = PFNC_Mono8; // read as IMREAD_GRAYSCALE
                 params.imageSize = image.total() * image.elemSize();
                 return params;
             }
@@ -34,6 +35,17 @@ ImageParams initializeImageParams(const std::string &directory)
     throw std::runtime_error("No valid TIFF images found in the directory");
 }
 
+ImageParams initializeSourceParams(const FrameSource &source)
+{
+    ImageParams params;
+    params.width = source.width();
+    params.height = source.height();
+    params.pixelFormat = PFNC_Mono8; // replay sources yield 8-bit frames
+    params.imageSize = source.imageSize();
+    params.bufferCount = 5000;
+    return params;
+}
+
 void loadImages(const std::string &directory, CircularBuffer &cameraBuffer, bool reverseOrder)
 {
     std::vector<std::filesystem::path> imagePaths;
@@ -86,6 +98,45 @@ void initializeMockBackgroundFrame(SharedResources &shared, const ImageParams &p
     std::cout << "Background frame initialized from loaded image at index: " << selectedIndex << std::endl;
 }
 
+namespace
+{
+    // Background, ROI and frame loss of one camera
+    void saveCameraMetadata(const std::string &directory, const SharedResources &camera)
+    {
+        std::filesystem::create_directories(directory);
+
+        // Save clean background
+        cv::imwrite(directory + "/background_clean.png", camera.backgroundFrame);
+
+        // Save ROI coordinates to CSV
+        cv::Rect roi;
+        {
+            std::lock_guard<std::mutex> lock(camera.roiMutex);
+            roi = camera.roi;
+        }
+        std::ofstream roiFile(directory + "/roi.csv");
+        roiFile << "x,y,width,height\n";
+        roiFile << roi.x << ","
+                << roi.y << ","
+                << roi.width << ","
+                << roi.height;
+        roiFile.close();
+
+        // Save frame loss so far, by cause, with the per-second loss rate
+        FrameLossSnapshot loss = camera.frameLoss.snapshot();
+        json lossJson;
+        lossJson["received"] = loss.received;
+        lossJson["lost"] = loss.totalLost();
+        lossJson["loss_percent"] = loss.lossPercent();
+        for (size_t i = 0; i < loss.lost.size(); ++i)
+            lossJson["causes"][FrameLossTracker::causeName(static_cast<LossCause>(i))] = loss.lost[i];
+        lossJson["loss_rate_per_second"] = camera.frameLoss.lossRateHistory();
+        std::ofstream lossFile(directory + "/frame_loss.json");
+        lossFile << std::setw(4) << lossJson << std::endl;
+        lossFile.close();
+    }
+}
+
 void saveQualifiedResultsToDisk(const std::vector<QualifiedResult> &results, const std::string &directory, const SharedResources &shared)
 {
     std::string batchDir = directory + "/batch_" + std::to_string(shared.currentBatchNumber);
@@ -97,22 +148,15 @@ void saveQualifiedResultsToDisk(const std::vector<QualifiedResult> &results, con
     std::ofstream imageFile(batchDir + "/images.bin", std::ios::binary);
 
     // Write CSV header
-    csvFile << "Timestamp_us,Deformability,Area\n";
+    csvFile << "Timestamp_us,Deformability,Area,FrameId,CameraTimestamp,CameraId\n";
 
     // Add this block to save both background images
     if (!results.empty())
     {
-        // Save clean background
-        cv::imwrite(batchDir + "/background_clean.png", shared.backgroundFrame);
-
-        // Save ROI coordinates to CSV
-        std::ofstream roiFile(batchDir + "/roi.csv");
-        roiFile << "x,y,width,height\n";
-        roiFile << shared.roi.x << ","
-                << shared.roi.y << ","
-                << shared.roi.width << ","
-                << shared.roi.height;
-        roiFile.close();
+        // Camera 0 at the top level as before, other cameras in camera_<id>/
+        saveCameraMetadata(batchDir, shared);
+        for (const SharedResources *camera : shared.otherCameras)
+            saveCameraMetadata(batchDir + "/camera_" + std::to_string(camera->cameraId), *camera);
 
         // Save processing configuration
         json config = readConfig("config.json");
@@ -126,7 +170,10 @@ void saveQualifiedResultsToDisk(const std::vector<QualifiedResult> &results, con
         // Write data to CSV
         csvFile << result.timestamp << ","
                 << result.deformability << ","
-                << result.area << "\n";
+                << result.area << ","
+                << result.frameId << ","
+                << result.cameraTimestamp << ","
+                << result.cameraId << "\n";
 
         // Save image metadata and data (unchanged)
         int rows = result.originalImage.rows;
@@ -154,6 +201,21 @@ void saveQualifiedResultsToDisk(const std::vector<QualifiedResult> &results, con
     // std::cout << "Saved " << results.size() << " results to " << batchDir << std::endl;
 }
 
+int nextBatchNumber(const std::string &directory)
+{
+    int next = 0;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        std::string name = entry.path().filename().string();
+        if (!entry.is_directory() || name.compare(0, 6, "batch_") != 0 || name.size() == 6 ||
+            name.find_first_not_of("0123456789", 6) != std::string::npos)
+            continue;
+        next = std::max(next, std::stoi(name.substr(6)) + 1);
+    }
+    return next;
+}
+
 void convertSavedImagesToStandardFormat(const std::string &binaryImageFile, const std::string &outputDirectory)
 {
     std::ifstream imageFile(binaryImageFile, std::ios::binary);
@@ -195,12 +257,80 @@ json readConfig(const std::string &filename)
             {"area_threshold_min", 100},
             {"area_threshold_max", 600}};
 
+        json frame_ring = {
+            {"alignment", 64},
+            {"huge_pages", "off"},
+            {"lock_memory", false},
+            {"prefault", true},
+            {"history_file", ""},
+            {"history_frames", 0},
+            {"compressed_history_mb", 0},
+            {"processing_policy", "latest_only"}};
+
+        json replay = {
+            {"mode", "realtime"},
+            {"overrun", "queue"},
+            {"max_backlog", 64}};
+
+        json buffer_pool = {
+            {"adaptive", true},
+            {"memory_budget_mb", 256},
+            {"min_buffers", 4},
+            {"max_buffers", 4096},
+            {"latency_allowance_us", 2000},
+            {"headroom", 2.0},
+            {"benchmark_counts", {2, 4, 8, 16, 32, 64, 128}},
+            {"benchmark_seconds", 3}};
+
+        json telemetry = {
+            {"poll_ms", 500},
+            {"poll_on_acquisition_thread", false}};
+
+        json camera_roi = {
+            {"enabled", false},
+            {"frame_rate", 0}};
+
+        json trigger = {
+            {"delay_us", 0}};
+
+        json placement = {
+            {"cores", json::array()},
+            {"priority", 0}};
+        json thread_topology = {
+            {"acquisition", placement},
+            {"trigger", placement},
+            {"processing", placement},
+            {"saver", placement},
+            {"display", placement},
+            {"metrics", placement}};
+
+        json acquisition = {
+            {"mode", "pull"},
+            {"buffer_count", 64},
+            {"processing_workers", 1},
+            {"queue_depth", 16},
+            {"source", "directory"},
+            {"synthetic_width", 512},
+            {"synthetic_height", 96},
+            {"camera_count", 1},
+            {"black_level", 0},
+            {"white_level", 0}};
+
         config = {
             {"save_directory", "updated_results"},
             {"buffer_threshold", 1000},
             {"target_fps", 5000},
             {"scatter_plot_enabled", false},
-            {"image_processing", image_processing}};
+            {"headless", false},
+            {"image_processing", image_processing},
+            {"frame_ring", frame_ring},
+            {"acquisition", acquisition},
+            {"replay", replay},
+            {"buffer_pool", buffer_pool},
+            {"telemetry", telemetry},
+            {"camera_roi", camera_roi},
+            {"trigger", trigger},
+            {"thread_topology", thread_topology}};
 
         // Write default config to file
         std::ofstream configFile(filename);
@@ -235,6 +365,135 @@ json readConfig(const std::string &filename)
         if (!img_config.contains("area_threshold_max"))
             img_config["area_threshold_max"] = 600;
 
+        if (!config.contains("frame_ring"))
+        {
+            config["frame_ring"] = json::object();
+        }
+
+        auto &ring_config = config["frame_ring"];
+        if (!ring_config.contains("alignment"))
+            ring_config["alignment"] = 64;
+        if (!ring_config.contains("huge_pages"))
+            ring_config["huge_pages"] = "off";
+        if (!ring_config.contains("lock_memory"))
+            ring_config["lock_memory"] = false;
+        if (!ring_config.contains("prefault"))
+            ring_config["prefault"] = true;
+        if (!ring_config.contains("history_file"))
+            ring_config["history_file"] = "";
+        if (!ring_config.contains("history_frames"))
+            ring_config["history_frames"] = 0;
+        if (!ring_config.contains("compressed_history_mb"))
+            ring_config["compressed_history_mb"] = 0;
+        if (!ring_config.contains("processing_policy"))
+            ring_config["processing_policy"] = "latest_only";
+
+        if (!config.contains("acquisition"))
+        {
+            config["acquisition"] = json::object();
+        }
+
+        auto &acquisition_config = config["acquisition"];
+        if (!acquisition_config.contains("mode"))
+            acquisition_config["mode"] = "pull";
+        if (!acquisition_config.contains("buffer_count"))
+            acquisition_config["buffer_count"] = 64;
+        if (!acquisition_config.contains("processing_workers"))
+            acquisition_config["processing_workers"] = 1;
+        if (!acquisition_config.contains("queue_depth"))
+            acquisition_config["queue_depth"] = 16;
+        if (!acquisition_config.contains("source"))
+            acquisition_config["source"] = "directory";
+        if (!acquisition_config.contains("synthetic_width"))
+            acquisition_config["synthetic_width"] = 512;
+        if (!acquisition_config.contains("synthetic_height"))
+            acquisition_config["synthetic_height"] = 96;
+        if (!acquisition_config.contains("camera_count"))
+            acquisition_config["camera_count"] = 1;
+        if (!acquisition_config.contains("black_level"))
+            acquisition_config["black_level"] = 0;
+        if (!acquisition_config.contains("white_level"))
+            acquisition_config["white_level"] = 0;
+
+        if (!config.contains("replay"))
+        {
+            config["replay"] = json::object();
+        }
+
+        auto &replay_config = config["replay"];
+        if (!replay_config.contains("mode"))
+            replay_config["mode"] = "realtime";
+        if (!replay_config.contains("overrun"))
+            replay_config["overrun"] = "queue";
+        if (!replay_config.contains("max_backlog"))
+            replay_config["max_backlog"] = 64;
+
+        if (!config.contains("buffer_pool"))
+        {
+            config["buffer_pool"] = json::object();
+        }
+
+        auto &pool_config = config["buffer_pool"];
+        if (!pool_config.contains("adaptive"))
+            pool_config["adaptive"] = true;
+        if (!pool_config.contains("memory_budget_mb"))
+            pool_config["memory_budget_mb"] = 256;
+        if (!pool_config.contains("min_buffers"))
+            pool_config["min_buffers"] = 4;
+        if (!pool_config.contains("max_buffers"))
+            pool_config["max_buffers"] = 4096;
+        if (!pool_config.contains("latency_allowance_us"))
+            pool_config["latency_allowance_us"] = 2000;
+        if (!pool_config.contains("headroom"))
+            pool_config["headroom"] = 2.0;
+        if (!pool_config.contains("benchmark_counts"))
+            pool_config["benchmark_counts"] = {2, 4, 8, 16, 32, 64, 128};
+        if (!pool_config.contains("benchmark_seconds"))
+            pool_config["benchmark_seconds"] = 3;
+
+        if (!config.contains("telemetry"))
+        {
+            config["telemetry"] = json::object();
+        }
+
+        auto &telemetry_config = config["telemetry"];
+        if (!telemetry_config.contains("poll_ms"))
+            telemetry_config["poll_ms"] = 500;
+        if (!telemetry_config.contains("poll_on_acquisition_thread"))
+            telemetry_config["poll_on_acquisition_thread"] = false;
+
+        if (!config.contains("camera_roi"))
+        {
+            config["camera_roi"] = json::object();
+        }
+
+        auto &camera_roi_config = config["camera_roi"];
+        if (!camera_roi_config.contains("enabled"))
+            camera_roi_config["enabled"] = false;
+        if (!camera_roi_config.contains("frame_rate"))
+            camera_roi_config["frame_rate"] = 0;
+
+        if (!config.contains("trigger"))
+        {
+            config["trigger"] = json::object();
+        }
+
+        auto &trigger_config = config["trigger"];
+        if (!trigger_config.contains("delay_us"))
+            trigger_config["delay_us"] = 0;
+
+        if (!config.contains("thread_topology"))
+        {
+            config["thread_topology"] = json::object();
+        }
+
+        auto &topology_config = config["thread_topology"];
+        for (const char *role : {"acquisition", "trigger", "processing", "saver", "display", "metrics"})
+        {
+            if (!topology_config.contains(role))
+                topology_config[role] = {{"cores", json::array()}, {"priority", 0}};
+        }
+
         // Write back the complete config to ensure file has all fields
         std::ofstream outFile(filename);
         outFile << std::setw(4) << config << std::endl;
@@ -255,6 +514,230 @@ ProcessingConfig getProcessingConfig(const json &config)
         img_config["area_threshold_max"]};
 }
 
+FrameStorageOptions getFrameStorageOptions(const json &config)
+{
+    FrameStorageOptions options;
+    if (!config.contains("frame_ring"))
+        return options;
+
+    const auto &ring_config = config["frame_ring"];
+    options.alignment = ring_config.value("alignment", 64);
+    std::string hugePages = ring_config.value("huge_pages", "off");
+    if (hugePages == "transparent")
+        options.hugePages = HugePageMode::Transparent;
+    else if (hugePages == "explicit")
+        options.hugePages = HugePageMode::Explicit;
+    options.lockMemory = ring_config.value("lock_memory", false);
+    options.prefaultInBackground = ring_config.value("prefault", true);
+    options.backingFile = ring_config.value("history_file", "");
+    // Slots are written by the acquisition thread, so they live on its node
+    ThreadTopology topology = getThreadTopology(config);
+    if (!topology.acquisition.cores.empty())
+        options.numaNode = numaNodeOfCore(topology.acquisition.cores.front());
+    // Slots announced to the grabber as DMA targets start on page boundaries
+    if (config.contains("acquisition") && config["acquisition"].value("mode", "pull") == "ring")
+        options.alignment = std::max<size_t>(options.alignment, 4096);
+    return options;
+}
+
+ReplayOptions getReplayOptions(const json &config)
+{
+    ReplayOptions options;
+    options.targetFps = config.value("target_fps", 5000.0);
+    if (!config.contains("replay"))
+        return options;
+
+    const auto &replay_config = config["replay"];
+    std::string mode = replay_config.value("mode", "realtime");
+    if (mode == "unpaced")
+        options.mode = ReplayMode::Unpaced;
+    else if (mode == "step")
+        options.mode = ReplayMode::Step;
+    if (replay_config.value("overrun", "queue") == "latest")
+        options.overrun = ReplayOverrun::Latest;
+    options.maxBacklog = replay_config.value("max_backlog", 64);
+    options.spinWindow = std::chrono::microseconds(replay_config.value("spin_us", static_cast<int64_t>(options.spinWindow.count())));
+    return options;
+}
+
+BufferPoolOptions getBufferPoolOptions(const json &config)
+{
+    BufferPoolOptions options;
+    if (!config.contains("buffer_pool"))
+        return options;
+
+    const auto &pool_config = config["buffer_pool"];
+    options.adaptive = pool_config.value("adaptive", options.adaptive);
+    options.memoryBudgetBytes = pool_config.value("memory_budget_mb", static_cast<size_t>(256)) << 20;
+    options.minBuffers = pool_config.value("min_buffers", options.minBuffers);
+    options.maxBuffers = pool_config.value("max_buffers", options.maxBuffers);
+    options.latencyAllowanceUs = pool_config.value("latency_allowance_us", options.latencyAllowanceUs);
+    options.headroom = pool_config.value("headroom", options.headroom);
+    return options;
+}
+
+TelemetryOptions getTelemetryOptions(const json &config)
+{
+    TelemetryOptions options;
+    if (!config.contains("telemetry"))
+        return options;
+
+    const auto &telemetry_config = config["telemetry"];
+    options.interval = std::chrono::milliseconds(std::max<int64_t>(telemetry_config.value("poll_ms", 500), 10));
+    options.onAcquisitionThread = telemetry_config.value("poll_on_acquisition_thread", false);
+    return options;
+}
+
+CameraRoiOptions getCameraRoiOptions(const json &config)
+{
+    CameraRoiOptions options;
+    if (!config.contains("camera_roi"))
+        return options;
+
+    const auto &camera_roi_config = config["camera_roi"];
+    options.enabled = camera_roi_config.value("enabled", false);
+    options.frameRate = std::max(camera_roi_config.value("frame_rate", 0.0), 0.0);
+    return options;
+}
+
+TriggerOptions getTriggerOptions(const json &config)
+{
+    TriggerOptions options;
+    if (!config.contains("trigger"))
+        return options;
+
+    options.delayUs = std::max<int64_t>(config["trigger"].value("delay_us", static_cast<int64_t>(0)), 0);
+    return options;
+}
+
+ThreadTopology getThreadTopology(const json &config)
+{
+    ThreadTopology topology;
+    if (!config.contains("thread_topology"))
+        return topology;
+
+    const auto &topology_config = config["thread_topology"];
+    auto read = [&](const char *role, ThreadPlacement &placement)
+    {
+        if (!topology_config.contains(role))
+            return;
+        placement.cores = topology_config[role].value("cores", std::vector<int>());
+        placement.priority = std::clamp(topology_config[role].value("priority", 0), 0, 99);
+    };
+    read("acquisition", topology.acquisition);
+    read("trigger", topology.trigger);
+    read("processing", topology.processing);
+    read("saver", topology.saver);
+    read("display", topology.display);
+    read("metrics", topology.metrics);
+    // Each camera runs its own workers
+    if (config.contains("acquisition"))
+    {
+        const auto &acquisition_config = config["acquisition"];
+        int cameraCount = acquisition_config.value("camera_count", 1);
+        topology.processingThreads = std::max<size_t>(acquisition_config.value("processing_workers", 1), 1) *
+                                     static_cast<size_t>(std::max(cameraCount, 1));
+    }
+    return topology;
+}
+
+PixelNormalization getPixelNormalization(const json &config)
+{
+    PixelNormalization levels;
+    if (!config.contains("acquisition"))
+        return levels;
+
+    const auto &acquisition_config = config["acquisition"];
+    levels.black = static_cast<uint16_t>(std::clamp(acquisition_config.value("black_level", 0), 0, 0xFFFF));
+    levels.white = static_cast<uint16_t>(std::clamp(acquisition_config.value("white_level", 0), 0, 0xFFFF));
+    return levels;
+}
+
+PixelUnpacker frameUnpacker(const ImageParams &params)
+{
+    return PixelUnpacker(params.pixelFormat, params.width, params.height, params.levels, params.otherFormats);
+}
+
+bool useMultiCamera(const json &config)
+{
+    if (!config.contains("acquisition"))
+        return false;
+    const auto &acquisition_config = config["acquisition"];
+    int cameraCount = acquisition_config.value("camera_count", 1);
+    if (cameraCount == 1)
+        return false;
+    std::string mode = acquisition_config.value("mode", "pull");
+    if (mode != "callback")
+        std::cout << "acquisition.camera_count is " << cameraCount << ": running callback mode instead of "
+                  << mode << " mode" << std::endl;
+    return true;
+}
+
+size_t getInitialBufferCount(const json &config, double frameRate, size_t imageSize)
+{
+    BufferPoolOptions options = getBufferPoolOptions(config);
+    if (!options.adaptive)
+        return config["acquisition"].value("buffer_count", 64);
+    size_t count = BufferPoolSizer(options, imageSize).initialCount(frameRate);
+    std::cout << "Buffer pool: " << count << " buffers for " << static_cast<int>(frameRate) << " fps" << std::endl;
+    return count;
+}
+
+size_t getFrameRingCapacity(const json &config, size_t bufferCount)
+{
+    // A file-backed ring is sized by the history it should hold, not by RAM
+    if (!config.contains("frame_ring"))
+        return bufferCount;
+    const auto &ring_config = config["frame_ring"];
+    if (ring_config.value("history_file", "").empty())
+        return bufferCount;
+    // Never fewer slots than the in-memory ring would have
+    size_t historyFrames = ring_config.value("history_frames", 0);
+    if (historyFrames < bufferCount)
+    {
+        std::cout << "frame_ring.history_frames " << historyFrames << " is below the ring capacity, using "
+                  << bufferCount << std::endl;
+        return bufferCount;
+    }
+    return historyFrames;
+}
+
+size_t getSecondaryRingCapacity(const json &config)
+{
+    size_t workers = 1;
+    if (config.contains("acquisition"))
+        workers = std::max<size_t>(config["acquisition"].value("processing_workers", 1), 1);
+    return std::max<size_t>(4 * workers, 16);
+}
+
+ProcessingPolicy getProcessingPolicy(const json &config)
+{
+    if (!config.contains("frame_ring"))
+        return ProcessingPolicy::LatestOnly;
+    if (config["frame_ring"].value("processing_policy", "latest_only") == "every_frame")
+        return ProcessingPolicy::EveryFrame;
+    return ProcessingPolicy::LatestOnly;
+}
+
+BoundedQueueOptions getQueueOptions(const json &config, const std::string &name, const BoundedQueueOptions &defaults)
+{
+    BoundedQueueOptions options = defaults;
+    if (!config.contains("frame_ring") || !config["frame_ring"].contains(name))
+        return options;
+
+    const auto &queue_config = config["frame_ring"][name];
+    std::string policy = queue_config.value("policy", "");
+    if (policy == "drop_oldest")
+        options.policy = OverflowPolicy::DropOldest;
+    else if (policy == "latest")
+        options.policy = OverflowPolicy::CoalesceLatest;
+    else if (policy == "block")
+        options.policy = OverflowPolicy::BlockWithTimeout;
+    options.capacity = std::max<size_t>(queue_config.value("capacity", options.capacity), 1);
+    options.timeout = std::chrono::microseconds(queue_config.value("timeout_us", static_cast<int64_t>(options.timeout.count())));
+    return options;
+}
+
 bool updateConfig(const std::string &filename, const std::string &key, const json &value)
 {
     try
@@ -360,7 +843,10 @@ void reviewSavedData()
         }
 
         // Initialize shared resources
-        shared.roi = cv::Rect(roiValues[0], roiValues[1], roiValues[2], roiValues[3]);
+        {
+            std::lock_guard<std::mutex> lock(shared.roiMutex);
+            shared.roi = cv::Rect(roiValues[0], roiValues[1], roiValues[2], roiValues[3]);
+        }
         cv::GaussianBlur(backgroundClean, shared.blurredBackground, cv::Size(3, 3), 0);
 
         return backgroundClean;
@@ -422,7 +908,8 @@ void reviewSavedData()
                 values.push_back(value);
             }
 
-            if (values.size() == 3)
+            // Older batches only have the first three columns
+            if (values.size() >= 3)
             {
                 measurements.emplace_back(
                     std::stoll(values[0]),
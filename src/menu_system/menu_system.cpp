@@ -1,6 +1,7 @@
 #include <iostream>
 #include <string>
 #include <limits>
+#include <iomanip>
 #include "image_processing/image_processing.h"
 #include "CircularBuffer/CircularBuffer.h"
 #include "menu_system/menu_system.h"
@@ -11,6 +12,7 @@
 #include <ftxui/component/screen_interactive.hpp>
 #include <filesystem>
 #include "mib_grabber/mib_grabber.h"
+#include "mib_grabber/MockBufferProducer.h"
 
 namespace MenuSystem
 {
@@ -207,25 +209,125 @@ namespace MenuSystem
         configure_js("egrabberConfig.js");
     }
 
-    void runMockSample()
+    std::unique_ptr<ReplayFrameSource> selectReplaySource(const nlohmann::json &config)
     {
+        const auto &acquisition = config["acquisition"];
+        std::string kind = acquisition.value("source", "directory");
+        ReplayOptions replay = getReplayOptions(config);
+
+        if (kind == "synthetic")
+        {
+            return ReplayFrameSource::synthetic(acquisition.value("synthetic_width", 512),
+                                                acquisition.value("synthetic_height", 96), 256, replay);
+        }
+        if (kind == "images_bin")
+        {
+            std::cout << "Select the images.bin file:\n";
+            std::string path = navigateAndSelectFile();
+            if (path.empty())
+                return nullptr;
+            return ReplayFrameSource::fromImagesBin(path, replay);
+        }
 
         std::cout << "Select the image directory:\n";
         std::string imageDirectory = navigateAndSelectFolder();
+        if (imageDirectory.empty())
+            return nullptr;
+        return ReplayFrameSource::fromDirectory(imageDirectory, replay);
+    }
+
+    // Several mock cameras side by side, each with its own ring and workers.
+    // Synthetic cameras get different cycle lengths so their cells fall out of
+    // step; replayed frames are shared by all of them.
+    void runMockMultiCameraSample(const json &config, ReplayFrameSource &source, int cameraCount)
+    {
+        const auto &acquisition = config["acquisition"];
+        double fps = config.value("target_fps", 5000.0);
+        ReplayOptions replay = getReplayOptions(config);
+
+        std::vector<std::unique_ptr<ReplayFrameSource>> sources;
+        std::vector<std::unique_ptr<MockBufferProducer>> producers;
+        std::vector<CameraChannel> cameras;
+        for (int i = 0; i < cameraCount; ++i)
+        {
+            ReplayFrameSource *cameraSource = &source;
+            if (i > 0 && source.name() == "synthetic")
+            {
+                sources.push_back(ReplayFrameSource::synthetic(source.width(), source.height(), 256 + 37 * i, replay));
+                cameraSource = sources.back().get();
+            }
 
+            CameraChannel camera;
+            camera.cameraId = i;
+            camera.params = initializeSourceParams(*cameraSource);
+            producers.push_back(std::make_unique<MockBufferProducer>(
+                cameraSource->frames(), camera.params.imageSize,
+                getInitialBufferCount(config, fps, camera.params.imageSize), fps));
+            camera.producer = producers.back().get();
+            // Only camera 0's ring holds the configured history
+            FrameStorageOptions storage = getFrameStorageOptions(config);
+            if (i > 0)
+                storage.backingFile.clear();
+            size_t capacity = i == 0 ? getFrameRingCapacity(config, camera.params.bufferCount) : getSecondaryRingCapacity(config);
+            camera.frameRing = std::make_unique<FrameRing>(capacity, camera.params.imageSize, storage);
+            camera.shared = std::make_unique<SharedResources>();
+            initializeMockBackgroundFrame(*camera.shared, camera.params, cameraSource->frames());
+            camera.shared->roi = cv::Rect(0, 0, static_cast<int>(camera.params.width), static_cast<int>(camera.params.height));
+            cameras.push_back(std::move(camera));
+        }
+
+        multiCameraSample(cameras, acquisition.value("processing_workers", 1), getBufferPoolOptions(config));
+        for (size_t i = 0; i < producers.size(); ++i)
+            std::cout << "Camera " << i << " frames lost with no buffer queued: " << producers[i]->starved() << std::endl;
+    }
+
+    void runMockSample()
+    {
         try
         {
-            ImageParams params = initializeImageParams(imageDirectory);
-            CircularBuffer cameraBuffer(params.bufferCount, params.imageSize);
-            CircularBuffer circularBuffer(params.bufferCount, params.imageSize);
-            CircularBuffer processingBuffer(params.bufferCount, params.imageSize);
-            loadImages(imageDirectory, cameraBuffer, true);
+            json ringConfig = readConfig("config.json");
+            std::unique_ptr<ReplayFrameSource> source = selectReplaySource(ringConfig);
+            if (!source)
+                return;
+            const auto &acquisition = ringConfig["acquisition"];
+            std::string mode = acquisition.value("mode", "pull");
+            if (useMultiCamera(ringConfig))
+            {
+                // There is no discovery to take every camera from
+                int cameraCount = acquisition.value("camera_count", 1);
+                if (cameraCount <= 0)
+                    throw std::runtime_error("Mock sampling needs acquisition.camera_count above 0");
+                runMockMultiCameraSample(ringConfig, *source, cameraCount);
+                std::cout << "Mock sampling completed.\n";
+                return;
+            }
+
+            ImageParams params = initializeSourceParams(*source);
+            FrameRing frameRing(getFrameRingCapacity(ringConfig, params.bufferCount), params.imageSize,
+                                getFrameStorageOptions(ringConfig));
 
             SharedResources shared;
-            initializeMockBackgroundFrame(shared, params, cameraBuffer);
+            initializeMockBackgroundFrame(shared, params, source->frames());
             shared.roi = cv::Rect(0, 0, static_cast<int>(params.width), static_cast<int>(params.height));
 
-            temp_mockSample(params, cameraBuffer, circularBuffer, processingBuffer, shared);
+            if (mode == "callback" || mode == "ring")
+            {
+                // Exercise the callback acquisition path without a frame grabber
+                double fps = ringConfig.value("target_fps", 5000.0);
+                size_t bufferCount = mode == "ring" ? acquisition.value("buffer_count", 64)
+                                                    : getInitialBufferCount(ringConfig, fps, params.imageSize);
+                MockBufferProducer producer(source->frames(), params.imageSize, bufferCount, fps);
+                if (mode == "ring")
+                    ringAcquisitionSample(producer, params, frameRing, shared, acquisition.value("queue_depth", 16));
+                else
+                    producerSample(producer, params, frameRing, shared, acquisition.value("processing_workers", 1),
+                                   getBufferPoolOptions(ringConfig));
+                std::cout << "Frames lost with no buffer queued: " << producer.starved() << std::endl;
+            }
+            else
+            {
+                sourceSample(*source, params, frameRing, shared);
+            }
 
             std::cout << "Mock sampling completed.\n";
         }
@@ -235,6 +337,68 @@ namespace MenuSystem
         }
     }
 
+    void runBufferPoolBenchmark()
+    {
+        try
+        {
+            json config = readConfig("config.json");
+            std::unique_ptr<ReplayFrameSource> source = selectReplaySource(config);
+            if (!source)
+                return;
+            ImageParams params = initializeSourceParams(*source);
+            SharedResources shared;
+            shared.headless = true;
+            initializeMockBackgroundFrame(shared, params, source->frames());
+            // A full-frame ROI skips the analysis, so leave a small margin
+            shared.roi = cv::Rect(2, 2, static_cast<int>(params.width) - 4, static_cast<int>(params.height) - 4);
+
+            // Each worker analyses frames in place, as in callback mode
+            const int height = static_cast<int>(params.height);
+            const int width = static_cast<int>(params.width);
+            auto consume = [&](const AcquiredBuffer &buffer)
+            {
+                thread_local cv::Mat processedImage;
+                thread_local std::unique_ptr<ThreadLocalMats> mats;
+                if (!mats)
+                {
+                    processedImage.create(height, width, CV_8UC1);
+                    mats = std::make_unique<ThreadLocalMats>(initializeThreadMats(height, width, shared));
+                }
+                cv::Mat image(height, width, CV_8UC1, const_cast<uint8_t *>(buffer.data()));
+                analyzeFrame(image, buffer.meta(), shared, processedImage, *mats);
+            };
+
+            const auto &pool = config["buffer_pool"];
+            std::vector<size_t> counts = pool.value("benchmark_counts", std::vector<size_t>{2, 4, 8, 16, 32, 64, 128});
+            double fps = config.value("target_fps", 5000.0);
+            std::cout << "Sweeping " << counts.size() << " buffer counts at " << fps << " fps..." << std::endl;
+            std::vector<PoolSweepResult> results = sweepBufferPool(
+                source->frames(), params.imageSize, fps, counts, config["acquisition"].value("processing_workers", 1),
+                std::chrono::seconds(pool.value("benchmark_seconds", 3)), consume);
+
+            std::cout << std::setw(8) << "Buffers" << std::setw(10) << "MB" << std::setw(12) << "Received"
+                      << std::setw(10) << "Lost" << std::setw(10) << "Loss %" << std::setw(16) << "p99.9 hold us" << std::endl;
+            for (const auto &result : results)
+            {
+                std::cout << std::setw(8) << result.bufferCount
+                          << std::setw(10) << (result.bufferCount * params.imageSize) / (1 << 20)
+                          << std::setw(12) << result.received << std::setw(10) << result.lost
+                          << std::setw(10) << std::fixed << std::setprecision(3) << result.lossPercent
+                          << std::setw(16) << std::setprecision(0) << result.holdP999Us << std::endl;
+            }
+            if (!results.empty())
+            {
+                BufferPoolSizer sizer(getBufferPoolOptions(config), params.imageSize);
+                std::cout << "Adaptive sizing would pick " << sizer.target(1e6 / fps, results.back().holdP999Us)
+                          << " buffers for the p99.9 hold time at " << results.back().bufferCount << " buffers" << std::endl;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
     void runLiveSample()
     {
         // Placeholder for live sampling implementation
@@ -311,6 +475,7 @@ namespace MenuSystem
             "Convert Saved Images",
             "EGrabber Config",
             "EGrabber Hot Reload",
+            "Buffer Pool Benchmark",
             "Exit"};
 
         auto menu = Menu(&entries, &selected);
@@ -363,6 +528,9 @@ namespace MenuSystem
                 egrabberHotReload();
                 break;
             case 7:
+                runBufferPoolBenchmark();
+                break;
+            case 8:
                 std::cout << "Exiting program.\n";
                 return 0;
             }
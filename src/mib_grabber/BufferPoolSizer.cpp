@@ -0,0 +1,164 @@
+#include "mib_grabber/BufferPoolSizer.h"
+#include "mib_grabber/MockBufferProducer.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+BufferPoolSizer::BufferPoolSizer(const BufferPoolOptions &options, size_t imageSize)
+    : options_(options)
+{
+    if (imageSize == 0 || options_.minBuffers == 0 || options_.headroom < 1.0)
+        throw std::invalid_argument("Buffer pool needs a payload size, a minimum and headroom >= 1");
+    maxCount_ = std::min(options_.maxBuffers, options_.memoryBudgetBytes / imageSize);
+    if (maxCount_ < options_.minBuffers)
+        throw std::invalid_argument("Buffer pool memory budget does not fit the minimum buffer count");
+}
+
+size_t BufferPoolSizer::target(double frameIntervalUs, double consumerLatencyUs) const
+{
+    if (!(frameIntervalUs > 0.0))
+        return options_.minBuffers;
+    // Frames that arrive while one buffer is held, plus the one being filled
+    double inFlight = std::ceil(std::max(consumerLatencyUs, 0.0) / frameIntervalUs) + 1.0;
+    double wanted = std::ceil(inFlight * options_.headroom);
+    if (wanted >= static_cast<double>(maxCount_))
+        return maxCount_;
+    return std::max(options_.minBuffers, static_cast<size_t>(wanted));
+}
+
+size_t BufferPoolSizer::initialCount(double frameRate) const
+{
+    return target(frameRate > 0.0 ? 1e6 / frameRate : 0.0, options_.latencyAllowanceUs);
+}
+
+size_t BufferPoolSizer::grow(size_t current, double frameIntervalUs, double consumerP999Us) const
+{
+    size_t wanted = target(frameIntervalUs, consumerP999Us);
+    if (wanted > current && wanted >= current * options_.growThreshold)
+        return wanted;
+    // Close to the budget, grow to it rather than stop just short
+    if (wanted == maxCount_ && wanted > current)
+        return wanted;
+    return current;
+}
+
+BufferPoolAdapter::BufferPoolAdapter(BufferProducer &producer, const BufferPoolSizer &sizer, const FrameLossTracker &loss,
+                                     const TypedRing<double> &serviceTimes)
+    : producer_(producer), sizer_(sizer), loss_(loss), serviceTimes_(serviceTimes), lastPoll_(std::chrono::steady_clock::now())
+{
+}
+
+void BufferPoolAdapter::poll()
+{
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - lastPoll_).count();
+    if (seconds < 1.0)
+        return;
+
+    // Frames the camera sent, whether or not a buffer was free for them
+    FrameLossSnapshot loss = loss_.snapshot();
+    uint64_t arrived = loss.received + loss.lost[static_cast<size_t>(LossCause::CameraGap)];
+    uint64_t frames = arrived - lastArrived_;
+    uint64_t queueDrops = loss.lost[static_cast<size_t>(LossCause::QueueDrop)];
+    bool dropping = queueDrops > lastQueueDrops_;
+    lastArrived_ = arrived;
+    lastQueueDrops_ = queueDrops;
+    lastPoll_ = now;
+
+    // The workers are slower than the camera; buffers would only fill up
+    if (dropping != heldBack_)
+        std::cout << (dropping ? "Buffer pool growth paused: frames dropped waiting for a worker"
+                               : "Buffer pool growth resumed") << std::endl;
+    heldBack_ = dropping;
+    RollingStatsSnapshot service = serviceTimes_.stats();
+    if (frames == 0 || service.count == 0 || dropping)
+        return;
+    size_t current = producer_.bufferCount();
+    size_t wanted = sizer_.grow(current, seconds * 1e6 / frames, service.p999);
+    if (wanted == current)
+        return;
+    try
+    {
+        producer_.growPool(wanted);
+        std::cout << "Buffer pool grown from " << current << " to " << wanted << " (p99.9 service "
+                  << static_cast<int>(service.p999) << " us at " << static_cast<int>(frames / seconds) << " fps)" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Buffer pool not grown: " << e.what() << std::endl;
+    }
+}
+
+std::vector<PoolSweepResult> sweepBufferPool(const CircularBuffer &frames, size_t imageSize, double fps,
+                                             const std::vector<size_t> &counts, size_t workers,
+                                             std::chrono::milliseconds duration,
+                                             const std::function<void(const AcquiredBuffer &)> &consume)
+{
+    std::vector<PoolSweepResult> results;
+    for (size_t count : counts)
+    {
+        MockBufferProducer producer(frames, imageSize, count, fps);
+        FrameLossTracker loss;
+        producer.setLossTracker(&loss);
+
+        // Unbounded handoff, so every loss is a frame that found no free buffer
+        std::deque<AcquiredBuffer> handoff;
+        std::mutex handoffMutex;
+        std::condition_variable handoffCondition;
+        bool done = false;
+
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < std::max<size_t>(workers, 1); ++w)
+        {
+            threads.emplace_back([&]()
+                                 {
+                while (true)
+                {
+                    AcquiredBuffer buffer;
+                    {
+                        std::unique_lock<std::mutex> lock(handoffMutex);
+                        handoffCondition.wait(lock, [&]()
+                                              { return !handoff.empty() || done; });
+                        if (handoff.empty())
+                            break;
+                        buffer = std::move(handoff.front());
+                        handoff.pop_front();
+                    }
+                    consume(buffer);
+                } });
+        }
+
+        producer.start([&](AcquiredBuffer &&buffer)
+                       {
+            {
+                std::lock_guard<std::mutex> lock(handoffMutex);
+                loss.observeFrameId(buffer.meta().frameId);
+                handoff.push_back(std::move(buffer));
+            }
+            handoffCondition.notify_one(); });
+        std::this_thread::sleep_for(duration);
+        producer.stop();
+        {
+            std::lock_guard<std::mutex> lock(handoffMutex);
+            done = true;
+        }
+        handoffCondition.notify_all();
+        for (auto &thread : threads)
+            thread.join();
+
+        FrameLossSnapshot snapshot = loss.snapshot();
+        PoolSweepResult result;
+        result.bufferCount = count;
+        result.received = snapshot.received;
+        result.lost = snapshot.totalLost();
+        result.lossPercent = snapshot.lossPercent();
+        result.holdP999Us = producer.holdTimeStats().p999;
+        results.push_back(result);
+    }
+    return results;
+}
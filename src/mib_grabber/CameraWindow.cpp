@@ -0,0 +1,114 @@
+#include "mib_grabber/CameraWindow.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    int64_t integerOr(const CameraFeatures &camera, const std::string &name, int64_t fallback)
+    {
+        try
+        {
+            return camera.getInteger(name);
+        }
+        catch (const std::exception &)
+        {
+            return fallback;
+        }
+    }
+
+    int64_t roundDown(int64_t value, int64_t increment)
+    {
+        return value / increment * increment;
+    }
+
+    int64_t roundUp(int64_t value, int64_t increment)
+    {
+        return (value + increment - 1) / increment * increment;
+    }
+}
+
+CameraWindow readCameraWindow(const CameraFeatures &camera)
+{
+    CameraWindow window;
+    window.width = camera.getInteger("Width");
+    window.height = camera.getInteger("Height");
+    window.offsetX = integerOr(camera, "OffsetX", 0);
+    window.offsetY = integerOr(camera, "OffsetY", 0);
+    return window;
+}
+
+CameraWindowLimits readCameraWindowLimits(const CameraFeatures &camera)
+{
+    CameraWindowLimits limits;
+    limits.widthMax = camera.getInteger("WidthMax");
+    limits.heightMax = camera.getInteger("HeightMax");
+    limits.widthMin = std::max<int64_t>(integerOr(camera, "Width.Min", 1), 1);
+    limits.heightMin = std::max<int64_t>(integerOr(camera, "Height.Min", 1), 1);
+    limits.widthInc = std::max<int64_t>(integerOr(camera, "Width.Inc", 1), 1);
+    limits.heightInc = std::max<int64_t>(integerOr(camera, "Height.Inc", 1), 1);
+    limits.offsetXInc = std::max<int64_t>(integerOr(camera, "OffsetX.Inc", 1), 1);
+    limits.offsetYInc = std::max<int64_t>(integerOr(camera, "OffsetY.Inc", 1), 1);
+    return limits;
+}
+
+CameraWindow alignCameraWindow(const CameraWindow &request, const CameraWindowLimits &limits)
+{
+    if (limits.widthMax <= 0 || limits.heightMax <= 0)
+        throw std::invalid_argument("Camera window limits need the sensor size");
+
+    // Offsets snap down and the far edges up, so the window only ever grows
+    auto alignAxis = [](int64_t offset, int64_t size, int64_t sizeMin, int64_t sizeMax,
+                        int64_t sizeInc, int64_t offsetInc, int64_t &alignedOffset, int64_t &alignedSize)
+    {
+        offset = std::clamp<int64_t>(offset, 0, sizeMax - 1);
+        int64_t end = std::clamp<int64_t>(offset + std::max<int64_t>(size, 1), offset + 1, sizeMax);
+        alignedOffset = roundDown(offset, offsetInc);
+        alignedSize = std::max(roundUp(end - alignedOffset, sizeInc), roundUp(sizeMin, sizeInc));
+        if (alignedSize > sizeMax)
+            alignedSize = roundDown(sizeMax, sizeInc);
+        // Pushed off the far edge by rounding: slide back onto the sensor
+        if (alignedOffset + alignedSize > sizeMax)
+            alignedOffset = roundDown(sizeMax - alignedSize, offsetInc);
+    };
+
+    CameraWindow aligned;
+    alignAxis(request.offsetX, request.width, limits.widthMin, limits.widthMax,
+              limits.widthInc, limits.offsetXInc, aligned.offsetX, aligned.width);
+    alignAxis(request.offsetY, request.height, limits.heightMin, limits.heightMax,
+              limits.heightInc, limits.offsetYInc, aligned.offsetY, aligned.height);
+    return aligned;
+}
+
+CameraWindowChange applyCameraWindow(const CameraFeatures &camera, const CameraWindow &target, double frameRate)
+{
+    CameraWindowChange change;
+    change.before = readCameraWindow(camera);
+    change.frameRateBefore = camera.getFloat("AcquisitionFrameRate");
+
+    // A larger window cannot run at the current rate, so drop it first
+    bool grows = target.width > change.before.width || target.height > change.before.height;
+    if (grows)
+        camera.setFloat("AcquisitionFrameRate", camera.getFloat("AcquisitionFrameRate.Min"));
+
+    // Shrink, then move, then grow, so offset + size stays on the sensor
+    if (target.width < change.before.width)
+        camera.setInteger("Width", target.width);
+    if (target.height < change.before.height)
+        camera.setInteger("Height", target.height);
+    if (target.offsetX != change.before.offsetX)
+        camera.setInteger("OffsetX", target.offsetX);
+    if (target.offsetY != change.before.offsetY)
+        camera.setInteger("OffsetY", target.offsetY);
+    if (target.width > change.before.width)
+        camera.setInteger("Width", target.width);
+    if (target.height > change.before.height)
+        camera.setInteger("Height", target.height);
+
+    // The maximum now reflects the new window
+    double maxRate = camera.getFloat("AcquisitionFrameRate.Max");
+    camera.setFloat("AcquisitionFrameRate", frameRate > 0 ? std::min(frameRate, maxRate) : maxRate);
+
+    change.after = readCameraWindow(camera);
+    change.frameRateAfter = camera.getFloat("AcquisitionFrameRate");
+    return change;
+}
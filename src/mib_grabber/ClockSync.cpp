@@ -0,0 +1,98 @@
+#include "mib_grabber/ClockSync.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+ClockSync::ClockSync(const ClockSyncOptions &options)
+    : options_(options)
+{
+    if (options_.blockFrames == 0 || options_.blockCount < 2)
+        throw std::invalid_argument("ClockSync needs at least one frame per block and two blocks");
+}
+
+void ClockSync::observe(uint64_t cameraUs, int64_t hostSteadyUs)
+{
+    if (cameraUs == 0)
+        return;
+    int64_t delta = hostSteadyUs - static_cast<int64_t>(cameraUs);
+    if (blockFill_ == 0 || delta < blockMin_.delta)
+        blockMin_ = {cameraUs, delta};
+    if (++blockFill_ < options_.blockFrames)
+        return;
+    blockFill_ = 0;
+
+    if (!minima_.empty())
+    {
+        const Sample &last = minima_.back();
+        std::lock_guard<std::mutex> lock(estimateMutex_);
+        double predicted = estimate_.valid ? estimate_.hostUs(blockMin_.cameraUs) - static_cast<double>(blockMin_.cameraUs)
+                                           : static_cast<double>(last.delta);
+        if (blockMin_.cameraUs <= last.cameraUs || std::abs(blockMin_.delta - predicted) > options_.jumpUs)
+        {
+            minima_.clear();
+            ++resyncs_;
+        }
+    }
+    minima_.push_back(blockMin_);
+    if (minima_.size() > options_.blockCount)
+        minima_.pop_front();
+    fit();
+}
+
+void ClockSync::fit()
+{
+    // Least squares of delta against camera time, both relative to the
+    // newest minimum so the doubles keep their precision
+    const Sample &reference = minima_.back();
+    double n = static_cast<double>(minima_.size());
+    double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+    for (const Sample &sample : minima_)
+    {
+        double x = static_cast<double>(static_cast<int64_t>(sample.cameraUs - reference.cameraUs));
+        double y = static_cast<double>(sample.delta - reference.delta);
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+    }
+    double denominator = n * sumXX - sumX * sumX;
+    double slope = denominator > 0 ? (n * sumXY - sumX * sumY) / denominator : 0.0;
+    double intercept = (sumY - slope * sumX) / n;
+
+    double residual = 0;
+    for (const Sample &sample : minima_)
+    {
+        double x = static_cast<double>(static_cast<int64_t>(sample.cameraUs - reference.cameraUs));
+        double y = static_cast<double>(sample.delta - reference.delta);
+        residual = std::max(residual, std::abs(y - (intercept + slope * x)));
+    }
+
+    std::lock_guard<std::mutex> lock(estimateMutex_);
+    estimate_.valid = true;
+    estimate_.cameraReferenceUs = reference.cameraUs;
+    estimate_.offsetUs = static_cast<double>(reference.delta) + intercept;
+    estimate_.driftPpm = slope * 1e6;
+    estimate_.residualUs = residual;
+    estimate_.blocks = minima_.size();
+}
+
+void ClockSync::reset()
+{
+    blockFill_ = 0;
+    minima_.clear();
+    std::lock_guard<std::mutex> lock(estimateMutex_);
+    estimate_ = ClockEstimate();
+    resyncs_ = 0;
+}
+
+ClockEstimate ClockSync::estimate() const
+{
+    std::lock_guard<std::mutex> lock(estimateMutex_);
+    return estimate_;
+}
+
+uint64_t ClockSync::resyncs() const
+{
+    std::lock_guard<std::mutex> lock(estimateMutex_);
+    return resyncs_;
+}
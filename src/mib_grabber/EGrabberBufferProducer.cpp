@@ -0,0 +1,116 @@
+#include "mib_grabber/EGrabberBufferProducer.h"
+#include "mib_grabber/EGrabberFrameSource.h"
+
+using namespace Euresys;
+
+EGrabberBufferProducer::EGrabberBufferProducer(const EGrabberCameraInfo &camera, size_t bufferCount)
+    : EGrabber<CallbackMultiThread>(camera), bufferCount_(bufferCount)
+{
+    // Tag each buffer with its index so a released handle can find it again
+    for (size_t i = 0; i < bufferCount; ++i)
+    {
+        BufferIndexRange range = announceAndQueue(GenTLMemory(0, reinterpret_cast<void *>(i)));
+        announced_ = BufferIndexRange(i == 0 ? range.begin : announced_.begin, range.end);
+    }
+    inFlight_.resize(bufferCount);
+    width_ = getWidth();
+    height_ = getHeight();
+    imageSize_ = getPayloadSize();
+    pixelFormat_ = grabberPixelFormat(*this);
+    enableEvent<NewBufferData>();
+}
+
+EGrabberBufferProducer::~EGrabberBufferProducer()
+{
+    // Callbacks use members of this class, so stop them before it is torn down
+    shutdown();
+}
+
+void EGrabberBufferProducer::start(FrameCallback onFrame)
+{
+    onFrame_ = std::move(onFrame);
+    EGrabber<CallbackMultiThread>::start();
+}
+
+void EGrabberBufferProducer::stop()
+{
+    EGrabber<CallbackMultiThread>::stop();
+}
+
+void EGrabberBufferProducer::announceExternal(uint8_t *base, size_t stride, size_t count, size_t queued)
+{
+    if (count == 0 || stride < imageSize_)
+        throw std::invalid_argument("External buffers must hold a full payload");
+    revoke(announced_);
+    // UserMemoryArray buffers carry no user pointer; the index is recovered
+    // from BUFFER_INFO_BASE instead
+    announced_ = announceAndQueue(UserMemoryArray(UserMemory(base, stride * count), stride));
+    // Keep only the first queued buffers in the input fifo; not acquiring yet
+    if (queued < count)
+        resetBufferQueue(BufferIndexRange(announced_.begin, announced_.begin + queued));
+    externalBase_ = base;
+    externalStride_ = stride;
+    bufferCount_ = count;
+    std::lock_guard<std::mutex> lock(inFlightMutex_);
+    inFlight_.assign(count, NewBufferData());
+}
+
+void EGrabberBufferProducer::growPool(size_t count)
+{
+    if (externalBase_ != nullptr)
+        throw std::logic_error("Cannot grow a pool of external buffers");
+    size_t current = bufferCount_.load(std::memory_order_relaxed);
+    if (count <= current)
+        return;
+    {
+        // Slots first, so a new buffer is never delivered without one
+        std::lock_guard<std::mutex> lock(inFlightMutex_);
+        inFlight_.resize(count);
+    }
+    for (size_t i = current; i < count; ++i)
+    {
+        BufferIndexRange range = announceAndQueue(GenTLMemory(0, reinterpret_cast<void *>(i)));
+        announced_ = BufferIndexRange(announced_.begin, range.end);
+        bufferCount_.store(i + 1, std::memory_order_release);
+    }
+}
+
+void EGrabberBufferProducer::onNewBufferEvent(const NewBufferData &data)
+{
+    Buffer buffer(data);
+    uint8_t *base = buffer.getInfo<uint8_t *>(*this, gc::BUFFER_INFO_BASE);
+    size_t index = externalBase_ != nullptr ? static_cast<size_t>(base - externalBase_) / externalStride_
+                                            : reinterpret_cast<size_t>(buffer.getUserPointer());
+    if (buffer.getInfo<bool>(*this, gc::BUFFER_INFO_IS_INCOMPLETE) || index >= bufferCount_.load(std::memory_order_acquire))
+    {
+        if (loss_)
+            loss_->count(LossCause::Incomplete);
+        buffer.push(*this);
+        return;
+    }
+
+    FrameMeta meta;
+    meta.frameId = buffer.getInfo<uint64_t>(*this, gc::BUFFER_INFO_FRAMEID);
+    meta.cameraTimestamp = buffer.getInfo<uint64_t>(*this, gc::BUFFER_INFO_TIMESTAMP);
+    meta.sizeFilled = buffer.getInfo<size_t>(*this, gc::BUFFER_INFO_SIZE_FILLED);
+    {
+        std::lock_guard<std::mutex> lock(inFlightMutex_);
+        inFlight_[index] = data;
+    }
+    onFrame_(deliver(index, base, meta));
+}
+
+void EGrabberBufferProducer::queueExternal(size_t index)
+{
+    queue(BufferIndexRange(announced_.begin + index, announced_.begin + index + 1));
+}
+
+void EGrabberBufferProducer::requeue(size_t index)
+{
+    NewBufferData data;
+    {
+        std::lock_guard<std::mutex> lock(inFlightMutex_);
+        data = inFlight_[index];
+    }
+    Buffer(data).push(*this);
+}
@@ -0,0 +1,78 @@
+#include "mib_grabber/EGrabberFrameSource.h"
+
+using namespace Euresys;
+
+namespace
+{
+    // Bounded so the dispatcher can notice shutdown while the camera is idle
+    const uint64_t POP_TIMEOUT_MS = 100;
+}
+
+EGrabberFrameSource::EGrabberFrameSource(EGrabber<CallbackOnDemand> &grabber, size_t width, size_t height, size_t imageSize)
+    : grabber_(grabber), width_(width), height_(height), imageSize_(imageSize)
+{
+}
+
+EGrabberFrameSource::~EGrabberFrameSource()
+{
+    releaseCurrent();
+}
+
+void EGrabberFrameSource::start()
+{
+    grabber_.start();
+}
+
+void EGrabberFrameSource::stop()
+{
+    releaseCurrent();
+    grabber_.stop();
+}
+
+void EGrabberFrameSource::releaseCurrent()
+{
+    if (holding_)
+    {
+        Buffer(current_).push(grabber_);
+        holding_ = false;
+    }
+}
+
+const uint8_t *EGrabberFrameSource::nextFrame(FrameMeta &meta)
+{
+    releaseCurrent();
+    try
+    {
+        current_ = grabber_.pop(POP_TIMEOUT_MS);
+    }
+    catch (const gentl_error &e)
+    {
+        if (e.gc_err == gc::GC_ERR_TIMEOUT)
+            return nullptr;
+        throw;
+    }
+    holding_ = true;
+
+    Buffer buffer(current_);
+    if (buffer.getInfo<bool>(grabber_, gc::BUFFER_INFO_IS_INCOMPLETE))
+    {
+        ++incomplete_;
+        if (loss_)
+            loss_->count(LossCause::Incomplete);
+        return nullptr;
+    }
+
+    meta.frameId = buffer.getInfo<uint64_t>(grabber_, gc::BUFFER_INFO_FRAMEID);
+    meta.cameraTimestamp = buffer.getInfo<uint64_t>(grabber_, gc::BUFFER_INFO_TIMESTAMP);
+    meta.sizeFilled = buffer.getInfo<size_t>(grabber_, gc::BUFFER_INFO_SIZE_FILLED);
+    ++delivered_;
+    return buffer.getInfo<uint8_t *>(grabber_, gc::BUFFER_INFO_BASE);
+}
+
+SourceTelemetry EGrabberFrameSource::telemetry()
+{
+    SourceTelemetry result = readGrabberTelemetry(grabber_);
+    result.delivered = delivered_.load(std::memory_order_relaxed);
+    result.dropped = incomplete_.load(std::memory_order_relaxed);
+    return result;
+}
@@ -0,0 +1,149 @@
+#include "mib_grabber/FrameLossTracker.h"
+#include <algorithm>
+#include <sstream>
+
+namespace
+{
+    const char *CAUSE_NAMES[] = {"camera_gap", "incomplete", "duplicate", "ring_overwrite", "queue_drop", "skipped"};
+
+    size_t causeIndex(LossCause cause) { return static_cast<size_t>(cause); }
+}
+
+uint64_t FrameLossSnapshot::totalLost() const
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < lost.size(); ++i)
+    {
+        if (i != causeIndex(LossCause::Duplicate) && i != causeIndex(LossCause::Skipped))
+            total += lost[i];
+    }
+    return total;
+}
+
+uint64_t FrameLossSnapshot::cameraLost() const
+{
+    return lost[causeIndex(LossCause::CameraGap)] + lost[causeIndex(LossCause::Incomplete)];
+}
+
+double FrameLossSnapshot::lossPercent() const
+{
+    uint64_t sent = received + cameraLost();
+    if (sent == 0)
+        return 0.0;
+    return 100.0 * std::min(totalLost(), sent) / sent;
+}
+
+FrameLossTracker::FrameLossTracker()
+{
+    reset();
+}
+
+void FrameLossTracker::reset()
+{
+    for (auto &counter : lost_)
+        counter.store(0, std::memory_order_relaxed);
+    received_.store(0, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(frameIdMutex_);
+        haveFrameId_ = false;
+        lastFrameId_ = 0;
+        missing_.clear();
+    }
+    frameIdResets_.store(0, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(sampleMutex_);
+    lastSample_ = std::chrono::steady_clock::now();
+    lastSnapshot_ = FrameLossSnapshot();
+    lossRates_.clear();
+}
+
+bool FrameLossTracker::observeFrameId(uint64_t frameId)
+{
+    std::lock_guard<std::mutex> lock(frameIdMutex_);
+    if (haveFrameId_ && frameId <= lastFrameId_)
+    {
+        if (lastFrameId_ - frameId > LATE_WINDOW)
+        {
+            // Counter wrapped or the camera was re-armed: start over from here
+            frameIdResets_.fetch_add(1, std::memory_order_relaxed);
+            missing_.clear();
+            lastFrameId_ = frameId;
+            received_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        if (missing_.erase(frameId) == 0)
+        {
+            count(LossCause::Duplicate);
+            return false;
+        }
+        // Late arrival: it was counted as part of a gap when the newer frame came in
+        std::atomic<uint64_t> &gaps = lost_[causeIndex(LossCause::CameraGap)];
+        if (gaps.load(std::memory_order_relaxed) > 0)
+            gaps.fetch_sub(1, std::memory_order_relaxed);
+        received_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    if (haveFrameId_ && frameId > lastFrameId_ + 1)
+    {
+        count(LossCause::CameraGap, frameId - lastFrameId_ - 1);
+        // Only the ids that can still arrive late are remembered
+        uint64_t first = std::max(lastFrameId_ + 1, frameId > LATE_WINDOW ? frameId - LATE_WINDOW : 0);
+        for (uint64_t id = first; id < frameId; ++id)
+            missing_.insert(missing_.end(), id);
+    }
+    if (frameId > LATE_WINDOW)
+        missing_.erase(missing_.begin(), missing_.lower_bound(frameId - LATE_WINDOW));
+    haveFrameId_ = true;
+    lastFrameId_ = frameId;
+    received_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void FrameLossTracker::count(LossCause cause, uint64_t frames)
+{
+    lost_[causeIndex(cause)].fetch_add(frames, std::memory_order_relaxed);
+}
+
+FrameLossSnapshot FrameLossTracker::snapshot() const
+{
+    FrameLossSnapshot result;
+    result.received = received_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < result.lost.size(); ++i)
+        result.lost[i] = lost_[i].load(std::memory_order_relaxed);
+    return result;
+}
+
+void FrameLossTracker::sampleIfDue(std::chrono::milliseconds interval)
+{
+    std::lock_guard<std::mutex> lock(sampleMutex_);
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastSample_ < interval)
+        return;
+
+    FrameLossSnapshot current = snapshot();
+    FrameLossSnapshot delta;
+    delta.received = current.received - lastSnapshot_.received;
+    for (size_t i = 0; i < delta.lost.size(); ++i)
+        delta.lost[i] = current.lost[i] - lastSnapshot_.lost[i];
+    // Nothing flowing (paused, idle camera) is not a zero-loss second
+    if (delta.received + delta.totalLost() > 0)
+        lossRates_.push(delta.lossPercent());
+    lastSnapshot_ = current;
+    lastSample_ = now;
+}
+
+std::string FrameLossTracker::summary() const
+{
+    FrameLossSnapshot current = snapshot();
+    std::ostringstream out;
+    out << current.received << " received, " << current.totalLost() << " lost (" << current.lossPercent() << "%):";
+    for (size_t i = 0; i < current.lost.size(); ++i)
+        out << " " << causeName(static_cast<LossCause>(i)) << "=" << current.lost[i];
+    if (frameIdResets() > 0)
+        out << " frame_id_resets=" << frameIdResets();
+    return out.str();
+}
+
+const char *FrameLossTracker::causeName(LossCause cause)
+{
+    return CAUSE_NAMES[causeIndex(cause)];
+}
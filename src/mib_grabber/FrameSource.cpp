@@ -0,0 +1,136 @@
+#include "mib_grabber/FrameSource.h"
+#include "image_processing/image_processing.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+ReplayFrameSource::ReplayFrameSource(std::string name, std::unique_ptr<CircularBuffer> frames,
+                                     size_t width, size_t height, const ReplayOptions &options)
+    : name_(std::move(name)), frames_(std::move(frames)), width_(width), height_(height), engine_(options)
+{
+    if (!frames_ || frames_->size() == 0)
+        throw std::invalid_argument("ReplayFrameSource requires at least one frame");
+}
+
+void ReplayFrameSource::start()
+{
+    engine_.start();
+    telemetryStart_ = std::chrono::steady_clock::now();
+    telemetryFrames_ = 0;
+}
+
+const uint8_t *ReplayFrameSource::nextFrame(FrameMeta &meta)
+{
+    uint64_t frameId;
+    if (!engine_.next(frameId))
+        return nullptr;
+
+    // Index 0 is the first frame loaded, the buffers are filled in reverse
+    size_t index = static_cast<size_t>(frameId % frames_->size());
+    meta.frameId = frameId;
+    meta.cameraTimestamp = static_cast<uint64_t>(steadyNowUs());
+    meta.sizeFilled = imageSize();
+    ++telemetryFrames_;
+    return frames_->getPointer(index);
+}
+
+SourceTelemetry ReplayFrameSource::telemetry()
+{
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - telemetryStart_).count();
+    SourceTelemetry result;
+    if (seconds > 0)
+    {
+        result.frameRate = telemetryFrames_.exchange(0, std::memory_order_relaxed) / seconds;
+        result.dataRate = result.frameRate * imageSize();
+    }
+    telemetryStart_ = now;
+
+    ReplayStats replay = engine_.stats();
+    result.delivered = replay.delivered;
+    result.coalesced = replay.coalesced;
+    result.dropped = replay.dropped;
+    result.meanLatenessUs = replay.meanLatenessUs;
+    result.maxLatenessUs = replay.maxLatenessUs;
+    return result;
+}
+
+std::unique_ptr<ReplayFrameSource> ReplayFrameSource::fromDirectory(const std::string &directory, const ReplayOptions &options)
+{
+    ImageParams params = initializeImageParams(directory);
+    auto frames = std::make_unique<CircularBuffer>(params.bufferCount, params.imageSize);
+    loadImages(directory, *frames, true);
+    return std::make_unique<ReplayFrameSource>("directory", std::move(frames), params.width, params.height, options);
+}
+
+std::unique_ptr<ReplayFrameSource> ReplayFrameSource::fromImagesBin(const std::string &path, const ReplayOptions &options)
+{
+    std::ifstream imageFile(path, std::ios::binary);
+    if (!imageFile)
+        throw std::runtime_error("Cannot open " + path);
+
+    std::vector<cv::Mat> images;
+    while (imageFile.good())
+    {
+        int rows, cols, type;
+        imageFile.read(reinterpret_cast<char *>(&rows), sizeof(int));
+        imageFile.read(reinterpret_cast<char *>(&cols), sizeof(int));
+        imageFile.read(reinterpret_cast<char *>(&type), sizeof(int));
+        if (imageFile.eof())
+            break;
+
+        cv::Mat image(rows, cols, type);
+        imageFile.read(reinterpret_cast<char *>(image.data), rows * cols * image.elemSize());
+        if (!imageFile)
+            break;
+        if (type == CV_8UC1 && (images.empty() || image.size() == images.front().size()))
+            images.push_back(image);
+    }
+    if (images.empty())
+        throw std::runtime_error("No 8-bit frames found in " + path);
+
+    size_t width = images.front().cols;
+    size_t height = images.front().rows;
+    auto frames = std::make_unique<CircularBuffer>(images.size(), width * height);
+    for (auto it = images.rbegin(); it != images.rend(); ++it)
+        frames->push(it->data);
+    std::cout << "Loaded " << images.size() << " frames from " << path << std::endl;
+    return std::make_unique<ReplayFrameSource>("images.bin", std::move(frames), width, height, options);
+}
+
+std::unique_ptr<ReplayFrameSource> ReplayFrameSource::synthetic(size_t width, size_t height, size_t cycleFrames, const ReplayOptions &options)
+{
+    if (cycleFrames < 2)
+        throw std::invalid_argument("Synthetic source needs at least two frames per cycle");
+
+    const int w = static_cast<int>(width);
+    const int h = static_cast<int>(height);
+    // Bright channel between two dark walls, like the real chip
+    cv::Mat background(h, w, CV_8UC1, cv::Scalar(200));
+    cv::rectangle(background, cv::Rect(0, 0, w, h / 8), cv::Scalar(60), cv::FILLED);
+    cv::rectangle(background, cv::Rect(0, h - h / 8, w, h / 8), cv::Scalar(60), cv::FILLED);
+
+    // Frame 0 has no cell so it can serve as the background
+    std::vector<cv::Mat> images;
+    for (size_t i = 0; i < cycleFrames; ++i)
+    {
+        cv::Mat frame = background.clone();
+        if (i > 0)
+        {
+            int x = static_cast<int>((i * (width + height)) / cycleFrames) - h / 2;
+            cv::Size axes(std::max(h / 6, 2), std::max(h / 8, 2));
+            cv::ellipse(frame, cv::Point(x, h / 2), axes, 0, 0, 360, cv::Scalar(90), cv::FILLED);
+        }
+        cv::Mat noise(h, w, CV_8SC1);
+        cv::randu(noise, cv::Scalar(-2), cv::Scalar(3));
+        cv::add(frame, noise, frame, cv::noArray(), CV_8UC1);
+        images.push_back(frame);
+    }
+
+    auto frames = std::make_unique<CircularBuffer>(cycleFrames, width * height);
+    for (auto it = images.rbegin(); it != images.rend(); ++it)
+        frames->push(it->data);
+    return std::make_unique<ReplayFrameSource>("synthetic", std::move(frames), width, height, options);
+}
@@ -0,0 +1,163 @@
+#include "mib_grabber/GrabberSession.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+using namespace Euresys;
+
+GrabberSession &GrabberSession::instance()
+{
+    static GrabberSession session;
+    return session;
+}
+
+EGenTL &GrabberSession::genTL()
+{
+    std::lock_guard<std::mutex> lock(discoveryMutex_);
+    if (!genTL_)
+        genTL_ = std::make_unique<EGenTL>();
+    return *genTL_;
+}
+
+EGrabberDiscovery &GrabberSession::discovery()
+{
+    EGenTL &gentl = genTL();
+    std::lock_guard<std::mutex> lock(discoveryMutex_);
+    if (!discovery_)
+        discovery_ = std::make_unique<EGrabberDiscovery>(gentl);
+    if (!discovered_)
+    {
+        std::cout << "Scanning for available eGrabbers and cameras..." << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        discovery_->discover();
+        // An empty result is not cached, so cameras plugged in later are found
+        discovered_ = discovery_->cameraCount() > 0;
+        std::cout << "Found " << discovery_->cameraCount() << " camera(s) in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                  << " ms" << std::endl;
+    }
+    return *discovery_;
+}
+
+void GrabberSession::invalidateDiscovery()
+{
+    std::lock_guard<std::mutex> lock(discoveryMutex_);
+    discovered_ = false;
+}
+
+GrabberSession::Attachment &GrabberSession::Attachment::operator=(Attachment &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        session_ = other.session_;
+        id_ = other.id_;
+        other.session_ = nullptr;
+    }
+    return *this;
+}
+
+void GrabberSession::Attachment::release()
+{
+    if (session_)
+        session_->detach(id_);
+    session_ = nullptr;
+}
+
+void GrabberSession::detach(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(liveMutex_);
+    live_.erase(std::remove_if(live_.begin(), live_.end(), [id](const LiveGrabber &live)
+                               { return live.id == id; }),
+                live_.end());
+}
+
+ReloadResult GrabberSession::runScript(const std::string &path)
+{
+    if (path.size() < 3 || path.substr(path.size() - 3) != ".js")
+        throw std::invalid_argument("Config path must end with .js");
+
+    std::lock_guard<std::mutex> lock(liveMutex_);
+    if (live_.empty())
+        return runScriptOnSelected(path);
+
+    // Features are written over the control channel while frames keep
+    // arriving; the dispatcher times the first frame after the reload
+    ReloadResult result;
+    auto start = std::chrono::steady_clock::now();
+    for (const LiveGrabber &live : live_)
+    {
+        try
+        {
+            live.runScript(path);
+        }
+        catch (const std::exception &e)
+        {
+            throw std::runtime_error("Camera " + std::to_string(live.cameraIndex) + ": " + e.what());
+        }
+    }
+    result.liveGrabbers = live_.size();
+    result.scriptMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+ReloadResult GrabberSession::runScriptOnSelected(const std::string &path)
+{
+    // A camera that cannot be opened from the cached discovery was probably
+    // unplugged or replaced, so rescan once before giving up
+    std::unique_ptr<EGrabber<CallbackOnDemand>> grabber;
+    for (int attempt = 0; !grabber; ++attempt)
+    {
+        if (cameraCount() == 0)
+            throw std::runtime_error("No cameras detected");
+        if (selectedCamera_ < 0 || selectedCamera_ >= cameraCount())
+            selectedCamera_ = 0;
+        try
+        {
+            grabber = std::make_unique<EGrabber<CallbackOnDemand>>(camera(selectedCamera_));
+        }
+        catch (const std::exception &)
+        {
+            if (attempt > 0)
+                throw;
+            invalidateDiscovery();
+        }
+    }
+
+    ReloadResult result;
+    auto start = std::chrono::steady_clock::now();
+    grabber->runScript(path);
+    result.scriptMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Nothing else is acquiring, so time the first frame after the script here
+    grabber->reallocBuffers(3);
+    grabber->start(1);
+    try
+    {
+        ScopedBuffer buffer(*grabber, 1000);
+        result.firstFrameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    catch (const std::exception &)
+    {
+        // Triggered cameras may not deliver without a trigger; leave it unmeasured
+    }
+    grabber->stop();
+    return result;
+}
+
+bool GrabberSession::setFloat(const std::string &feature, double value)
+{
+    std::lock_guard<std::mutex> lock(liveMutex_);
+    for (const LiveGrabber &live : live_)
+        live.setFloat(feature, value);
+    return !live_.empty();
+}
+
+bool GrabberSession::setInteger(const std::string &feature, int64_t value)
+{
+    std::lock_guard<std::mutex> lock(liveMutex_);
+    for (const LiveGrabber &live : live_)
+        live.setInteger(feature, value);
+    return !live_.empty();
+}
@@ -0,0 +1,117 @@
+#include "mib_grabber/MockBufferProducer.h"
+#include <cstring>
+
+MockBufferProducer::MockBufferProducer(const CircularBuffer &source, size_t imageSize, size_t bufferCount, double targetFps)
+    : source_(source), imageSize_(imageSize),
+      frameInterval_(static_cast<int64_t>(1e9 / targetFps)),
+      ownBuffers_(bufferCount, std::vector<uint8_t>(imageSize))
+{
+    if (bufferCount == 0 || source.size() == 0)
+        throw std::invalid_argument("MockBufferProducer requires buffers and source frames");
+    for (size_t i = 0; i < bufferCount; ++i)
+    {
+        buffers_.push_back(ownBuffers_[i].data());
+        inputQueue_.push_back(i);
+    }
+    bufferCount_ = bufferCount;
+}
+
+MockBufferProducer::~MockBufferProducer()
+{
+    stop();
+}
+
+void MockBufferProducer::start(FrameCallback onFrame)
+{
+    if (running_)
+        return;
+    onFrame_ = std::move(onFrame);
+    running_ = true;
+    thread_ = std::thread(&MockBufferProducer::run, this);
+}
+
+void MockBufferProducer::stop()
+{
+    running_ = false;
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void MockBufferProducer::announceExternal(uint8_t *base, size_t stride, size_t count, size_t queued)
+{
+    if (running_ || count == 0 || stride < imageSize_)
+        throw std::invalid_argument("External buffers must be announced before start and hold a full frame");
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    ownBuffers_.clear();
+    buffers_.clear();
+    inputQueue_.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        buffers_.push_back(base + i * stride);
+        if (i < queued)
+            inputQueue_.push_back(i);
+    }
+    bufferCount_ = count;
+    external_ = true;
+}
+
+void MockBufferProducer::growPool(size_t count)
+{
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    if (external_)
+        throw std::logic_error("Cannot grow a pool of external buffers");
+    // Moving the inner vectors keeps the pixel pointers of existing buffers valid
+    while (buffers_.size() < count)
+    {
+        ownBuffers_.emplace_back(imageSize_);
+        buffers_.push_back(ownBuffers_.back().data());
+        inputQueue_.push_back(buffers_.size() - 1);
+    }
+    bufferCount_ = buffers_.size();
+}
+
+void MockBufferProducer::requeue(size_t index)
+{
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    inputQueue_.push_back(index);
+}
+
+void MockBufferProducer::run()
+{
+    using clock = std::chrono::steady_clock;
+    auto nextFrameTime = clock::now();
+    uint64_t frameId = 0;
+
+    while (running_)
+    {
+        // Spin to the next frame boundary; sleeping cannot hold 5 kHz
+        while (clock::now() < nextFrameTime)
+        {
+        }
+        nextFrameTime += frameInterval_;
+        ++frameId;
+
+        size_t index;
+        uint8_t *target;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            if (inputQueue_.empty())
+            {
+                starved_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            index = inputQueue_.front();
+            inputQueue_.pop_front();
+            target = buffers_[index];
+        }
+
+        // Stands in for the DMA transfer into the queued buffer
+        std::memcpy(target, source_.getPointer(frameId % source_.size()), imageSize_);
+
+        FrameMeta meta;
+        meta.frameId = frameId;
+        meta.cameraTimestamp = static_cast<uint64_t>(steadyNowUs());
+        meta.sizeFilled = imageSize_;
+        onFrame_(deliver(index, target, meta));
+    }
+}
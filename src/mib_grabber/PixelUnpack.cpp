@@ -0,0 +1,262 @@
+#include "mib_grabber/PixelUnpack.h"
+#include <PFNC.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PIXEL_UNPACK_SSE2 1
+#endif
+
+namespace
+{
+    // Packed rows are decoded this many pixels at a time, small enough to stay in L1
+    const size_t CHUNK_PIXELS = 1024;
+
+    struct FastFormat
+    {
+        uint64_t value;
+        const char *name;
+        size_t bits;
+        int layout; // PixelUnpacker::Layout
+        size_t groupPixels;
+        size_t groupBytes;
+    };
+
+    const FastFormat FAST_FORMATS[] = {
+        {PFNC_Mono8, "Mono8", 8, 0, 1, 1},
+        {PFNC_Mono10, "Mono10", 10, 1, 1, 2},
+        {PFNC_Mono12, "Mono12", 12, 1, 1, 2},
+        {PFNC_Mono14, "Mono14", 14, 1, 1, 2},
+        {PFNC_Mono16, "Mono16", 16, 1, 1, 2},
+        {PFNC_Mono10p, "Mono10p", 10, 2, 4, 5},
+        {PFNC_Mono12p, "Mono12p", 12, 2, 2, 3},
+        {PFNC_Mono14p, "Mono14p", 14, 2, 4, 7},
+        {GVSP_Mono10Packed, "Mono10Packed", 10, 3, 2, 3},
+        {GVSP_Mono12Packed, "Mono12Packed", 12, 3, 2, 3},
+    };
+
+    const FastFormat *findFastFormat(uint64_t pixelFormat)
+    {
+        if (pixelFormat == 0)
+            pixelFormat = PFNC_Mono8;
+        for (const FastFormat &format : FAST_FORMATS)
+            if (format.value == pixelFormat)
+                return &format;
+        return nullptr;
+    }
+
+    // The clamp, shift and fixed-point scale of PixelNormalization, 16 pixels a step
+    void normalizeWords(const uint16_t *src, uint8_t *dst, size_t count,
+                        uint16_t black, uint16_t range, int shift, uint16_t scale)
+    {
+        size_t i = 0;
+#ifdef PIXEL_UNPACK_SSE2
+        const __m128i vBlack = _mm_set1_epi16(static_cast<short>(black));
+        const __m128i vRange = _mm_set1_epi16(static_cast<short>(range));
+        const __m128i vScale = _mm_set1_epi16(static_cast<short>(scale));
+        const __m128i vShift = _mm_cvtsi32_si128(shift);
+        auto normalize8 = [&](__m128i v)
+        {
+            v = _mm_subs_epu16(v, vBlack);
+            v = _mm_sub_epi16(v, _mm_subs_epu16(v, vRange)); // unsigned min(v, range)
+            v = _mm_sll_epi16(v, vShift);
+            return _mm_mulhi_epu16(v, vScale);
+        };
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i low = normalize8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)));
+            __m128i high = normalize8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 8)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(low, high));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            uint32_t v = src[i] > black ? src[i] - black : 0;
+            v = std::min<uint32_t>(v, range) << shift;
+            dst[i] = static_cast<uint8_t>((v * scale) >> 16);
+        }
+    }
+
+    // 8-bit pixels that still need a black/white remap
+    void widenBytes(const uint8_t *src, uint16_t *dst, size_t count)
+    {
+        size_t i = 0;
+#ifdef PIXEL_UNPACK_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_unpacklo_epi8(v, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 8), _mm_unpackhi_epi8(v, zero));
+        }
+#endif
+        for (; i < count; ++i)
+            dst[i] = src[i];
+    }
+
+    // Little-endian bit stream, GroupPixels pixels in GroupBytes (<= 8) bytes.
+    // Fixed at compile time so the group loads and shifts unroll.
+    template <size_t Bits, size_t GroupPixels, size_t GroupBytes>
+    void decodePackedLsb(const uint8_t *src, uint16_t *dst, size_t groups)
+    {
+        const uint64_t mask = (uint64_t(1) << Bits) - 1;
+        const uint8_t *end = src + groups * GroupBytes;
+        for (; src < end; src += GroupBytes, dst += GroupPixels)
+        {
+            uint64_t v = 0;
+            // One unaligned load while a whole word is left, byte by byte at the row end
+            if (end - src >= 8)
+                std::memcpy(&v, src, 8);
+            else
+                for (size_t b = 0; b < GroupBytes; ++b)
+                    v |= uint64_t(src[b]) << (8 * b);
+            for (size_t p = 0; p < GroupPixels; ++p)
+                dst[p] = static_cast<uint16_t>((v >> (p * Bits)) & mask);
+        }
+    }
+
+    // GigE Vision packing: the high bits of each pixel in bytes 0 and 2, the
+    // low bits of both in the nibbles of byte 1
+    template <int LowBits>
+    void decodePackedGvsp(const uint8_t *src, uint16_t *dst, size_t groups)
+    {
+        const uint8_t lowMask = static_cast<uint8_t>((1 << LowBits) - 1);
+        for (size_t g = 0; g < groups; ++g, src += 3, dst += 2)
+        {
+            dst[0] = static_cast<uint16_t>((src[0] << LowBits) | (src[1] & lowMask));
+            dst[1] = static_cast<uint16_t>((src[2] << LowBits) | ((src[1] >> 4) & lowMask));
+        }
+    }
+}
+
+PixelUnpacker::PixelUnpacker(uint64_t pixelFormat, size_t width, size_t height,
+                             PixelNormalization normalization, GenericConvert generic)
+    : pixelFormat_(pixelFormat == 0 ? PFNC_Mono8 : pixelFormat), width_(width), height_(height), generic_(std::move(generic))
+{
+    if (width_ == 0 || height_ == 0)
+        throw std::invalid_argument("PixelUnpacker needs a frame size");
+
+    const FastFormat *format = findFastFormat(pixelFormat_);
+    if (format)
+    {
+        layout_ = static_cast<Layout>(format->layout);
+        bits_ = format->bits;
+        groupPixels_ = format->groupPixels;
+        groupBytes_ = format->groupBytes;
+        if (width_ % groupPixels_ != 0)
+            throw std::invalid_argument(formatName(pixelFormat_) + " needs a width that is a multiple of " +
+                                        std::to_string(groupPixels_));
+        rowBytes_ = width_ / groupPixels_ * groupBytes_;
+    }
+    else
+    {
+        if (!generic_)
+            throw std::invalid_argument("No conversion for pixel format " + formatName(pixelFormat_));
+        // PFNC codes carry the bits per pixel in bits 16-23
+        bits_ = std::max<size_t>((pixelFormat_ >> 16) & 0xFF, 1);
+        rowBytes_ = (width_ * bits_ + 7) / 8;
+    }
+
+    uint32_t maxValue = (uint32_t(1) << std::min<size_t>(bits_, 16)) - 1;
+    uint32_t white = normalization.white ? std::min<uint32_t>(normalization.white, maxValue) : maxValue;
+    white = std::max<uint32_t>(white, 1);
+    black_ = static_cast<uint16_t>(std::min<uint32_t>(normalization.black, white - 1));
+    range_ = static_cast<uint16_t>(white - black_);
+    shift_ = 0;
+    while ((uint32_t(range_) << (shift_ + 1)) <= 0xFFFF)
+        ++shift_;
+    uint32_t scaled = uint32_t(range_) << shift_;
+    scale_ = static_cast<uint16_t>((255u * 65536u + scaled - 1) / scaled);
+    passthrough_ = layout_ == Layout::Bytes && black_ == 0 && range_ == 255;
+}
+
+bool PixelUnpacker::hasFastPath(uint64_t pixelFormat)
+{
+    return findFastFormat(pixelFormat) != nullptr;
+}
+
+std::string PixelUnpacker::formatName(uint64_t pixelFormat)
+{
+    if (const FastFormat *format = findFastFormat(pixelFormat))
+        return format->name;
+    char hex[24];
+    std::snprintf(hex, sizeof(hex), "0x%08llX", static_cast<unsigned long long>(pixelFormat));
+    return hex;
+}
+
+void PixelUnpacker::unpackRow(const uint8_t *rawRow, uint8_t *dstRow, size_t x, size_t cols) const
+{
+    if (passthrough_)
+    {
+        std::memcpy(dstRow + x, rawRow + x, cols);
+        return;
+    }
+    if (layout_ == Layout::Words)
+    {
+        normalizeWords(reinterpret_cast<const uint16_t *>(rawRow) + x, dstRow + x, cols, black_, range_, shift_, scale_);
+        return;
+    }
+
+    uint16_t chunk[CHUNK_PIXELS];
+    for (size_t done = 0; done < cols; done += CHUNK_PIXELS)
+    {
+        size_t count = std::min(CHUNK_PIXELS, cols - done);
+        size_t first = x + done;
+        if (layout_ == Layout::Bytes)
+            widenBytes(rawRow + first, chunk, count);
+        else if (layout_ == Layout::PackedLsb)
+        {
+            const uint8_t *src = rawRow + first / groupPixels_ * groupBytes_;
+            if (bits_ == 10)
+                decodePackedLsb<10, 4, 5>(src, chunk, count / 4);
+            else if (bits_ == 12)
+                decodePackedLsb<12, 2, 3>(src, chunk, count / 2);
+            else
+                decodePackedLsb<14, 4, 7>(src, chunk, count / 4);
+        }
+        else if (bits_ == 10)
+            decodePackedGvsp<2>(rawRow + first / 2 * 3, chunk, count / 2);
+        else
+            decodePackedGvsp<4>(rawRow + first / 2 * 3, chunk, count / 2);
+        normalizeWords(chunk, dstRow + first, count, black_, range_, shift_, scale_);
+    }
+}
+
+void PixelUnpacker::unpack(const uint8_t *raw, uint8_t *dst, size_t dstStride) const
+{
+    unpackRegion(raw, dst, dstStride, 0, 0, width_, height_);
+}
+
+void PixelUnpacker::unpackRegion(const uint8_t *raw, uint8_t *dst, size_t dstStride,
+                                 size_t x, size_t y, size_t cols, size_t rows) const
+{
+    if (layout_ == Layout::Generic)
+    {
+        // The converter only does whole frames
+        if (dstStride == width_)
+        {
+            generic_(raw, dst);
+            return;
+        }
+        thread_local std::vector<uint8_t> frame;
+        frame.resize(width_ * height_);
+        generic_(raw, frame.data());
+        for (size_t row = 0; row < height_; ++row)
+            std::memcpy(dst + row * dstStride, frame.data() + row * width_, width_);
+        return;
+    }
+
+    size_t end = std::min(x + cols, width_);
+    x = x / groupPixels_ * groupPixels_;
+    end = std::min((end + groupPixels_ - 1) / groupPixels_ * groupPixels_, width_);
+    rows = std::min(y + rows, height_) - std::min(y, height_);
+    if (end <= x || rows == 0)
+        return;
+    // CHUNK_PIXELS is a multiple of every group size, so chunks never split a group
+    for (size_t row = y; row < y + rows; ++row)
+        unpackRow(raw + row * rowBytes_, dst + row * dstStride, x, end - x);
+}
@@ -0,0 +1,114 @@
+#include "mib_grabber/ReplayEngine.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+ReplayEngine::ReplayEngine(const ReplayOptions &options)
+    : options_(options),
+      interval_(options.targetFps > 0 ? static_cast<int64_t>(1e9 / options.targetFps) : 0)
+{
+    if (options_.mode == ReplayMode::Realtime && interval_.count() <= 0)
+        throw std::invalid_argument("Realtime replay needs a positive target frame rate");
+    options_.maxBacklog = std::max<size_t>(options_.maxBacklog, 1);
+}
+
+void ReplayEngine::start()
+{
+    origin_ = std::chrono::steady_clock::now();
+}
+
+void ReplayEngine::step(size_t frames)
+{
+    {
+        std::lock_guard<std::mutex> lock(stepMutex_);
+        pendingSteps_ += frames;
+    }
+    stepCondition_.notify_one();
+}
+
+void ReplayEngine::pause()
+{
+    if (paused_)
+        return;
+    paused_ = true;
+    pausedAt_ = std::chrono::steady_clock::now();
+}
+
+void ReplayEngine::resume()
+{
+    if (!paused_)
+        return;
+    paused_ = false;
+    origin_ += std::chrono::steady_clock::now() - pausedAt_;
+}
+
+void ReplayEngine::waitUntil(std::chrono::steady_clock::time_point deadline) const
+{
+    // Sleep through most of the wait, then spin the last stretch where the
+    // scheduler cannot be trusted to wake us on time
+    auto remaining = deadline - std::chrono::steady_clock::now();
+    if (remaining > options_.spinWindow)
+        std::this_thread::sleep_for(remaining - options_.spinWindow);
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+    }
+}
+
+bool ReplayEngine::next(uint64_t &index, std::chrono::milliseconds timeout)
+{
+    if (options_.mode == ReplayMode::Step)
+    {
+        std::unique_lock<std::mutex> lock(stepMutex_);
+        if (!stepCondition_.wait_for(lock, timeout, [&]()
+                                     { return pendingSteps_ > 0; }))
+            return false;
+        --pendingSteps_;
+    }
+    else if (options_.mode == ReplayMode::Realtime)
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (now > origin_)
+        {
+            // Frames nextIndex_..newestDue are all due; the pipeline was late
+            uint64_t newestDue = static_cast<uint64_t>((now - origin_) / interval_);
+            if (newestDue > nextIndex_)
+            {
+                uint64_t backlog = newestDue - nextIndex_ + 1;
+                if (options_.overrun == ReplayOverrun::Latest)
+                {
+                    coalesced_.fetch_add(backlog - 1, std::memory_order_relaxed);
+                    nextIndex_ = newestDue;
+                }
+                else if (backlog > options_.maxBacklog)
+                {
+                    dropped_.fetch_add(backlog - options_.maxBacklog, std::memory_order_relaxed);
+                    nextIndex_ += backlog - options_.maxBacklog;
+                }
+            }
+        }
+
+        auto deadline = origin_ + interval_ * static_cast<int64_t>(nextIndex_);
+        waitUntil(deadline);
+        double latenessUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - deadline).count();
+        // Single caller, so plain load/store is enough for the totals
+        totalLatenessUs_.store(totalLatenessUs_.load(std::memory_order_relaxed) + latenessUs, std::memory_order_relaxed);
+        if (latenessUs > maxLatenessUs_.load(std::memory_order_relaxed))
+            maxLatenessUs_.store(latenessUs, std::memory_order_relaxed);
+    }
+
+    index = nextIndex_++;
+    delivered_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+ReplayStats ReplayEngine::stats() const
+{
+    ReplayStats result;
+    result.delivered = delivered_.load(std::memory_order_relaxed);
+    result.coalesced = coalesced_.load(std::memory_order_relaxed);
+    result.dropped = dropped_.load(std::memory_order_relaxed);
+    if (options_.mode == ReplayMode::Realtime && result.delivered > 0)
+        result.meanLatenessUs = totalLatenessUs_.load(std::memory_order_relaxed) / result.delivered;
+    result.maxLatenessUs = maxLatenessUs_.load(std::memory_order_relaxed);
+    return result;
+}
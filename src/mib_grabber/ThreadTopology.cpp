@@ -0,0 +1,385 @@
+#include "mib_grabber/ThreadTopology.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+    // Threads start together; keep each one's report on its own lines
+    std::mutex logMutex;
+
+    std::vector<int> normalized(std::vector<int> cores)
+    {
+        std::sort(cores.begin(), cores.end());
+        cores.erase(std::unique(cores.begin(), cores.end()), cores.end());
+        return cores;
+    }
+
+    std::string describePriority(int priority)
+    {
+        return priority > 0 ? "SCHED_FIFO " + std::to_string(priority) : "normal priority";
+    }
+
+#ifndef _WIN32
+    int clampedFifoPriority(int priority)
+    {
+        return std::clamp(priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+    }
+
+    std::vector<int> currentAffinity()
+    {
+        std::vector<int> cores;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+        {
+            for (int core = 0; core < CPU_SETSIZE; ++core)
+                if (CPU_ISSET(core, &set))
+                    cores.push_back(core);
+        }
+        return cores;
+    }
+
+    int setAffinity(const std::vector<int> &cores)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int core : cores)
+        {
+            if (core < 0 || core >= CPU_SETSIZE)
+                return EINVAL;
+            CPU_SET(core, &set);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+}
+
+const char *threadRoleName(ThreadRole role)
+{
+    switch (role)
+    {
+    case ThreadRole::Acquisition:
+        return "acquisition";
+    case ThreadRole::Trigger:
+        return "trigger";
+    case ThreadRole::Processing:
+        return "processing";
+    case ThreadRole::Saver:
+        return "saver";
+    case ThreadRole::Display:
+        return "display";
+    case ThreadRole::Metrics:
+        return "metrics";
+    }
+    return "unknown";
+}
+
+const ThreadPlacement &ThreadTopology::placement(ThreadRole role) const
+{
+    switch (role)
+    {
+    case ThreadRole::Acquisition:
+        return acquisition;
+    case ThreadRole::Trigger:
+        return trigger;
+    case ThreadRole::Processing:
+        return processing;
+    case ThreadRole::Saver:
+        return saver;
+    case ThreadRole::Display:
+        return display;
+    case ThreadRole::Metrics:
+        break;
+    }
+    return metrics;
+}
+
+ThreadPlacement ThreadTopology::placementFor(ThreadRole role, size_t index) const
+{
+    ThreadPlacement result = placement(role);
+    if ((role == ThreadRole::Processing || role == ThreadRole::Trigger) && !result.cores.empty())
+        result.cores = {result.cores[index % result.cores.size()]};
+    return result;
+}
+
+size_t ThreadTopology::threadCount(ThreadRole role) const
+{
+    if (role == ThreadRole::Trigger)
+        return 2;
+    if (role == ThreadRole::Processing)
+        return std::max<size_t>(processingThreads, 1);
+    return 1;
+}
+
+bool ThreadTopology::empty() const
+{
+    return acquisition.empty() && trigger.empty() && processing.empty() &&
+           saver.empty() && display.empty() && metrics.empty();
+}
+
+AppliedPlacement applyThreadPlacement(const ThreadPlacement &placement)
+{
+    AppliedPlacement applied;
+    std::vector<int> wanted = normalized(placement.cores);
+#ifdef _WIN32
+    HANDLE thread = GetCurrentThread();
+    if (!wanted.empty())
+    {
+        // One processor group only; cores beyond 63 would need SetThreadGroupAffinity
+        DWORD_PTR mask = 0;
+        for (int core : wanted)
+        {
+            if (core >= 0 && core < static_cast<int>(sizeof(DWORD_PTR) * 8))
+                mask |= static_cast<DWORD_PTR>(1) << core;
+        }
+        if (mask == 0 || SetThreadAffinityMask(thread, mask) == 0)
+            applied.error = "SetThreadAffinityMask failed (" + std::to_string(GetLastError()) + ")";
+        // The call returns the old mask, so read the new one back by setting it again
+        DWORD_PTR granted = mask != 0 ? SetThreadAffinityMask(thread, mask) : 0;
+        for (int core = 0; core < static_cast<int>(sizeof(DWORD_PTR) * 8); ++core)
+            if (granted & (static_cast<DWORD_PTR>(1) << core))
+                applied.cores.push_back(core);
+    }
+    if (placement.priority > 0 && !SetThreadPriority(thread, THREAD_PRIORITY_TIME_CRITICAL) && applied.error.empty())
+        applied.error = "SetThreadPriority failed (" + std::to_string(GetLastError()) + ")";
+    applied.priority = GetThreadPriority(thread) == THREAD_PRIORITY_TIME_CRITICAL ? placement.priority : 0;
+    applied.currentCore = static_cast<int>(GetCurrentProcessorNumber());
+    bool priorityMatches = placement.priority <= 0 || applied.priority == placement.priority;
+#else
+    if (!wanted.empty())
+    {
+        int result = setAffinity(wanted);
+        if (result != 0)
+            applied.error = std::string("pthread_setaffinity_np: ") + std::strerror(result);
+    }
+    int wantedPriority = placement.priority > 0 ? clampedFifoPriority(placement.priority) : 0;
+    if (wantedPriority > 0)
+    {
+        sched_param param{};
+        param.sched_priority = wantedPriority;
+        int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result != 0 && applied.error.empty())
+            applied.error = std::string("pthread_setschedparam: ") + std::strerror(result) +
+                            (result == EPERM ? " (needs CAP_SYS_NICE or an rtprio limit)" : "");
+    }
+
+    applied.cores = currentAffinity();
+    int policy = 0;
+    sched_param param{};
+    if (pthread_getschedparam(pthread_self(), &policy, &param) == 0 && policy == SCHED_FIFO)
+        applied.priority = param.sched_priority;
+    applied.currentCore = sched_getcpu();
+    bool priorityMatches = wantedPriority == 0 || applied.priority == wantedPriority;
+#endif
+    // A partly valid core list is trimmed by the OS rather than refused
+    applied.matches = (wanted.empty() || applied.cores == wanted) && priorityMatches;
+    return applied;
+}
+
+void placeCurrentThread(const ThreadTopology &topology, ThreadRole role, size_t index)
+{
+    ThreadPlacement placement = topology.placementFor(role, index);
+    if (placement.empty())
+        return;
+    AppliedPlacement applied = applyThreadPlacement(placement);
+
+    std::string name = threadRoleName(role);
+    if (role == ThreadRole::Processing || role == ThreadRole::Trigger)
+        name += " " + std::to_string(index);
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (applied.matches)
+    {
+        std::cout << "Thread placement: " << name << " on cores " << describeCores(applied.cores)
+                  << " (running on " << applied.currentCore << "), " << describePriority(applied.priority) << std::endl;
+    }
+    else
+    {
+        std::cerr << "Thread placement: " << name << " asked for cores " << describeCores(placement.cores) << ", "
+                  << describePriority(placement.priority) << "; got cores " << describeCores(applied.cores) << ", "
+                  << describePriority(applied.priority);
+        if (!applied.error.empty())
+            std::cerr << ": " << applied.error;
+        std::cerr << std::endl;
+    }
+}
+
+std::vector<std::string> checkThreadTopology(const ThreadTopology &topology, unsigned coreCount)
+{
+    const ThreadRole roles[] = {ThreadRole::Acquisition, ThreadRole::Trigger, ThreadRole::Processing,
+                                ThreadRole::Saver, ThreadRole::Display, ThreadRole::Metrics};
+    std::vector<std::string> warnings;
+    for (ThreadRole role : roles)
+    {
+        const ThreadPlacement &placement = topology.placement(role);
+        for (int core : placement.cores)
+        {
+            if (core < 0 || (coreCount > 0 && core >= static_cast<int>(coreCount)))
+                warnings.push_back(std::string(threadRoleName(role)) + ": core " + std::to_string(core) +
+                                   " does not exist (" + std::to_string(coreCount) + " cores)");
+        }
+        if (placement.priority <= 0)
+            continue;
+        // A SCHED_FIFO thread that spins keeps everything else off its cores
+        if (placement.cores.empty())
+        {
+            warnings.push_back(std::string(threadRoleName(role)) + ": real-time priority without cores may run on any core");
+            continue;
+        }
+        std::string sharedWith;
+        for (ThreadRole other : roles)
+        {
+            if (other == role)
+                continue;
+            const std::vector<int> &otherCores = topology.placement(other).cores;
+            bool overlaps = otherCores.empty() || std::any_of(placement.cores.begin(), placement.cores.end(), [&](int core)
+                                                              { return std::find(otherCores.begin(), otherCores.end(), core) != otherCores.end(); });
+            if (overlaps)
+                sharedWith += (sharedWith.empty() ? "" : ", ") + std::string(threadRoleName(other));
+        }
+        if (!sharedWith.empty())
+            warnings.push_back(std::string(threadRoleName(role)) + ": real-time on cores " + describeCores(placement.cores) +
+                               ", which " + sharedWith + " may also use");
+        // SCHED_FIFO does not time-slice, so a spinning thread starves another
+        // of equal priority on its core
+        size_t threads = topology.threadCount(role);
+        size_t cores = normalized(placement.cores).size();
+        if (threads > cores)
+            warnings.push_back(std::string(threadRoleName(role)) + ": " + std::to_string(threads) +
+                               " real-time threads on " + std::to_string(cores) + " core(s); threads sharing a core starve each other");
+    }
+    return warnings;
+}
+
+void printThreadTopology(const ThreadTopology &topology)
+{
+    if (topology.empty())
+        return;
+    const ThreadRole roles[] = {ThreadRole::Acquisition, ThreadRole::Trigger, ThreadRole::Processing,
+                                ThreadRole::Saver, ThreadRole::Display, ThreadRole::Metrics};
+    std::cout << "Thread topology:" << std::endl;
+    for (ThreadRole role : roles)
+    {
+        const ThreadPlacement &placement = topology.placement(role);
+        std::cout << "  " << threadRoleName(role) << ": cores " << describeCores(placement.cores) << ", "
+                  << describePriority(placement.priority) << std::endl;
+    }
+    for (const std::string &warning : checkThreadTopology(topology, std::thread::hardware_concurrency()))
+        std::cerr << "Thread topology warning: " << warning << std::endl;
+}
+
+int numaNodeOfCore(int core)
+{
+    if (core < 0)
+        return -1;
+#ifdef _WIN32
+    PROCESSOR_NUMBER processor{};
+    processor.Group = static_cast<WORD>(core / 64);
+    processor.Number = static_cast<BYTE>(core % 64);
+    USHORT node = 0;
+    if (!GetNumaProcessorNodeEx(&processor, &node) || node == 0xffff)
+        return -1;
+    return node;
+#else
+    // The core's sysfs directory links to its node as nodeN
+    std::error_code error;
+    std::filesystem::path path = "/sys/devices/system/cpu/cpu" + std::to_string(core);
+    for (const auto &entry : std::filesystem::directory_iterator(path, error))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+            std::all_of(name.begin() + 4, name.end(), [](char c)
+                        { return c >= '0' && c <= '9'; }))
+            return std::stoi(name.substr(4));
+    }
+    return -1;
+#endif
+}
+
+std::string describeCores(const std::vector<int> &cores)
+{
+    std::vector<int> sorted = normalized(cores);
+    if (sorted.empty())
+        return "any";
+    // Runs of consecutive cores as ranges: 0-3,6
+    std::ostringstream text;
+    for (size_t i = 0; i < sorted.size();)
+    {
+        size_t end = i;
+        while (end + 1 < sorted.size() && sorted[end + 1] == sorted[end] + 1)
+            ++end;
+        if (i > 0)
+            text << ",";
+        text << sorted[i];
+        if (end > i)
+            text << "-" << sorted[end];
+        i = end + 1;
+    }
+    return text.str();
+}
+
+ScopedThreadPlacement::ScopedThreadPlacement(const ThreadTopology &topology, ThreadRole role, size_t index)
+{
+    if (topology.placementFor(role, index).empty())
+        return;
+#ifdef _WIN32
+    previousPriority_ = GetThreadPriority(GetCurrentThread());
+#else
+    previousCores_ = currentAffinity();
+    sched_param param{};
+    pthread_getschedparam(pthread_self(), &previousPolicy_, &param);
+    previousPriority_ = param.sched_priority;
+#endif
+    placed_ = true;
+    placeCurrentThread(topology, role, index);
+}
+
+ScopedThreadPlacement::~ScopedThreadPlacement()
+{
+    if (!placed_)
+        return;
+#ifdef _WIN32
+    // Threads start with the process affinity, so that is what goes back
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+        SetThreadAffinityMask(GetCurrentThread(), processMask);
+    SetThreadPriority(GetCurrentThread(), previousPriority_);
+#else
+    sched_param param{};
+    param.sched_priority = previousPriority_;
+    pthread_setschedparam(pthread_self(), previousPolicy_, &param);
+    if (!previousCores_.empty())
+        setAffinity(previousCores_);
+#endif
+}
+
+CallbackThreadPlacement::CallbackThreadPlacement(const ThreadTopology &topology, ThreadRole role)
+    : topology_(topology), role_(role)
+{
+    // Ids, not addresses, tell placements apart: a later run may reuse the address
+    static std::atomic<uint64_t> nextId{1};
+    id_ = nextId++;
+}
+
+void CallbackThreadPlacement::enter()
+{
+    thread_local uint64_t placedBy = 0;
+    if (placedBy == id_)
+        return;
+    placedBy = id_;
+    placeCurrentThread(topology_, role_);
+}
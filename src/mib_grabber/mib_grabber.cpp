@@ -1,5 +1,6 @@
 #include <iostream>
 #include <filesystem>
+#include <cstring>
 #include <EGrabber.h>
 #include <opencv2/opencv.hpp>
 #include <FormatConverter.h>
@@ -9,15 +10,19 @@
 #include <mutex>
 #include <condition_variable>
 #include <queue>
-#include <conio.h>
 #include <chrono>
 #include <iomanip>
 #include <CircularBuffer/CircularBuffer.h>
+#include <CircularBuffer/FrameRing.h>
 #include <tuple>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 #include <image_processing/image_processing.h>
 #include <menu_system/menu_system.h>
+#include <mib_grabber/EGrabberBufferProducer.h>
+#include <mib_grabber/EGrabberFrameSource.h>
+#include <mib_grabber/CameraWindow.h>
+#include <mib_grabber/GrabberSession.h>
 #include <nlohmann/json.hpp>
 // #include <mib_grabber/mib_grabber.h>
 // #include <../egrabber_config.h>
@@ -45,49 +50,17 @@ using namespace Euresys;
 //     // ... (other configuration settings)
 // }
 
-static int lastUsedCameraIndex = -1;
-
 void configure_js(std::string config_path)
 {
-    // Euresys::EGenTL gentl;
-    // Euresys::EGrabber<> grabber(gentl);
-    // if (config_path.substr(config_path.size() - 3) != ".js")
-    // {
-    //     throw std::runtime_error("Config path must end with .js");
-    // }
-    // grabber.runScript(config_path);
-    // std::cout << "Config script executed successfully" << std::endl;
     try
     {
-        Euresys::EGenTL gentl;
-        Euresys::EGrabberDiscovery discovery(gentl);
-
-        // Verify file extension
-        if (config_path.substr(config_path.size() - 3) != ".js")
-        {
-            throw std::runtime_error("Config path must end with .js");
-        }
-
-        // Discover available cameras
-        discovery.discover();
-
-        if (discovery.cameraCount() == 0)
-        {
-            throw std::runtime_error("No cameras detected");
-        }
-
-        // If no camera was previously selected, use the first one
-        if (lastUsedCameraIndex < 0 || lastUsedCameraIndex >= discovery.cameraCount())
-        {
-            lastUsedCameraIndex = 0;
-        }
-
-        // Initialize grabber with the last used camera
-        Euresys::EGrabber<> grabber(discovery.cameras(lastUsedCameraIndex));
-
-        // Run the configuration script
-        grabber.runScript(config_path);
-        std::cout << "Config script executed successfully on camera " << lastUsedCameraIndex << std::endl;
+        // Reuses the cached discovery and, during a run, the live grabber
+        ReloadResult result = GrabberSession::instance().runScript(config_path);
+        std::cout << "Config script executed successfully on camera " << GrabberSession::instance().selectedCamera()
+                  << " in " << result.scriptMs << " ms";
+        if (result.firstFrameMs >= 0)
+            std::cout << ", first frame after " << result.firstFrameMs << " ms";
+        std::cout << std::endl;
     }
     catch (const std::exception &e)
     {
@@ -95,20 +68,72 @@ void configure_js(std::string config_path)
     }
 }
 
-ImageParams initializeGrabber(EGrabber<CallbackOnDemand> &grabber)
+// Frame rate the camera is set to, falling back to target_fps for cameras
+// without AcquisitionFrameRate (e.g. externally triggered)
+template <typename CallbackModel>
+double cameraFrameRate(EGrabber<CallbackModel> &grabber, const json &config)
+{
+    try
+    {
+        return grabber.template getFloat<RemoteModule>("AcquisitionFrameRate");
+    }
+    catch (const std::exception &)
+    {
+        return config.value("target_fps", 5000.0);
+    }
+}
+
+// Records the camera's pixel format and how it is brought down to the 8-bit
+// frames of the ring: a PixelUnpacker fast path for mono formats, the
+// eGrabber FormatConverter for everything else (color, ...)
+void setSourcePixelFormat(ImageParams &params, uint64_t pixelFormat, const json &config)
+{
+    params.pixelFormat = pixelFormat;
+    params.levels = getPixelNormalization(config);
+    params.otherFormats = nullptr;
+    if (!PixelUnpacker::hasFastPath(pixelFormat))
+    {
+        struct Converter
+        {
+            explicit Converter(EGenTL &genTL) : converter(genTL) {}
+            FormatConverter converter;
+            std::mutex mutex;
+        };
+        auto shared = std::make_shared<Converter>(GrabberSession::instance().genTL());
+        size_t width = params.width, height = params.height;
+        params.otherFormats = [shared, pixelFormat, width, height](const uint8_t *raw, uint8_t *mono8)
+        {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            FormatConverter::Auto converted(shared->converter, FormatConverter::OutputFormat("Mono8"),
+                                            const_cast<uint8_t *>(raw), pixelFormat, width, height);
+            std::memcpy(mono8, converted.getBuffer(), width * height);
+        };
+    }
+    std::cout << "Pixel format " << PixelUnpacker::formatName(pixelFormat)
+              << (PixelUnpacker::hasFastPath(pixelFormat) ? "" : " (FormatConverter)") << std::endl;
+}
+
+ImageParams initializeGrabber(EGrabber<CallbackOnDemand> &grabber, const json &config)
 {
     grabber.reallocBuffers(3);
     grabber.start(1);
-    ScopedBuffer firstBuffer(grabber);
-
     ImageParams params;
-    params.width = firstBuffer.getInfo<size_t>(gc::BUFFER_INFO_WIDTH);
-    params.height = firstBuffer.getInfo<size_t>(gc::BUFFER_INFO_HEIGHT);
-    params.pixelFormat = firstBuffer.getInfo<uint64_t>(gc::BUFFER_INFO_PIXELFORMAT);
-    params.imageSize = firstBuffer.getInfo<size_t>(gc::BUFFER_INFO_SIZE);
-    params.bufferCount = 5000; // You can adjust this as needed
-
+    size_t bufferSize = 0;
+    {
+        ScopedBuffer firstBuffer(grabber);
+        params.width = firstBuffer.getInfo<size_t>(gc::BUFFER_INFO_WIDTH);
+        params.height = firstBuffer.getInfo<size_t>(gc::BUFFER_INFO_HEIGHT);
+        bufferSize = firstBuffer.getInfo<size_t>(gc::BUFFER_INFO_SIZE);
+    }
+    params.imageSize = params.width * params.height; // ring frames are 8-bit whatever the camera sends
+    params.bufferCount = 10000; // single ingest ring, so this is the whole history held in RAM
     grabber.stop();
+    // Same PFNC conversion as the callback producers
+    setSourcePixelFormat(params, grabberPixelFormat(grabber), config);
+
+    // The dispatcher holds one buffer at a time, so the pool only has to ride
+    // out its stalls; sized once here rather than regrown while pulling
+    grabber.reallocBuffers(getInitialBufferCount(config, cameraFrameRate(grabber, config), bufferSize));
     return params;
 }
 
@@ -119,14 +144,16 @@ void initializeBackgroundFrame(SharedResources &shared, const ImageParams &param
     cv::GaussianBlur(shared.backgroundFrame, shared.blurredBackground, cv::Size(3, 3), 0);
 }
 
-void triggerOut(EGrabber<CallbackOnDemand> &grabber, SharedResources &shared)
+template <typename CallbackModel>
+void triggerOut(EGrabber<CallbackModel> &grabber, SharedResources &shared)
 {
-    grabber.setString<InterfaceModule>("LineSelector", "TTLIO12");
-    grabber.setString<InterfaceModule>("LineMode", "Output");
-    grabber.setString<InterfaceModule>("LineSource", shared.triggerOut ? "High" : "Low");
+    grabber.template setString<InterfaceModule>("LineSelector", "TTLIO12");
+    grabber.template setString<InterfaceModule>("LineMode", "Output");
+    grabber.template setString<InterfaceModule>("LineSource", shared.triggerOut ? "High" : "Low");
 }
 
-void triggerThread(EGrabber<CallbackOnDemand> &grabber, SharedResources &shared)
+template <typename CallbackModel>
+void triggerThread(EGrabber<CallbackModel> &grabber, SharedResources &shared)
 {
     while (!shared.done)
     {
@@ -135,13 +162,36 @@ void triggerThread(EGrabber<CallbackOnDemand> &grabber, SharedResources &shared)
     }
 }
 
-void processTrigger(EGrabber<CallbackOnDemand> &grabber, SharedResources &shared)
+template <typename CallbackModel>
+void processTrigger(EGrabber<CallbackModel> &grabber, SharedResources &shared, const TriggerOptions &options)
 {
     if (shared.processTrigger)
     {
-        grabber.setString<InterfaceModule>("LineSelector", "TTLIO12");
-        grabber.setString<InterfaceModule>("LineMode", "Output");
-        grabber.setString<InterfaceModule>("LineSource", "High");
+        ClockEstimate clock = shared.clockSync.estimate();
+        uint64_t frameCameraUs = shared.triggerFrameCameraUs.load();
+        // 0 for another camera's frame before the clock fits could place it
+        bool cameraTime = clock.valid && frameCameraUs != 0;
+        if (options.delayUs > 0)
+        {
+            // Pulse at a fixed camera time after the frame. Without a clock
+            // fit, fall back to the same delay after the frame's arrival.
+            int64_t deadline = cameraTime ? clock.hostUs(frameCameraUs + options.delayUs)
+                                           : shared.triggerFrameSteadyUs.load() + options.delayUs;
+            deadline = std::min(deadline, steadyNowUs() + options.delayUs);
+            if (steadyNowUs() > deadline)
+                shared.lateTriggers++;
+            while (steadyNowUs() < deadline && !shared.done)
+            {
+                // Busy-wait
+            }
+        }
+        grabber.template setString<InterfaceModule>("LineSelector", "TTLIO12");
+        grabber.template setString<InterfaceModule>("LineMode", "Output");
+        grabber.template setString<InterfaceModule>("LineSource", "High");
+        int64_t firedUs = steadyNowUs();
+        shared.triggerLatencies.push(static_cast<double>(firedUs - shared.triggerFrameSteadyUs.load()));
+        if (cameraTime)
+            shared.exposureToTriggerLatencies.push(static_cast<double>(static_cast<int64_t>(clock.cameraUs(firedUs) - frameCameraUs)));
 
         // Busy-wait loop for approximately 1 microsecond
         auto start = std::chrono::high_resolution_clock::now();
@@ -149,154 +199,202 @@ void processTrigger(EGrabber<CallbackOnDemand> &grabber, SharedResources &shared
         {
             // Busy-wait
         }
-        grabber.setString<InterfaceModule>("LineSource", "Low");
+        grabber.template setString<InterfaceModule>("LineSource", "Low");
         shared.processTrigger = false;
     }
 }
 
-void processTriggerThread(EGrabber<CallbackOnDemand> &grabber, SharedResources &shared)
+template <typename CallbackModel>
+void processTriggerThread(EGrabber<CallbackModel> &grabber, SharedResources &shared)
 {
+    TriggerOptions options = getTriggerOptions(readConfig("config.json"));
     while (!shared.done)
     {
-        processTrigger(grabber, shared);
+        processTrigger(grabber, shared, options);
     }
 }
 
-void hybrid_sample(EGrabber<CallbackOnDemand> &grabber, const ImageParams &params, CircularBuffer &cameraBuffer, CircularBuffer &circularBuffer, CircularBuffer &processingBuffer, SharedResources &shared)
+void hybrid_sample(EGrabber<CallbackOnDemand> &grabber, const ImageParams &params, FrameSource &source, FrameRing &frameRing, SharedResources &shared)
 {
-    commonSampleLogic(shared, "default_save_directory", [&](SharedResources &shared, const std::string &saveDir)
-                      {
-                          std::vector<std::thread> threads;
-                          setupCommonThreads(shared, saveDir, circularBuffer, processingBuffer, params, threads);
-                          threads.emplace_back(simulateCameraThread, std::ref(cameraBuffer), std::ref(shared), std::ref(params));
-                          threads.emplace_back(triggerThread, std::ref(grabber), std::ref(shared));
-                          threads.emplace_back(processTriggerThread, std::ref(grabber), std::ref(shared));
-
-                          grabber.start();
-                          size_t lastProcessedFrame = 0;
-                          while (!shared.done)
-                          {
-                              if (shared.paused)
-                              {
-                                  std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                                  continue;
-                              }
-                              size_t latestFrame = shared.latestCameraFrame.load(std::memory_order_acquire);
-                              if (latestFrame != lastProcessedFrame)
-                              {
-                                  const uint8_t *imageData = cameraBuffer.getPointer(latestFrame);
-                                  if (imageData != nullptr)
-                                  {
-                                      circularBuffer.push(imageData);
-                                      processingBuffer.push(imageData);
-                                      {
-                                          std::lock_guard<std::mutex> displayLock(shared.displayQueueMutex);
-                                          std::lock_guard<std::mutex> processingLock(shared.processingQueueMutex);
-                                          shared.framesToProcess.push(latestFrame);
-                                          shared.framesToDisplay.push(latestFrame);
-                                      }
-                                      shared.displayQueueCondition.notify_one();
-                                      shared.processingQueueCondition.notify_one();
-                                      lastProcessedFrame = latestFrame;
-                                  }
-                              }
-                          }
-                          grabber.stop();
-                          return threads; });
+    // Replayed frames drive the pipeline while the live grabber handles the trigger output
+    grabber.start();
+    sourceSample(source, params, frameRing, shared, [&](std::vector<std::thread> &threads)
+                 {
+                     threads.push_back(placedThread(shared.threadTopology, ThreadRole::Trigger, 0, triggerThread<CallbackOnDemand>, std::ref(grabber), std::ref(shared)));
+                     threads.push_back(placedThread(shared.threadTopology, ThreadRole::Trigger, 1, processTriggerThread<CallbackOnDemand>, std::ref(grabber), std::ref(shared))); });
+    grabber.stop();
+}
+
+void temp_sample(EGrabber<CallbackOnDemand> &grabber, const ImageParams &params, FrameRing &frameRing, SharedResources &shared)
+{
+    EGrabberFrameSource source(grabber, params.width, params.height, params.imageSize);
+    sourceSample(source, params, frameRing, shared, [&](std::vector<std::thread> &threads)
+                 {
+                     threads.push_back(placedThread(shared.threadTopology, ThreadRole::Trigger, 0, triggerThread<CallbackOnDemand>, std::ref(grabber), std::ref(shared)));
+                     threads.push_back(placedThread(shared.threadTopology, ThreadRole::Trigger, 1, processTriggerThread<CallbackOnDemand>, std::ref(grabber), std::ref(shared))); });
+}
+
+// After a run ended with 'c' or 'C', moves the stopped camera to the software
+// ROI or back to the full sensor and returns the ROI to use in the new frame.
+// False when the run ended for any other reason.
+template <typename CallbackModel>
+bool moveCameraWindow(EGrabber<CallbackModel> &grabber, const SharedResources &finished,
+                      const CameraRoiOptions &options, cv::Rect &nextRoi)
+{
+    if (!finished.cameraWindowRequested)
+        return false;
+
+    CameraFeatures camera = cameraFeatures(grabber);
+    CameraWindowLimits limits = readCameraWindowLimits(camera);
+    CameraWindow current = readCameraWindow(camera);
+    CameraWindow request{limits.widthMax, limits.heightMax, 0, 0};
+    if (!finished.fullSensorRequested)
+        request = {finished.roi.width, finished.roi.height, current.offsetX + finished.roi.x, current.offsetY + finished.roi.y};
+
+    CameraWindowChange change = applyCameraWindow(camera, alignCameraWindow(request, limits), options.frameRate);
+    std::cout << "Camera window " << change.before.width << "x" << change.before.height << "+" << change.before.offsetX
+              << "+" << change.before.offsetY << " at " << change.frameRateBefore << " fps -> " << change.after.width
+              << "x" << change.after.height << "+" << change.after.offsetX << "+" << change.after.offsetY << " at "
+              << change.frameRateAfter << " fps" << std::endl;
+
+    // Keep the same pixels selected in the new frame's coordinates
+    cv::Rect frame(0, 0, static_cast<int>(change.after.width), static_cast<int>(change.after.height));
+    nextRoi = (finished.roi + cv::Point(static_cast<int>(change.before.offsetX - change.after.offsetX),
+                                        static_cast<int>(change.before.offsetY - change.after.offsetY))) &
+              frame;
+    if (nextRoi.area() == 0)
+        nextRoi = frame;
+    return true;
+}
+
+void runCallbackSample(const EGrabberCameraInfo &camera, const json &config)
+{
+    // GenTL buffers go straight to the processing workers; nothing is copied
+    // out of them except the display-rate frames fed to the ring. In "ring"
+    // mode the ring slots themselves are announced as the DMA buffers.
+    const auto &acquisition = config["acquisition"];
+    bool ringMode = acquisition.value("mode", "pull") == "ring";
+    BufferPoolOptions pool = getBufferPoolOptions(config);
+    CameraRoiOptions cameraRoi = getCameraRoiOptions(config);
+    std::string saveDirName;
+    cv::Rect nextRoi;
+
+    // A camera window change ends the run; the producer, its buffers and the
+    // ring are then rebuilt for the new frame size
+    while (true)
+    {
+        EGrabberBufferProducer producer(camera, pool.adaptive ? pool.minBuffers : acquisition.value("buffer_count", 64));
+        if (!ringMode && pool.adaptive)
+            producer.growPool(getInitialBufferCount(config, cameraFrameRate<CallbackMultiThread>(producer, config), producer.imageSize()));
+
+        ImageParams params;
+        params.width = producer.width();
+        params.height = producer.height();
+        // Ring slots double as grabber buffers in ring mode, so they take the whole payload
+        params.imageSize = ringMode ? producer.imageSize() : params.width * params.height;
+        params.bufferCount = 10000;
+        setSourcePixelFormat(params, producer.pixelFormat(), config);
+
+        FrameRing frameRing(getFrameRingCapacity(config, params.bufferCount), params.imageSize,
+                            getFrameStorageOptions(config));
+        SharedResources shared;
+        initializeBackgroundFrame(shared, params);
+        shared.roi = nextRoi.area() > 0 ? nextRoi : cv::Rect(0, 0, static_cast<int>(params.width), static_cast<int>(params.height));
+        shared.cameraRoiEnabled = cameraRoi.enabled;
+        shared.saveDirName = saveDirName;
+
+        EGrabber<CallbackMultiThread> &grabber = producer;
+        GrabberSession::Attachment attachment = GrabberSession::instance().attach(grabber, GrabberSession::instance().selectedCamera());
+        auto pollTelemetry = [&]()
+        {
+            SourceTelemetry telemetry = readGrabberTelemetry(grabber);
+            telemetry.delivered = producer.delivered();
+            return telemetry;
+        };
+        auto triggerThreads = [&](std::vector<std::thread> &threads)
+        {
+            threads.push_back(placedThread(shared.threadTopology, ThreadRole::Trigger, 0, triggerThread<CallbackMultiThread>, std::ref(grabber), std::ref(shared)));
+            threads.push_back(placedThread(shared.threadTopology, ThreadRole::Trigger, 1, processTriggerThread<CallbackMultiThread>, std::ref(grabber), std::ref(shared)));
+            threads.emplace_back(telemetryPollerThread, std::ref(shared), pollTelemetry, getTelemetryOptions(config).interval);
+        };
+        if (ringMode)
+            ringAcquisitionSample(producer, params, frameRing, shared, acquisition.value("queue_depth", 16), triggerThreads);
+        else
+            producerSample(producer, params, frameRing, shared, acquisition.value("processing_workers", 1), pool, triggerThreads);
+
+        if (!moveCameraWindow(grabber, shared, cameraRoi, nextRoi))
+            break;
+        saveDirName = shared.saveDirName;
+    }
 }
 
-void temp_sample(EGrabber<CallbackOnDemand> &grabber, const ImageParams &params, CircularBuffer &circularBuffer, CircularBuffer &processingBuffer, SharedResources &shared)
+void runMultiCameraSample(EGrabberDiscovery &discovery, const json &config)
 {
-    commonSampleLogic(shared, "default_save_directory", [&](SharedResources &shared, const std::string &saveDir)
+    // One callback producer, ring and set of workers per camera; camera_count
+    // 0 takes every camera discovered
+    const auto &acquisition = config["acquisition"];
+    int cameraCount = acquisition.value("camera_count", 1);
+    if (cameraCount <= 0 || cameraCount > discovery.cameraCount())
+        cameraCount = discovery.cameraCount();
+    BufferPoolOptions pool = getBufferPoolOptions(config);
+
+    std::vector<std::unique_ptr<EGrabberBufferProducer>> producers;
+    std::vector<CameraChannel> cameras;
+    for (int i = 0; i < cameraCount; ++i)
+    {
+        producers.push_back(std::make_unique<EGrabberBufferProducer>(
+            discovery.cameras(i), pool.adaptive ? pool.minBuffers : acquisition.value("buffer_count", 64)));
+        EGrabberBufferProducer &producer = *producers.back();
+        if (pool.adaptive)
+            producer.growPool(getInitialBufferCount(config, cameraFrameRate<CallbackMultiThread>(producer, config), producer.imageSize()));
+
+        CameraChannel camera;
+        camera.cameraId = i;
+        camera.producer = &producer;
+        camera.params.width = producer.width();
+        camera.params.height = producer.height();
+        camera.params.imageSize = camera.params.width * camera.params.height;
+        camera.params.bufferCount = 10000;
+        setSourcePixelFormat(camera.params, producer.pixelFormat(), config);
+        // Only camera 0's ring holds the configured history
+        FrameStorageOptions storage = getFrameStorageOptions(config);
+        if (i > 0)
+            storage.backingFile.clear();
+        size_t capacity = i == 0 ? getFrameRingCapacity(config, camera.params.bufferCount) : getSecondaryRingCapacity(config);
+        camera.frameRing = std::make_unique<FrameRing>(capacity, camera.params.imageSize, storage);
+        camera.shared = std::make_unique<SharedResources>();
+        initializeBackgroundFrame(*camera.shared, camera.params);
+        camera.shared->roi = cv::Rect(0, 0, static_cast<int>(camera.params.width), static_cast<int>(camera.params.height));
+        std::cout << "Camera " << i << ": " << discovery.cameras(i).grabbers[0].deviceModelName << ", "
+                  << camera.params.width << "x" << camera.params.height << std::endl;
+        cameras.push_back(std::move(camera));
+    }
+
+    std::vector<GrabberSession::Attachment> attachments;
+    for (int i = 0; i < cameraCount; ++i)
+        attachments.push_back(GrabberSession::instance().attach<CallbackMultiThread>(*producers[i], i));
+
+    // Trigger output and the dashboard telemetry follow camera 0
+    EGrabber<CallbackMultiThread> &grabber = *producers.front();
+    SharedResources &shared = *cameras.front().shared;
+    auto pollTelemetry = [&]()
+    {
+        SourceTelemetry telemetry = readGrabberTelemetry(grabber);
+        telemetry.delivered = producers.front()->delivered();
+        return telemetry;
+    };
+    multiCameraSample(cameras, acquisition.value("processing_workers", 1), pool, [&](std::vector<std::thread> &threads)
                       {
-                          std::vector<std::thread> threads;
-                          setupCommonThreads(shared, saveDir, circularBuffer, processingBuffer, params, threads);
-                          // Add trigger thread before starting the grabber
-                          threads.emplace_back(triggerThread, std::ref(grabber), std::ref(shared));
-                          threads.emplace_back(processTriggerThread, std::ref(grabber), std::ref(shared));
-
-                          grabber.start();
-                          // egrabber request fps and exposure time load to shared.resources for metric display
-                          uint64_t fr = grabber.getInteger<StreamModule>("StatisticsFrameRate");
-                          uint64_t dr = grabber.getInteger<StreamModule>("StatisticsDataRate");
-                          // Get exposure time
-                          uint64_t exposureTime = grabber.getInteger<RemoteModule>("ExposureTime");
-                          shared.currentFPS = fr;
-                          shared.dataRate = dr;
-                          shared.exposureTime = exposureTime;
-                          size_t frameCount = 0;
-                          uint64_t lastFrameId = 0;
-                          uint64_t duplicateCount = 0;
-                          while (!shared.done)
-                          {
-                              if (shared.paused)
-                              {
-                                  std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                                  cv::waitKey(1);
-                                  continue;
-                              }
-
-                              // Update FPS and other metrics periodically (every 100 frames or so)
-                              if (frameCount % 100 == 0)
-                              {
-                                  uint64_t fr = grabber.getInteger<StreamModule>("StatisticsFrameRate");
-                                  uint64_t dr = grabber.getInteger<StreamModule>("StatisticsDataRate");
-                                  uint64_t exposureTime = grabber.getInteger<RemoteModule>("ExposureTime");
-                                  shared.currentFPS = fr;
-                                  shared.dataRate = dr;
-                                  shared.exposureTime = exposureTime;
-                                  shared.updated = true;
-                              }
-
-                              ScopedBuffer buffer(grabber);
-                              uint8_t *imagePointer = buffer.getInfo<uint8_t *>(gc::BUFFER_INFO_BASE);
-                              uint64_t frameId = buffer.getInfo<uint64_t>(gc::BUFFER_INFO_FRAMEID);
-                              uint64_t timestamp = buffer.getInfo<uint64_t>(gc::BUFFER_INFO_TIMESTAMP);
-                              bool isIncomplete = buffer.getInfo<bool>(gc::BUFFER_INFO_IS_INCOMPLETE);
-                              size_t sizeFilled = buffer.getInfo<size_t>(gc::BUFFER_INFO_SIZE_FILLED);
-
-                              if (!isIncomplete)
-                              {
-                                  if (frameId <= lastFrameId)
-                                  {
-                                      ++duplicateCount;
-                                      //   std::cout << "Duplicate frame detected: FrameID=" << frameId << ", Timestamp=" << timestamp << std::endl;
-                                  }
-                                  else
-                                  {
-                                      circularBuffer.push(imagePointer);
-                                      processingBuffer.push(imagePointer);
-                                      {
-                                          std::lock_guard<std::mutex> displayLock(shared.displayQueueMutex);
-                                          std::lock_guard<std::mutex> processingLock(shared.processingQueueMutex);
-                                          shared.framesToProcess.push(frameCount);
-                                          shared.framesToDisplay.push(frameCount);
-                                      }
-                                      shared.displayQueueCondition.notify_one();
-                                      shared.processingQueueCondition.notify_one();
-                                      frameCount++;
-                                  }
-                                  lastFrameId = frameId;
-                              }
-                              else
-                              {
-                                  //   std::cout << "Incomplete frame received: FrameID=" << frameId << std::endl;
-                              }
-                          }
-
-                          grabber.stop();
-
-                          return threads; });
+                          threads.push_back(placedThread(shared.threadTopology, ThreadRole::Trigger, 0, triggerThread<CallbackMultiThread>, std::ref(grabber), std::ref(shared)));
+                          threads.push_back(placedThread(shared.threadTopology, ThreadRole::Trigger, 1, processTriggerThread<CallbackMultiThread>, std::ref(grabber), std::ref(shared)));
+                          threads.emplace_back(telemetryPollerThread, std::ref(shared), pollTelemetry, getTelemetryOptions(config).interval); });
 }
 
 void runHybridSample()
 {
     try
     {
-        EGenTL genTL;
-        EGrabberDiscovery discovery(genTL);
-        std::cout << "Scanning for available eGrabbers and cameras..." << std::endl;
-        discovery.discover();
+        EGrabberDiscovery &discovery = GrabberSession::instance().discovery();
 
         // Display available cameras
         if (discovery.cameraCount() == 0)
@@ -321,29 +419,32 @@ void runHybridSample()
             throw std::runtime_error("Invalid camera selection");
         }
 
-        lastUsedCameraIndex = selectedCamera;
+        GrabberSession::instance().selectCamera(selectedCamera);
         // Initialize grabber with selected camera
         EGrabber<CallbackOnDemand> grabber(discovery.cameras(selectedCamera));
-        ImageParams cameraParams = initializeGrabber(grabber);
+        json ringConfig = readConfig("config.json");
+        ImageParams cameraParams = initializeGrabber(grabber, ringConfig);
+        GrabberSession::Attachment attachment = GrabberSession::instance().attach(grabber, selectedCamera);
 
-        std::cout << "Select the image directory:\n";
-        std::string imageDirectory = MenuSystem::navigateAndSelectFolder();
-        ImageParams params = initializeImageParams(imageDirectory);
-        CircularBuffer cameraBuffer(params.bufferCount, params.imageSize);
-        CircularBuffer circularBuffer(params.bufferCount, params.imageSize);
-        CircularBuffer processingBuffer(params.bufferCount, params.imageSize);
-        loadImages(imageDirectory, cameraBuffer, true);
+        std::unique_ptr<ReplayFrameSource> source = MenuSystem::selectReplaySource(ringConfig);
+        if (!source)
+            return;
+        ImageParams params = initializeSourceParams(*source);
+        FrameRing frameRing(getFrameRingCapacity(ringConfig, params.bufferCount), params.imageSize,
+                            getFrameStorageOptions(ringConfig));
 
         SharedResources shared;
-        initializeMockBackgroundFrame(shared, params, cameraBuffer);
+        initializeMockBackgroundFrame(shared, params, source->frames());
         shared.roi = cv::Rect(0, 0, static_cast<int>(params.width), static_cast<int>(params.height));
 
-        hybrid_sample(grabber, params, cameraBuffer, circularBuffer, processingBuffer, shared);
+        hybrid_sample(grabber, params, *source, frameRing, shared);
 
         std::cout << "Hybrid sampling completed.\n";
     }
     catch (const std::exception &e)
     {
+        // The camera may have gone away; rescan on the next run
+        GrabberSession::instance().invalidateDiscovery();
         std::cerr << "Error: " << e.what() << std::endl;
     }
 }
@@ -352,12 +453,8 @@ int mib_grabber_main()
 {
     try
     {
-        EGenTL genTL;
-        EGrabberDiscovery discovery(genTL);
-
-        // Discover available cameras and grabbers
-        std::cout << "Scanning for available eGrabbers and cameras..." << std::endl;
-        discovery.discover();
+        // Discovery is cached by the session and reused on the next run
+        EGrabberDiscovery &discovery = GrabberSession::instance().discovery();
 
         // Display available cameras
         if (discovery.cameraCount() == 0)
@@ -365,6 +462,13 @@ int mib_grabber_main()
             throw std::runtime_error("No cameras detected in the system");
         }
 
+        json config = readConfig("config.json");
+        if (useMultiCamera(config))
+        {
+            runMultiCameraSample(discovery, config);
+            return 0;
+        }
+
         std::cout << "\nAvailable cameras:" << std::endl;
         for (int i = 0; i < discovery.cameraCount(); ++i)
         {
@@ -382,7 +486,16 @@ int mib_grabber_main()
             throw std::runtime_error("Invalid camera selection");
         }
 
-        lastUsedCameraIndex = selectedCamera;
+        GrabberSession::instance().selectCamera(selectedCamera);
+
+        const auto &acquisition = config["acquisition"];
+        std::string mode = acquisition.value("mode", "pull");
+        if (mode == "callback" || mode == "ring")
+        {
+            runCallbackSample(discovery.cameras(selectedCamera), config);
+            return 0;
+        }
+
         // Initialize grabber with selected camera
         EGrabber<CallbackOnDemand> grabber(discovery.cameras(selectedCamera));
 
@@ -406,17 +519,32 @@ int mib_grabber_main()
         // }
 
         // Continue with your existing initialization and grabbing logic
-        ImageParams params = initializeGrabber(grabber);
-        CircularBuffer circularBuffer(params.bufferCount, params.imageSize);
-        CircularBuffer processingBuffer(params.bufferCount, params.imageSize);
-        SharedResources shared;
-        initializeBackgroundFrame(shared, params);
-        shared.roi = cv::Rect(0, 0, params.width, params.height);
-
-        temp_sample(grabber, params, circularBuffer, processingBuffer, shared);
+        GrabberSession::Attachment attachment = GrabberSession::instance().attach(grabber, selectedCamera);
+        CameraRoiOptions cameraRoi = getCameraRoiOptions(config);
+        std::string saveDirName;
+        cv::Rect nextRoi;
+        while (true)
+        {
+            // Buffers and ring are reallocated for the frame size of each run
+            ImageParams params = initializeGrabber(grabber, config);
+            FrameRing frameRing(getFrameRingCapacity(config, params.bufferCount), params.imageSize,
+                                getFrameStorageOptions(config));
+            SharedResources shared;
+            initializeBackgroundFrame(shared, params);
+            shared.roi = nextRoi.area() > 0 ? nextRoi : cv::Rect(0, 0, params.width, params.height);
+            shared.cameraRoiEnabled = cameraRoi.enabled;
+            shared.saveDirName = saveDirName;
+
+            temp_sample(grabber, params, frameRing, shared);
+
+            if (!moveCameraWindow(grabber, shared, cameraRoi, nextRoi))
+                break;
+            saveDirName = shared.saveDirName;
+        }
     }
     catch (const std::exception &e)
     {
+        GrabberSession::instance().invalidateDiscovery();
         std::cout << "Error: " << e.what() << std::endl;
         return 1;
     }
@@ -0,0 +1,138 @@
+// Pushes sequence numbers through a BoundedQueue at full speed into a
+// consumer that drains in bursts with pauses, as the display does, under each
+// overflow policy. Checks that items come out in order and once each, that
+// pushed items are all accounted for as popped, dropped, coalesced or still
+// queued, and that the queue never held more than its capacity. A second run
+// has several producers and consumers and a consumer sleeping in popWait.
+#include "CircularBuffer/BoundedQueue.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const uint64_t ITEMS = 2000000;
+
+    struct Result
+    {
+        uint64_t popped = 0;
+        uint64_t lostByPush = 0;
+        uint64_t outOfOrder = 0;
+    };
+
+    bool report(const char *label, const BoundedQueue<uint64_t> &queue, const Result &result, uint64_t items)
+    {
+        BoundedQueueStats stats = queue.stats();
+        bool accounted = result.popped + stats.dropped + stats.coalesced + stats.size == items &&
+                         result.lostByPush == stats.dropped + stats.coalesced && stats.pushed == items;
+        bool ok = accounted && result.outOfOrder == 0 && stats.highWater <= stats.capacity;
+        std::cout << label << ": " << stats.pushed << " pushed, " << result.popped << " popped, " << stats.dropped
+                  << " dropped, " << stats.coalesced << " coalesced, " << stats.size << " left, high water "
+                  << stats.highWater << "/" << stats.capacity << ", " << result.outOfOrder << " out of order"
+                  << (ok ? "" : "  <-- FAILED") << std::endl;
+        return ok;
+    }
+
+    // One producer, one consumer taking up to 32 items then resting
+    bool runPolicy(const char *label, OverflowPolicy policy, size_t capacity)
+    {
+        BoundedQueueOptions options;
+        options.capacity = capacity;
+        options.policy = policy;
+        options.timeout = std::chrono::microseconds(20);
+        BoundedQueue<uint64_t> queue(options);
+        std::atomic<bool> producing{true};
+        Result result;
+
+        std::thread consumer([&]()
+                             {
+            uint64_t last = 0;
+            while (producing || !queue.empty())
+            {
+                uint64_t item;
+                for (int i = 0; i < 32 && queue.tryPop(item); ++i)
+                {
+                    if (item <= last)
+                        ++result.outOfOrder;
+                    last = item;
+                    ++result.popped;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            } });
+
+        for (uint64_t i = 1; i <= ITEMS; ++i)
+            result.lostByPush += queue.push(i);
+        producing = false;
+        consumer.join();
+        return report(label, queue, result, ITEMS);
+    }
+
+    // Four producers and four consumers; consumers sleep in popWait. Items
+    // from one producer must still come out of one consumer in order.
+    bool runConcurrent()
+    {
+        const int PRODUCERS = 4;
+        const int CONSUMERS = 4;
+        const uint64_t PER_PRODUCER = ITEMS / PRODUCERS;
+        BoundedQueueOptions options;
+        options.capacity = 256;
+        BoundedQueue<uint64_t> queue(options);
+        std::atomic<int> producing{PRODUCERS};
+        std::atomic<uint64_t> popped{0};
+        std::atomic<uint64_t> lost{0};
+        std::atomic<uint64_t> outOfOrder{0};
+
+        std::vector<std::thread> threads;
+        for (int c = 0; c < CONSUMERS; ++c)
+        {
+            threads.emplace_back([&]()
+                                 {
+                std::vector<uint64_t> last(PRODUCERS, 0);
+                while (true)
+                {
+                    uint64_t item;
+                    if (!queue.popWait(item, std::chrono::milliseconds(5)))
+                    {
+                        if (producing == 0 && queue.empty())
+                            break;
+                        continue;
+                    }
+                    uint64_t producer = item / PER_PRODUCER;
+                    if (item <= last[producer] && last[producer] != 0)
+                        ++outOfOrder;
+                    last[producer] = item;
+                    ++popped;
+                } });
+        }
+        for (int p = 0; p < PRODUCERS; ++p)
+        {
+            threads.emplace_back([&, p]()
+                                 {
+                for (uint64_t i = 0; i < PER_PRODUCER; ++i)
+                {
+                    lost += queue.push(p * PER_PRODUCER + i);
+                    if (i % 4096 == 0)
+                        std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+                --producing; });
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        Result result;
+        result.popped = popped;
+        result.lostByPush = lost;
+        result.outOfOrder = outOfOrder;
+        return report("4x4 drop_oldest", queue, result, PER_PRODUCER * PRODUCERS);
+    }
+}
+
+int main()
+{
+    bool passed = runPolicy("drop_oldest", OverflowPolicy::DropOldest, 64);
+    passed = runPolicy("coalesce_latest", OverflowPolicy::CoalesceLatest, 1) && passed;
+    passed = runPolicy("block_timeout", OverflowPolicy::BlockWithTimeout, 64) && passed;
+    passed = runConcurrent() && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
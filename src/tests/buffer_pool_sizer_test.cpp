@@ -0,0 +1,47 @@
+// Checks BufferPoolSizer arithmetic and runs a short buffer count sweep
+// against the mock producer with a consumer that stalls 2 ms every 250
+// frames at 5 kHz: a pool that cannot absorb ten frames must lose some, one
+// sized by the sizer for that stall should lose (almost) none.
+#include "mib_grabber/BufferPoolSizer.h"
+#include <iostream>
+#include <thread>
+
+int main()
+{
+    bool passed = true;
+    const size_t imageSize = 512 * 96;
+
+    BufferPoolOptions options;
+    options.memoryBudgetBytes = 64 * imageSize;
+    BufferPoolSizer sizer(options, imageSize);
+    // 200 us frames, 2 ms p99.9: 11 in flight, doubled
+    passed = passed && sizer.target(200.0, 2000.0) == 22;
+    passed = passed && sizer.target(200.0, 0.0) == options.minBuffers;
+    passed = passed && sizer.target(200.0, 1e6) == 64; // clamped to the budget
+    passed = passed && sizer.grow(20, 200.0, 2000.0) == 20 && sizer.grow(8, 200.0, 2000.0) == 22;
+    std::cout << "Sizer: " << sizer.initialCount(5000.0) << " buffers at 5 kHz, max " << sizer.maxCount() << std::endl;
+
+    CircularBuffer frames(4, imageSize);
+    std::vector<uint8_t> frame(imageSize, 128);
+    for (size_t i = 0; i < 4; ++i)
+        frames.push(frame.data());
+
+    std::atomic<uint64_t> consumed{0};
+    auto consume = [&](const AcquiredBuffer &)
+    {
+        if (++consumed % 250 == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    };
+    std::vector<size_t> counts = {2, sizer.target(200.0, 2000.0)};
+    std::vector<PoolSweepResult> results = sweepBufferPool(frames, imageSize, 5000.0, counts, 1,
+                                                           std::chrono::milliseconds(1500), consume);
+    for (const auto &result : results)
+    {
+        std::cout << result.bufferCount << " buffers: " << result.received << " received, " << result.lost
+                  << " lost (" << result.lossPercent << "%), p99.9 hold " << result.holdP999Us << " us" << std::endl;
+    }
+    passed = passed && results.size() == 2 && results[0].lost > 0 && results[1].lossPercent < results[0].lossPercent;
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
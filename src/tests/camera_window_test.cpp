@@ -0,0 +1,132 @@
+// Drives applyCameraWindow against a model camera that rejects any write a
+// real sensor would: a window off the sensor, a size or offset off its
+// increment, or a frame rate above what the current window can stream. Moves
+// through shrinking, growing and pure-offset changes and checks the camera
+// ends on the aligned window at the rate requested.
+#include "mib_grabber/CameraWindow.h"
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+
+namespace
+{
+    class ModelCamera
+    {
+    public:
+        static constexpr int64_t SENSOR_WIDTH = 1920;
+        static constexpr int64_t SENSOR_HEIGHT = 1080;
+        static constexpr double LINE_TIME_US = 0.9; // rate is limited by the rows read out
+
+        double maxRate() const { return std::min(1e6 / (integers_.at("Height") * LINE_TIME_US), 20000.0); }
+
+        CameraFeatures features()
+        {
+            CameraFeatures features;
+            features.getInteger = [this](const std::string &name)
+            {
+                if (name == "WidthMax")
+                    return SENSOR_WIDTH;
+                if (name == "HeightMax")
+                    return SENSOR_HEIGHT;
+                if (name == "Width.Inc" || name == "OffsetX.Inc")
+                    return int64_t{16};
+                if (name == "Height.Inc" || name == "OffsetY.Inc")
+                    return int64_t{4};
+                if (name == "Width.Min")
+                    return int64_t{64};
+                if (!integers_.count(name))
+                    throw std::runtime_error("no feature " + name);
+                return integers_.at(name);
+            };
+            features.setInteger = [this](const std::string &name, int64_t value)
+            {
+                std::map<std::string, int64_t> next = integers_;
+                next[name] = value;
+                if (next["OffsetX"] + next["Width"] > SENSOR_WIDTH || next["OffsetY"] + next["Height"] > SENSOR_HEIGHT)
+                    throw std::runtime_error(name + " would leave the sensor");
+                if (next["Width"] % 16 || next["OffsetX"] % 16 || next["Height"] % 4 || next["OffsetY"] % 4)
+                    throw std::runtime_error(name + " is off its increment");
+                if (rate_ > std::min(1e6 / (next["Height"] * LINE_TIME_US), 20000.0) + 1e-6)
+                    throw std::runtime_error(name + " is too large for the frame rate");
+                integers_ = next;
+                ++writes_;
+            };
+            features.getFloat = [this](const std::string &name)
+            {
+                if (name == "AcquisitionFrameRate")
+                    return rate_;
+                if (name == "AcquisitionFrameRate.Min")
+                    return 10.0;
+                if (name == "AcquisitionFrameRate.Max")
+                    return maxRate();
+                throw std::runtime_error("no feature " + name);
+            };
+            features.setFloat = [this](const std::string &name, double value)
+            {
+                if (name != "AcquisitionFrameRate" || value < 10.0 || value > maxRate() + 1e-6)
+                    throw std::runtime_error("rejected " + name + " = " + std::to_string(value));
+                rate_ = value;
+                ++writes_;
+            };
+            return features;
+        }
+
+        size_t writes() const { return writes_; }
+
+    private:
+        std::map<std::string, int64_t> integers_{{"Width", 1920}, {"Height", 1080}, {"OffsetX", 0}, {"OffsetY", 0}};
+        double rate_ = 900.0;
+        size_t writes_ = 0;
+    };
+
+    bool sameWindow(const CameraWindow &a, const CameraWindow &b)
+    {
+        return a.width == b.width && a.height == b.height && a.offsetX == b.offsetX && a.offsetY == b.offsetY;
+    }
+
+    bool move(ModelCamera &model, const CameraWindow &request, double frameRate, const char *label)
+    {
+        CameraFeatures camera = model.features();
+        CameraWindow target = alignCameraWindow(request, readCameraWindowLimits(camera));
+        bool covers = target.offsetX <= std::max<int64_t>(request.offsetX, 0) &&
+                      target.offsetY <= std::max<int64_t>(request.offsetY, 0) &&
+                      target.offsetX + target.width >= std::min(request.offsetX + request.width, ModelCamera::SENSOR_WIDTH) &&
+                      target.offsetY + target.height >= std::min(request.offsetY + request.height, ModelCamera::SENSOR_HEIGHT);
+        try
+        {
+            CameraWindowChange change = applyCameraWindow(camera, target, frameRate);
+            double expectedRate = frameRate > 0 ? std::min(frameRate, model.maxRate()) : model.maxRate();
+            bool ok = covers && sameWindow(change.after, target) && std::abs(change.frameRateAfter - expectedRate) < 1e-6;
+            std::cout << label << ": " << change.after.width << "x" << change.after.height << "+" << change.after.offsetX
+                      << "+" << change.after.offsetY << " at " << change.frameRateAfter << " fps (was "
+                      << change.frameRateBefore << ")" << (ok ? "" : "  <-- unexpected") << std::endl;
+            return ok;
+        }
+        catch (const std::exception &e)
+        {
+            std::cout << label << ": camera rejected a write: " << e.what() << std::endl;
+            return false;
+        }
+    }
+}
+
+int main()
+{
+    ModelCamera model;
+    bool passed = true;
+    // Channel strip as the chip needs: odd software ROI, raise to the maximum
+    passed = move(model, {509, 93, 700, 491}, 0, "Shrink to channel") && passed;
+    // Same size elsewhere on the sensor
+    passed = move(model, {512, 96, 1200, 100}, 0, "Move offset") && passed;
+    // Taller window at a fixed rate that the old window allowed but the new one does not
+    passed = move(model, {1024, 800, 100, 200}, 5000, "Grow with capped rate") && passed;
+    // Back to the full sensor
+    passed = move(model, {1920, 1080, 0, 0}, 0, "Full sensor") && passed;
+    // ROI hanging off the sensor edge is pulled back on
+    passed = move(model, {300, 50, 1800, 1060}, 0, "Edge ROI") && passed;
+
+    std::cout << model.writes() << " feature writes" << std::endl;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+// Feeds ClockSync a simulated camera clock running 50 ppm slow against the
+// host, with a fixed transfer time plus random delivery delay and occasional
+// multi-millisecond stalls, as frames arrive at 5 kHz. Checks the fitted drift
+// and that mapped times follow the fastest-delivery line, that hostUs and
+// cameraUs invert each other, and that a camera clock reset is picked up.
+#include "mib_grabber/ClockSync.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    const double DRIFT_PPM = 50.0;      // host ticks this much faster than the camera
+    const int64_t TRANSFER_US = 20;     // least delivery delay
+    const double FRAME_INTERVAL_US = 200.0;
+
+    struct Camera
+    {
+        uint64_t startUs;
+        double hostStartUs; // host time when the camera clock read startUs
+        // Host time at which the camera stamps cameraUs
+        double hostAt(uint64_t cameraUs) const
+        {
+            return hostStartUs + static_cast<double>(cameraUs - startUs) * (1.0 + DRIFT_PPM * 1e-6);
+        }
+    };
+
+    // Runs frames through sync; returns the largest error of the mapped
+    // arrival time against the true fastest-delivery time over the last half
+    double run(ClockSync &sync, const Camera &camera, size_t frames, std::mt19937 &random)
+    {
+        std::exponential_distribution<double> jitter(1.0 / 30.0);
+        std::uniform_int_distribution<int> stall(0, 999);
+        double worst = 0;
+        for (size_t i = 0; i < frames; ++i)
+        {
+            uint64_t cameraUs = camera.startUs + static_cast<uint64_t>(i * FRAME_INTERVAL_US);
+            double delay = TRANSFER_US + jitter(random) + (stall(random) == 0 ? 3000.0 : 0.0);
+            sync.observe(cameraUs, static_cast<int64_t>(camera.hostAt(cameraUs) + delay));
+
+            ClockEstimate estimate = sync.estimate();
+            if (i > frames / 2 && estimate.valid)
+            {
+                double expected = camera.hostAt(cameraUs) + TRANSFER_US;
+                worst = std::max(worst, std::abs(estimate.hostUs(cameraUs) - expected));
+            }
+        }
+        return worst;
+    }
+}
+
+int main()
+{
+    std::mt19937 random(7);
+    ClockSync sync;
+    bool passed = true;
+
+    Camera camera{123456789000, 5e6};
+    double worst = run(sync, camera, 100000, random);
+    ClockEstimate estimate = sync.estimate();
+    bool driftOk = std::abs(estimate.driftPpm - DRIFT_PPM) < 2.0;
+    bool mappingOk = worst < 5.0;
+    std::cout << "Drift " << estimate.driftPpm << " ppm (true " << DRIFT_PPM << "), residual " << estimate.residualUs
+              << " us, worst mapped arrival error " << worst << " us" << std::endl;
+    passed = driftOk && mappingOk && passed;
+
+    // hostUs and cameraUs are inverses, to within rounding
+    uint64_t probe = camera.startUs + 15000000;
+    int64_t roundTrip = static_cast<int64_t>(estimate.cameraUs(estimate.hostUs(probe)) - probe);
+    std::cout << "Round trip error " << roundTrip << " us" << std::endl;
+    passed = std::abs(roundTrip) <= 1 && passed;
+
+    // The camera restarts and its clock starts from zero
+    Camera restarted{1000, camera.hostAt(probe) + 2e6};
+    worst = run(sync, restarted, 50000, random);
+    estimate = sync.estimate();
+    std::cout << "After camera reset: " << sync.resyncs() << " resync(s), drift " << estimate.driftPpm
+              << " ppm, worst mapped arrival error " << worst << " us" << std::endl;
+    passed = sync.resyncs() == 1 && std::abs(estimate.driftPpm - DRIFT_PPM) < 2.0 && worst < 5.0 && passed;
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
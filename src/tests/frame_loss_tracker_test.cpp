@@ -0,0 +1,70 @@
+// Checks FrameLossTracker accounting on a scripted frame id sequence: gaps are
+// counted as missing ids, duplicates are rejected, a late frame fills its gap
+// and the loss rate, over the frames the camera sent, covers only the second
+// in which frames were lost. An old id that was never missing is a duplicate
+// even when it is not adjacent, and a long jump back restarts gap counting
+// from the new id.
+#include "mib_grabber/FrameLossTracker.h"
+#include <iostream>
+#include <thread>
+
+int main()
+{
+    bool passed = true;
+    FrameLossTracker tracker;
+
+    // 1 2 3 _ _ 6 6 7 _ 9 then 8 arrives late: one gap left, one duplicate
+    for (uint64_t id : {1, 2, 3, 6})
+        passed = tracker.observeFrameId(id) && passed;
+    passed = !tracker.observeFrameId(6) && passed;
+    for (uint64_t id : {7, 9, 8})
+        passed = tracker.observeFrameId(id) && passed;
+    tracker.count(LossCause::QueueDrop, 2);
+
+    FrameLossSnapshot loss = tracker.snapshot();
+    std::cout << tracker.summary() << std::endl;
+    passed = passed && loss.received == 7;
+    passed = passed && loss.lost[static_cast<size_t>(LossCause::CameraGap)] == 2;
+    passed = passed && loss.lost[static_cast<size_t>(LossCause::Duplicate)] == 1;
+    passed = passed && loss.totalLost() == 4; // duplicates are not lost frames
+
+    // The queue drops were received first, so 4 of the 9 frames sent were lost
+    passed = passed && loss.cameraLost() == 2 && loss.lossPercent() > 44.0 && loss.lossPercent() < 45.0;
+
+    // One sample with losses, then an idle interval that must not add a zero
+    tracker.sampleIfDue(std::chrono::milliseconds(0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    tracker.sampleIfDue(std::chrono::milliseconds(1));
+    RollingStatsSnapshot rates = tracker.lossRateStats();
+    std::cout << "Loss rate samples: " << rates.count << ", latest " << rates.latest << "%" << std::endl;
+    passed = passed && rates.count == 1 && rates.latest > 44.0 && rates.latest < 45.0;
+
+    tracker.reset();
+    passed = passed && tracker.snapshot().totalLost() == 0 && tracker.observeFrameId(100) &&
+             tracker.snapshot().lost[static_cast<size_t>(LossCause::CameraGap)] == 0;
+
+    // 1 2 3 2: the second 2 is a duplicate, not a late frame; 5 4 4: the
+    // first 4 fills its gap, the second is a duplicate
+    tracker.reset();
+    for (uint64_t id : {1, 2, 3})
+        passed = tracker.observeFrameId(id) && passed;
+    passed = !tracker.observeFrameId(2) && passed;
+    passed = tracker.observeFrameId(5) && tracker.observeFrameId(4) && !tracker.observeFrameId(4) && passed;
+    loss = tracker.snapshot();
+    std::cout << tracker.summary() << std::endl;
+    passed = passed && loss.received == 5;
+    passed = passed && loss.lost[static_cast<size_t>(LossCause::CameraGap)] == 0;
+    passed = passed && loss.lost[static_cast<size_t>(LossCause::Duplicate)] == 2;
+
+    // Counter reset from 50000 back to 0, then a gap at 2 that still counts
+    tracker.reset();
+    for (uint64_t id : {49998, 49999, 50000, 0, 1, 3})
+        passed = tracker.observeFrameId(id) && passed;
+    loss = tracker.snapshot();
+    std::cout << tracker.summary() << std::endl;
+    passed = passed && tracker.frameIdResets() == 1 && loss.received == 6;
+    passed = passed && loss.lost[static_cast<size_t>(LossCause::CameraGap)] == 1;
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
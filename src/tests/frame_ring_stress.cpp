@@ -0,0 +1,159 @@
+// Stress test for FrameRing: one writer pushing at full speed against several
+// readers. Every frame is filled with a pattern derived from its sequence
+// number, so a reader can tell whether a frame that passed the seqlock check
+// was actually consistent. Leasing readers check that a pinned slot is never
+// overwritten while they hold it, and a pinned consumer checks that it sees
+// every frame exactly once, in order.
+#include "CircularBuffer/FrameRing.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const size_t RING_SIZE = 64;
+    const size_t IMAGE_SIZE = 512 * 96;
+    const int READER_COUNT = 4;
+    const auto TEST_DURATION = std::chrono::seconds(3);
+
+    void fillFrame(std::vector<uint8_t> &frame, uint64_t sequence)
+    {
+        std::memcpy(frame.data(), &sequence, sizeof(sequence));
+        std::memset(frame.data() + sizeof(sequence), static_cast<int>(sequence & 0xFF), frame.size() - sizeof(sequence));
+    }
+
+    bool frameIsConsistent(const uint8_t *frame, uint64_t expectedSequence = 0)
+    {
+        uint64_t sequence;
+        std::memcpy(&sequence, frame, sizeof(sequence));
+        if (expectedSequence != 0 && sequence != expectedSequence)
+            return false;
+        uint8_t expected = static_cast<uint8_t>(sequence & 0xFF);
+        for (size_t i = sizeof(sequence); i < IMAGE_SIZE; ++i)
+        {
+            if (frame[i] != expected)
+                return false;
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    FrameRing ring(RING_SIZE, IMAGE_SIZE);
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> goodReads{0};
+    std::atomic<uint64_t> rejectedReads{0};
+    std::atomic<uint64_t> corruptReads{0};
+    std::atomic<uint64_t> pinnedConsumerGaps{0};
+    size_t pinnedConsumer = ring.registerConsumer("recorder", ConsumerMode::Pinned);
+    size_t lossyConsumer = ring.registerConsumer("display");
+
+    std::thread writer([&]()
+                       {
+        std::vector<uint8_t> frame(IMAGE_SIZE);
+        while (!done)
+        {
+            // A push rejected by a leased slot does not consume a sequence number
+            fillFrame(frame, ring.latestSequence() + 1);
+            ring.push(frame.data());
+        } });
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READER_COUNT; ++r)
+    {
+        readers.emplace_back([&, r]()
+                             {
+            std::vector<uint8_t> frame(IMAGE_SIZE);
+            size_t index = 0;
+            while (!done)
+            {
+                // Alternate between the newest frame and the oldest ones, which
+                // are the slots the writer is about to overwrite.
+                index = (r % 2 == 0) ? 0 : RING_SIZE - 1 - (index % 4);
+                if (ring.read(index, frame.data()))
+                {
+                    if (frameIsConsistent(frame.data()))
+                        ++goodReads;
+                    else
+                        ++corruptReads;
+                }
+                else
+                {
+                    ++rejectedReads;
+                }
+                ++index;
+            } });
+    }
+
+    readers.emplace_back([&]()
+                         {
+        size_t index = 0;
+        while (!done)
+        {
+            FrameLease lease = ring.lease(index % RING_SIZE);
+            if (lease)
+            {
+                // Hold the slot long enough for the writer to lap the ring
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                if (frameIsConsistent(lease.data(), lease.sequence()))
+                    ++goodReads;
+                else
+                    ++corruptReads;
+            }
+            else
+            {
+                ++rejectedReads;
+            }
+            ++index;
+        } });
+
+    readers.emplace_back([&]()
+                         {
+        uint64_t expected = 1;
+        while (!done)
+        {
+            FrameLease lease = ring.next(pinnedConsumer);
+            if (!lease)
+                continue;
+            if (lease.sequence() != expected || lease.meta().sequence != lease.sequence() ||
+                !frameIsConsistent(lease.data(), lease.sequence()))
+                ++pinnedConsumerGaps;
+            expected = lease.sequence() + 1;
+        } });
+
+    readers.emplace_back([&]()
+                         {
+        while (!done)
+        {
+            FrameLease lease = ring.latest(lossyConsumer);
+            if (lease && !frameIsConsistent(lease.data(), lease.sequence()))
+                ++corruptReads;
+        } });
+
+    std::this_thread::sleep_for(TEST_DURATION);
+    done = true;
+    writer.join();
+    for (auto &reader : readers)
+        reader.join();
+
+    std::cout << "Frames written: " << ring.latestSequence() << std::endl;
+    std::cout << "Good reads: " << goodReads << std::endl;
+    std::cout << "Rejected (torn/overwritten) reads: " << rejectedReads << std::endl;
+    std::cout << "Frames dropped on leased slots: " << ring.pinnedDrops() << std::endl;
+    std::cout << "Frames dropped for the pinned consumer: " << ring.consumerDrops() << std::endl;
+    std::cout << "Pinned consumer gaps: " << pinnedConsumerGaps << std::endl;
+    std::cout << "Lossy consumer skipped: " << ring.consumerStats(lossyConsumer).skipped << std::endl;
+    std::cout << "Corrupt reads that passed validation: " << corruptReads << std::endl;
+
+    if (corruptReads != 0 || pinnedConsumerGaps != 0 || goodReads == 0)
+    {
+        std::cout << "FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
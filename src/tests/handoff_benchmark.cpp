@@ -0,0 +1,235 @@
+// Compares the old per-frame handoff (two mutexes, two queues and two
+// notify_one calls per frame) with SequenceSignal (one published sequence,
+// consumers spin then park) at 5 kHz, with two consumers: one idle between
+// frames and one busy for most of the frame period, like display and
+// processing. Prints the wake latency from publish to the consumer seeing the
+// frame, the CPU used and the wake-up system calls made, and checks that no
+// consumer ever missed a wake-up.
+#include "CircularBuffer/SequenceSignal.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    const uint64_t FRAMES = 10000;
+    const auto FRAME_PERIOD = std::chrono::microseconds(200); // 5 kHz
+    const auto BUSY_WORK = std::chrono::microseconds(150);
+
+    double processCpuSeconds()
+    {
+#ifdef _WIN32
+        FILETIME created, exited, kernel, user;
+        GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user);
+        auto seconds = [](const FILETIME &time)
+        { return ((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 1e-7; };
+        return seconds(kernel) + seconds(user);
+#else
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+#endif
+    }
+
+    int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void busyFor(std::chrono::microseconds duration)
+    {
+        auto end = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < end)
+        {
+        }
+    }
+
+    struct Run
+    {
+        std::vector<int64_t> publishedNs = std::vector<int64_t>(FRAMES + 1, 0);
+        std::vector<double> latenciesUs[2];
+        uint64_t lastSeen[2] = {0, 0};
+        uint64_t wakeCalls = 0;
+        double cpuSeconds = 0.0;
+        double wallSeconds = 0.0;
+    };
+
+    // Paces FRAMES publications at FRAME_PERIOD, calling publish(sequence)
+    template <typename Publish>
+    void produce(Run &run, Publish &&publish)
+    {
+        auto next = std::chrono::steady_clock::now();
+        for (uint64_t sequence = 1; sequence <= FRAMES; ++sequence)
+        {
+            next += FRAME_PERIOD;
+            std::this_thread::sleep_until(next);
+            run.publishedNs[sequence] = nowNs();
+            publish(sequence);
+        }
+    }
+
+    // A consumer woke and found frames up to sequence
+    void noteWake(Run &run, int consumer, uint64_t sequence)
+    {
+        run.latenciesUs[consumer].push_back((nowNs() - run.publishedNs[sequence]) / 1000.0);
+        run.lastSeen[consumer] = sequence;
+        if (consumer == 1)
+            busyFor(BUSY_WORK);
+    }
+
+    Run runMutexCondvar()
+    {
+        Run run;
+        std::mutex mutexes[2];
+        std::condition_variable conditions[2];
+        std::queue<uint64_t> queues[2];
+        std::atomic<bool> done{false};
+
+        std::vector<std::thread> consumers;
+        for (int c = 0; c < 2; ++c)
+        {
+            consumers.emplace_back([&, c]()
+                                   {
+                while (true)
+                {
+                    uint64_t newest = 0;
+                    {
+                        std::unique_lock<std::mutex> lock(mutexes[c]);
+                        conditions[c].wait(lock, [&]()
+                                           { return !queues[c].empty() || done; });
+                        if (queues[c].empty())
+                            break;
+                        while (!queues[c].empty())
+                        {
+                            newest = queues[c].front();
+                            queues[c].pop();
+                        }
+                    }
+                    noteWake(run, c, newest);
+                } });
+        }
+
+        double cpuStart = processCpuSeconds();
+        auto wallStart = std::chrono::steady_clock::now();
+        produce(run, [&](uint64_t sequence)
+                {
+            {
+                std::lock_guard<std::mutex> first(mutexes[0]);
+                std::lock_guard<std::mutex> second(mutexes[1]);
+                queues[0].push(sequence);
+                queues[1].push(sequence);
+            }
+            conditions[0].notify_one();
+            conditions[1].notify_one();
+            run.wakeCalls += 2; });
+        done = true;
+        for (int c = 0; c < 2; ++c)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutexes[c]);
+            }
+            conditions[c].notify_all();
+        }
+        for (auto &consumer : consumers)
+            consumer.join();
+        run.cpuSeconds = processCpuSeconds() - cpuStart;
+        run.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        return run;
+    }
+
+    Run runSequenceSignal()
+    {
+        Run run;
+        SequenceSignal signal;
+        std::atomic<bool> done{false};
+
+        std::vector<std::thread> consumers;
+        for (int c = 0; c < 2; ++c)
+        {
+            consumers.emplace_back([&, c]()
+                                   {
+                uint64_t seen = 0;
+                while (seen < FRAMES)
+                {
+                    // Long enough that a missed wake-up shows up in the latencies
+                    uint64_t sequence = signal.waitPast(seen, std::chrono::seconds(1));
+                    if (sequence <= seen)
+                    {
+                        if (done)
+                            break;
+                        continue;
+                    }
+                    seen = sequence;
+                    noteWake(run, c, sequence);
+                } });
+        }
+
+        double cpuStart = processCpuSeconds();
+        auto wallStart = std::chrono::steady_clock::now();
+        produce(run, [&](uint64_t sequence)
+                { signal.publish(sequence); });
+        done = true;
+        signal.wakeAll();
+        for (auto &consumer : consumers)
+            consumer.join();
+        run.cpuSeconds = processCpuSeconds() - cpuStart;
+        run.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        run.wakeCalls = signal.stats().wakeCalls;
+        return run;
+    }
+
+    double percentile(std::vector<double> values, double fraction)
+    {
+        if (values.empty())
+            return 0.0;
+        size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+
+    bool report(const char *label, const Run &run)
+    {
+        const char *consumerNames[2] = {"idle", "busy"};
+        bool ok = true;
+        std::cout << label << ": " << std::fixed << std::setprecision(2) << run.cpuSeconds / run.wallSeconds
+                  << " cores of CPU, " << run.wakeCalls << " wake-up calls for " << FRAMES << " frames" << std::endl;
+        for (int c = 0; c < 2; ++c)
+        {
+            const std::vector<double> &latencies = run.latenciesUs[c];
+            double worst = latencies.empty() ? 0.0 : *std::max_element(latencies.begin(), latencies.end());
+            // Every frame reached, and no wait that only ended on its timeout
+            bool consumerOk = run.lastSeen[c] == FRAMES && worst < 100000.0;
+            std::cout << "  " << consumerNames[c] << " consumer: " << latencies.size() << " wakes, latency p50 "
+                      << std::setprecision(1) << percentile(latencies, 0.5) << " us, p99 " << percentile(latencies, 0.99)
+                      << " us, max " << worst << " us" << (consumerOk ? "" : "  <-- FAILED") << std::endl;
+            ok = consumerOk && ok;
+        }
+        std::cout.unsetf(std::ios::fixed);
+        return ok;
+    }
+}
+
+int main()
+{
+    std::cout << FRAMES << " frames at " << 1000000 / FRAME_PERIOD.count() << " Hz, busy consumer works "
+              << BUSY_WORK.count() << " us per wake" << std::endl;
+    bool passed = report("mutex + condition_variable", runMutexCondvar());
+    passed = report("SequenceSignal", runSequenceSignal()) && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
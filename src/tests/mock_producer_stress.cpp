@@ -0,0 +1,214 @@
+// Stress test for the callback acquisition path: a MockBufferProducer
+// delivering at 5 kHz into a handoff queue drained by workers that hold each
+// buffer for a while. Checks that a buffer is never refilled while a consumer
+// still holds it and that every buffer goes back to the producer.
+// The second half acquires straight into FrameRing slots and checks the same
+// for leases and a pinned consumer reading the ring.
+#include "mib_grabber/MockBufferProducer.h"
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const size_t IMAGE_SIZE = 512 * 96;
+    const size_t SOURCE_FRAMES = 32;
+    const size_t BUFFER_COUNT = 16;
+    const int WORKER_COUNT = 3;
+    const auto TEST_DURATION = std::chrono::seconds(3);
+
+    bool bufferIsUniform(const uint8_t *data, uint8_t expected)
+    {
+        for (size_t i = 0; i < IMAGE_SIZE; ++i)
+        {
+            if (data[i] != expected)
+                return false;
+        }
+        return true;
+    }
+}
+
+bool runHandoff(const CircularBuffer &source)
+{
+    MockBufferProducer producer(source, IMAGE_SIZE, BUFFER_COUNT, 5000.0);
+    std::deque<AcquiredBuffer> handoff;
+    std::mutex handoffMutex;
+    std::condition_variable handoffCondition;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> processed{0};
+    std::atomic<uint64_t> overwritten{0};
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < WORKER_COUNT; ++w)
+    {
+        workers.emplace_back([&, w]()
+                             {
+            std::mt19937 rng(w);
+            while (true)
+            {
+                AcquiredBuffer buffer;
+                {
+                    std::unique_lock<std::mutex> lock(handoffMutex);
+                    handoffCondition.wait(lock, [&]()
+                                          { return !handoff.empty() || done; });
+                    if (handoff.empty())
+                        break;
+                    buffer = std::move(handoff.front());
+                    handoff.pop_front();
+                }
+                uint8_t value = buffer.data()[0];
+                // Hold the buffer across several frame periods
+                std::this_thread::sleep_for(std::chrono::microseconds(200 + rng() % 800));
+                if (!bufferIsUniform(buffer.data(), value) || buffer.meta().sizeFilled != IMAGE_SIZE)
+                    ++overwritten;
+                ++processed;
+            } });
+    }
+
+    producer.start([&](AcquiredBuffer &&buffer)
+                   {
+        {
+            std::lock_guard<std::mutex> lock(handoffMutex);
+            handoff.push_back(std::move(buffer));
+        }
+        handoffCondition.notify_one(); });
+
+    std::this_thread::sleep_for(TEST_DURATION);
+    producer.stop();
+    {
+        std::lock_guard<std::mutex> lock(handoffMutex);
+        done = true;
+    }
+    handoffCondition.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+    handoff.clear();
+
+    std::cout << "Frames delivered: " << producer.delivered() << std::endl;
+    std::cout << "Frames processed: " << processed << std::endl;
+    std::cout << "Frames lost with no buffer queued: " << producer.starved() << std::endl;
+    std::cout << "Buffers still outstanding: " << producer.outstanding() << std::endl;
+    std::cout << "Buffers overwritten while held: " << overwritten << std::endl;
+
+    return overwritten == 0 && producer.outstanding() == 0 && processed != 0;
+}
+
+bool runRingAcquisition(const CircularBuffer &source)
+{
+    const size_t RING_SIZE = 64;
+    const size_t QUEUE_DEPTH = 8;
+    MockBufferProducer producer(source, IMAGE_SIZE, BUFFER_COUNT, 5000.0);
+    FrameRing ring(RING_SIZE, IMAGE_SIZE);
+    size_t pinnedConsumer = ring.registerConsumer("recorder", ConsumerMode::Pinned);
+
+    std::vector<AcquiredBuffer> held(RING_SIZE);
+    std::mutex heldMutex;
+    ring.attachAcquisition(QUEUE_DEPTH, [&](size_t slot)
+                           {
+        AcquiredBuffer buffer;
+        {
+            std::lock_guard<std::mutex> lock(heldMutex);
+            if (!held[slot])
+            {
+                producer.queueExternal(slot);
+                return;
+            }
+            buffer = std::move(held[slot]);
+        }
+        buffer.release(); });
+    uint8_t *base = ring.slotData(0);
+    producer.announceExternal(base, ring.storage().stride(), RING_SIZE, QUEUE_DEPTH);
+    // queue_depth applies from the first frame, not after a lap of the ring
+    bool queuedAtStart = ring.queuedSlots() == QUEUE_DEPTH;
+
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> leased{0};
+    std::atomic<uint64_t> overwritten{0};
+    std::vector<std::thread> readers;
+    for (int w = 0; w < WORKER_COUNT; ++w)
+    {
+        readers.emplace_back([&, w]()
+                             {
+            std::mt19937 rng(w);
+            while (!done)
+            {
+                FrameLease lease = ring.lease(rng() % RING_SIZE);
+                if (!lease)
+                    continue;
+                uint8_t value = lease.data()[0];
+                std::this_thread::sleep_for(std::chrono::microseconds(200 + rng() % 800));
+                if (!bufferIsUniform(lease.data(), value))
+                    ++overwritten;
+                ++leased;
+            } });
+    }
+    // A slow pinned reader holds back requeueing; frames stay intact meanwhile
+    readers.emplace_back([&]()
+                         {
+        while (!done)
+        {
+            FrameLease lease = ring.next(pinnedConsumer);
+            if (!lease)
+                continue;
+            uint8_t value = lease.data()[0];
+            std::this_thread::sleep_for(std::chrono::microseconds(150));
+            if (!bufferIsUniform(lease.data(), value) || lease.meta().sizeFilled != IMAGE_SIZE)
+                ++overwritten;
+        } });
+
+    producer.start([&](AcquiredBuffer &&buffer)
+                   {
+        size_t slot = static_cast<size_t>(buffer.data() - base) / ring.storage().stride();
+        FrameMeta meta = buffer.meta();
+        {
+            std::lock_guard<std::mutex> lock(heldMutex);
+            held[slot] = std::move(buffer);
+        }
+        ring.commit(slot, meta); });
+
+    std::this_thread::sleep_for(TEST_DURATION);
+    producer.stop();
+    done = true;
+    for (auto &reader : readers)
+        reader.join();
+
+    ConsumerStats pinned = ring.consumerStats(pinnedConsumer);
+    std::cout << "Ring frames committed: " << ring.latestSequence() << std::endl;
+    std::cout << "Ring frames leased: " << leased << std::endl;
+    std::cout << "Pinned consumer lag: " << pinned.lag << ", skipped: " << pinned.skipped << std::endl;
+    std::cout << "Requeue stalls on held frames: " << ring.requeueStalls() << std::endl;
+    std::cout << "Frames lost with no slot queued: " << producer.starved() << std::endl;
+    std::cout << "Slots overwritten while held: " << overwritten << std::endl;
+    std::cout << "Slots queued at the end: " << ring.queuedSlots() << " / " << QUEUE_DEPTH << std::endl;
+
+    // Every slot is either queued to the producer or held for a published frame
+    size_t heldCount = 0;
+    for (auto &buffer : held)
+        heldCount += buffer ? 1 : 0;
+    bool consistent = producer.outstanding() == heldCount && heldCount + ring.queuedSlots() == RING_SIZE;
+    held.clear();
+    return overwritten == 0 && pinned.skipped == 0 && leased != 0 && consistent && queuedAtStart;
+}
+
+int main()
+{
+    CircularBuffer source(SOURCE_FRAMES, IMAGE_SIZE);
+    std::vector<uint8_t> frame(IMAGE_SIZE);
+    for (size_t i = 0; i < SOURCE_FRAMES; ++i)
+    {
+        std::memset(frame.data(), static_cast<int>(i), IMAGE_SIZE);
+        source.push(frame.data());
+    }
+
+    bool passed = runHandoff(source);
+    passed = runRingAcquisition(source) && passed;
+    if (!passed)
+    {
+        std::cout << "FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
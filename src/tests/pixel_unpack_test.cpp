@@ -0,0 +1,237 @@
+// Checks every PixelUnpacker fast path against a plain per-pixel reference:
+// whole frames and ROI windows, with the default shift to 8 bits and with a
+// black/white remap. Then times the fast paths, the reference loop and, when a
+// GenTL producer is installed, FormatConverter on the same frames.
+#include "mib_grabber/PixelUnpack.h"
+#include <EGrabber.h>
+#include <FormatConverter.h>
+#include <PFNC.h>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const size_t WIDTH = 1920;
+    const size_t HEIGHT = 1080;
+    const int BENCH_FRAMES = 50;
+
+    struct TestFormat
+    {
+        uint64_t value;
+        size_t bits;
+    };
+
+    const TestFormat FORMATS[] = {
+        {PFNC_Mono8, 8}, {PFNC_Mono10, 10}, {PFNC_Mono12, 12}, {PFNC_Mono14, 14}, {PFNC_Mono16, 16},
+        {PFNC_Mono10p, 10}, {PFNC_Mono12p, 12}, {PFNC_Mono14p, 14},
+        {GVSP_Mono10Packed, 10}, {GVSP_Mono12Packed, 12},
+    };
+
+    bool isPfncPacked(uint64_t format)
+    {
+        return format == PFNC_Mono10p || format == PFNC_Mono12p || format == PFNC_Mono14p;
+    }
+
+    bool isGvspPacked(uint64_t format)
+    {
+        return format == GVSP_Mono10Packed || format == GVSP_Mono12Packed;
+    }
+
+    // Packs pixel values the way the camera would send them
+    std::vector<uint8_t> pack(const std::vector<uint16_t> &pixels, const TestFormat &format)
+    {
+        std::vector<uint8_t> raw;
+        if (format.bits == 8)
+        {
+            for (uint16_t p : pixels)
+                raw.push_back(static_cast<uint8_t>(p));
+        }
+        else if (isPfncPacked(format.value))
+        {
+            raw.assign((pixels.size() * format.bits + 7) / 8, 0);
+            size_t bit = 0;
+            for (uint16_t p : pixels)
+                for (size_t b = 0; b < format.bits; ++b, ++bit)
+                    if (p >> b & 1)
+                        raw[bit / 8] |= static_cast<uint8_t>(1 << (bit % 8));
+        }
+        else if (isGvspPacked(format.value))
+        {
+            size_t lowBits = format.bits - 8;
+            for (size_t i = 0; i < pixels.size(); i += 2)
+            {
+                raw.push_back(static_cast<uint8_t>(pixels[i] >> lowBits));
+                raw.push_back(static_cast<uint8_t>((pixels[i] & ((1 << lowBits) - 1)) |
+                                                   ((pixels[i + 1] & ((1 << lowBits) - 1)) << 4)));
+                raw.push_back(static_cast<uint8_t>(pixels[i + 1] >> lowBits));
+            }
+        }
+        else
+        {
+            for (uint16_t p : pixels)
+            {
+                raw.push_back(static_cast<uint8_t>(p & 0xFF));
+                raw.push_back(static_cast<uint8_t>(p >> 8));
+            }
+        }
+        return raw;
+    }
+
+    // What the 8-bit pixel should be, worked out in floating point
+    int reference(uint16_t value, size_t bits, PixelNormalization normalization)
+    {
+        int maxValue = (1 << bits) - 1;
+        int white = normalization.white ? std::min<int>(normalization.white, maxValue) : maxValue;
+        if (normalization.black == 0 && normalization.white == 0)
+            return value >> (bits - 8);
+        double level = (static_cast<double>(value) - normalization.black) / (white - normalization.black);
+        return static_cast<int>(std::floor(std::clamp(level, 0.0, 1.0) * 255.0));
+    }
+
+    // Largest difference from the reference inside the window, and whether
+    // anything outside it was written
+    bool check(const TestFormat &format, PixelNormalization normalization,
+               size_t x, size_t y, size_t cols, size_t rows, const char *label)
+    {
+        std::mt19937 random(static_cast<unsigned>(format.value));
+        std::uniform_int_distribution<int> level(0, (1 << format.bits) - 1);
+        std::vector<uint16_t> pixels(WIDTH * HEIGHT);
+        for (uint16_t &p : pixels)
+            p = static_cast<uint16_t>(level(random));
+        std::vector<uint8_t> raw = pack(pixels, format);
+
+        PixelUnpacker unpacker(format.value, WIDTH, HEIGHT, normalization);
+        if (unpacker.rawSize() != raw.size())
+        {
+            std::cout << PixelUnpacker::formatName(format.value) << " " << label << ": raw size "
+                      << unpacker.rawSize() << ", expected " << raw.size() << std::endl;
+            return false;
+        }
+
+        const uint8_t untouched = 0xA5;
+        std::vector<uint8_t> out(WIDTH * HEIGHT, untouched);
+        unpacker.unpackRegion(raw.data(), out.data(), WIDTH, x, y, cols, rows);
+
+        int worst = 0;
+        size_t strayWrites = 0;
+        for (size_t row = 0; row < HEIGHT; ++row)
+            for (size_t col = 0; col < WIDTH; ++col)
+            {
+                size_t i = row * WIDTH + col;
+                bool inside = col >= x && col < x + cols && row >= y && row < y + rows;
+                // Windows widen to whole packing groups, allow a group either side
+                bool nearEdge = col + 4 >= x && col < x + cols + 4 && row >= y && row < y + rows;
+                if (inside)
+                    worst = std::max(worst, std::abs(out[i] - reference(pixels[i], format.bits, normalization)));
+                else if (!nearEdge && out[i] != untouched)
+                    ++strayWrites;
+            }
+
+        // The fixed-point scale may round one level away from the exact ratio
+        bool exact = normalization.black == 0 && normalization.white == 0;
+        bool ok = worst <= (exact ? 0 : 1) && strayWrites == 0;
+        std::cout << std::left << std::setw(14) << PixelUnpacker::formatName(format.value) << std::setw(12) << label
+                  << " max error " << worst << ", stray writes " << strayWrites << (ok ? "" : "  <-- FAILED") << std::endl;
+        return ok;
+    }
+
+    double secondsPerFrame(const std::function<void()> &convert)
+    {
+        convert();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < BENCH_FRAMES; ++i)
+            convert();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / BENCH_FRAMES;
+    }
+
+    void printRate(const char *what, double seconds, size_t rawBytes)
+    {
+        std::cout << "  " << std::left << std::setw(18) << what << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(8) << seconds * 1000.0 << " ms/frame  " << std::setprecision(0) << std::setw(6)
+                  << rawBytes / seconds / 1e6 << " MB/s" << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    }
+
+    void benchmark(const TestFormat &format, Euresys::FormatConverter *converter)
+    {
+        std::vector<uint16_t> pixels(WIDTH * HEIGHT);
+        std::mt19937 random(1);
+        for (uint16_t &p : pixels)
+            p = static_cast<uint16_t>(random() & ((1u << format.bits) - 1));
+        std::vector<uint8_t> raw = pack(pixels, format);
+        std::vector<uint8_t> out(WIDTH * HEIGHT);
+        PixelUnpacker unpacker(format.value, WIDTH, HEIGHT);
+        PixelUnpacker levels(format.value, WIDTH, HEIGHT, {static_cast<uint16_t>(1 << (format.bits - 5)), 0});
+
+        std::cout << PixelUnpacker::formatName(format.value) << std::endl;
+        printRate("fast path", secondsPerFrame([&]
+                                               { unpacker.unpack(raw.data(), out.data(), WIDTH); }),
+                  raw.size());
+        printRate("fast path, levels", secondsPerFrame([&]
+                                                       { levels.unpack(raw.data(), out.data(), WIDTH); }),
+                  raw.size());
+        // Unpacked values are already at hand, so this only times the remap a
+        // naive per-pixel loop would do after decoding
+        printRate("per-pixel loop", secondsPerFrame([&]
+                                                    {
+                                                        for (size_t i = 0; i < pixels.size(); ++i)
+                                                            out[i] = static_cast<uint8_t>(reference(pixels[i], format.bits, {}));
+                                                    }),
+                  raw.size());
+        if (converter)
+        {
+            try
+            {
+                printRate("FormatConverter", secondsPerFrame([&]
+                                                             {
+                                                                 Euresys::FormatConverter::Auto mono8(*converter, Euresys::FormatConverter::OutputFormat("Mono8"),
+                                                                                                      raw.data(), format.value, WIDTH, HEIGHT, raw.size());
+                                                                 std::copy(mono8.getBuffer(), mono8.getBuffer() + out.size(), out.begin());
+                                                             }),
+                          raw.size());
+            }
+            catch (const std::exception &e)
+            {
+                std::cout << "  FormatConverter: " << e.what() << std::endl;
+            }
+        }
+    }
+}
+
+int main()
+{
+    bool passed = true;
+    for (const TestFormat &format : FORMATS)
+    {
+        passed = check(format, {}, 0, 0, WIDTH, HEIGHT, "frame") && passed;
+        passed = check(format, {}, 509, 93, 701, 41, "window") && passed;
+        // Levels inside the 8-bit range too, so Mono8 takes the remap path
+        PixelNormalization levels{static_cast<uint16_t>(3 << (format.bits - 8)), static_cast<uint16_t>(200 << (format.bits - 8))};
+        passed = check(format, levels, 0, 0, WIDTH, HEIGHT, "levels") && passed;
+        passed = check(format, levels, 1001, 500, 37, 300, "levels+win") && passed;
+    }
+
+    std::unique_ptr<Euresys::EGenTL> genTL;
+    std::unique_ptr<Euresys::FormatConverter> converter;
+    try
+    {
+        genTL = std::make_unique<Euresys::EGenTL>();
+        converter = std::make_unique<Euresys::FormatConverter>(*genTL);
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << "No GenTL producer, skipping FormatConverter timings (" << e.what() << ")" << std::endl;
+    }
+
+    std::cout << WIDTH << "x" << HEIGHT << ", " << BENCH_FRAMES << " frames each" << std::endl;
+    for (const TestFormat &format : FORMATS)
+        benchmark(format, converter.get());
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
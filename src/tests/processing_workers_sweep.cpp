@@ -0,0 +1,145 @@
+// Sweeps the number of processing workers from 1 to 16 over the same
+// synthetic frames: each worker has its own Mats and pulls the next frame
+// from a shared counter, and verdicts go through the ReorderBuffer as in the
+// pipeline. Checks that verdicts come out in frame order, once each, and
+// that every worker count finds the same cells; prints the frame rate and
+// the speedup over one worker.
+#include "image_processing/image_processing.h"
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const int WIDTH = 512;
+    const int HEIGHT = 96;
+    const size_t DISTINCT_FRAMES = 64;
+    const uint64_t FRAMES = 20000;
+    const size_t WORKER_COUNTS[] = {1, 2, 3, 4, 6, 8, 12, 16};
+
+    // A bright, noisy channel with a darker cell moving along it; some
+    // frames have no cell and some have it against the ROI edge
+    std::vector<cv::Mat> makeFrames(cv::Mat &background)
+    {
+        std::mt19937 random(3);
+        std::normal_distribution<double> noise(0.0, 2.0);
+        background = cv::Mat(HEIGHT, WIDTH, CV_8UC1);
+        for (int y = 0; y < HEIGHT; ++y)
+            for (int x = 0; x < WIDTH; ++x)
+                background.at<uint8_t>(y, x) = static_cast<uint8_t>(200 + noise(random));
+
+        std::vector<cv::Mat> frames;
+        for (size_t i = 0; i < DISTINCT_FRAMES; ++i)
+        {
+            cv::Mat frame = background.clone();
+            for (int y = 0; y < HEIGHT; ++y)
+                for (int x = 0; x < WIDTH; ++x)
+                    frame.at<uint8_t>(y, x) = cv::saturate_cast<uint8_t>(frame.at<uint8_t>(y, x) + noise(random));
+            if (i % 4 != 3)
+            {
+                int x = 8 + static_cast<int>(i * 8) % (WIDTH - 16);
+                cv::ellipse(frame, cv::Point(x, HEIGHT / 2), cv::Size(9 + static_cast<int>(i % 5), 7), 0, 0, 360,
+                            cv::Scalar(120), cv::FILLED);
+            }
+            frames.push_back(frame);
+        }
+        return frames;
+    }
+
+    struct SweepResult
+    {
+        double framesPerSecond = 0.0;
+        uint64_t emitted = 0;
+        uint64_t outOfOrder = 0;
+        uint64_t valid = 0;
+        size_t maxHeld = 0;
+    };
+
+    SweepResult run(SharedResources &shared, const std::vector<cv::Mat> &frames, size_t workerCount)
+    {
+        SweepResult result;
+        uint64_t expected = 0;
+        ReorderBuffer<FrameVerdict> order(reorderWindow(workerCount), [&](FrameVerdict &verdict)
+                                          {
+            if (verdict.meta.frameId != expected)
+                ++result.outOfOrder;
+            expected = verdict.meta.frameId + 1;
+            ++result.emitted;
+            if (verdict.valid)
+                ++result.valid; });
+
+        std::mutex queueMutex;
+        uint64_t nextFrame = 0;
+        auto startTime = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (size_t w = 0; w < workerCount; ++w)
+        {
+            workers.emplace_back([&]()
+                                 {
+                cv::Mat processedImage(HEIGHT, WIDTH, CV_8UC1);
+                ThreadLocalMats mats = initializeThreadMats(HEIGHT, WIDTH, shared);
+                while (true)
+                {
+                    uint64_t frame;
+                    {
+                        std::lock_guard<std::mutex> lock(queueMutex);
+                        if (nextFrame == FRAMES)
+                            break;
+                        frame = nextFrame++;
+                    }
+                    FrameMeta meta;
+                    meta.frameId = frame;
+                    meta.hostSteadyUs = steadyNowUs();
+                    // The frame number is the ticket, as the queue hands them out in order
+                    order.complete(frame, measureFrame(frames[frame % frames.size()], meta, shared, processedImage, mats));
+                } });
+        }
+        for (auto &worker : workers)
+            worker.join();
+        result.framesPerSecond = FRAMES / std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        result.maxHeld = order.maxHeld();
+        return result;
+    }
+}
+
+int main()
+{
+    cv::setNumThreads(1); // the workers are the only parallelism
+    SharedResources shared;
+    shared.headless = true;
+    std::vector<cv::Mat> frames = makeFrames(shared.backgroundFrame);
+    cv::GaussianBlur(shared.backgroundFrame, shared.blurredBackground, cv::Size(3, 3), 0);
+    shared.roi = cv::Rect(4, 4, WIDTH - 8, HEIGHT - 8);
+
+    std::cout << FRAMES << " frames of " << WIDTH << "x" << HEIGHT << ", " << std::thread::hardware_concurrency()
+              << " hardware threads" << std::endl;
+    std::cout << std::setw(8) << "Workers" << std::setw(12) << "Frames/s" << std::setw(10) << "Speedup"
+              << std::setw(12) << "Efficiency" << std::setw(10) << "Max held" << std::endl;
+
+    bool passed = true;
+    double baseline = 0.0;
+    uint64_t baselineValid = 0;
+    for (size_t workerCount : WORKER_COUNTS)
+    {
+        SweepResult result = run(shared, frames, workerCount);
+        if (workerCount == 1)
+        {
+            baseline = result.framesPerSecond;
+            baselineValid = result.valid;
+        }
+        double speedup = result.framesPerSecond / baseline;
+        size_t cores = std::max<size_t>(std::min<size_t>(workerCount, std::thread::hardware_concurrency()), 1);
+        bool ok = result.emitted == FRAMES && result.outOfOrder == 0 && result.valid == baselineValid && result.valid > 0;
+        std::cout << std::setw(8) << workerCount << std::fixed << std::setprecision(0) << std::setw(12)
+                  << result.framesPerSecond << std::setprecision(2) << std::setw(10) << speedup << std::setw(11)
+                  << 100.0 * speedup / cores << "%" << std::setw(10) << result.maxHeld
+                  << (ok ? "" : "  <-- FAILED") << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        passed = ok && passed;
+    }
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
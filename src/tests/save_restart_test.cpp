@@ -0,0 +1,87 @@
+// Saves two batches, restarts the way a camera window change does (a fresh
+// SharedResources that only keeps saveDirName) and saves again. Checks the
+// restart reuses the run's directory, numbers its batches after the earlier
+// ones and leaves the earlier batches' files as they were; a run without a
+// directory name still gets a new, suffixed directory.
+#include "image_processing/image_processing.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    bool check(bool ok, const std::string &what)
+    {
+        std::cout << (ok ? "  ok: " : "  FAILED: ") << what << std::endl;
+        return ok;
+    }
+
+    std::string readFile(const std::filesystem::path &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    void saveBatch(SharedResources &shared, const std::filesystem::path &directory, uint64_t frameId)
+    {
+        QualifiedResult result{};
+        result.frameId = frameId;
+        result.originalImage = cv::Mat(8, 8, CV_8UC1, cv::Scalar(static_cast<double>(frameId % 256)));
+        saveQualifiedResultsToDisk({result}, directory.string(), shared);
+        shared.currentBatchNumber++;
+    }
+}
+
+int main()
+{
+    bool passed = true;
+    std::filesystem::path outputDir = std::filesystem::temp_directory_path() / "mib_save_restart_test";
+    std::filesystem::remove_all(outputDir);
+
+    std::string saveDirName;
+    std::filesystem::path firstDir;
+    std::string firstBatch0, firstBatch1;
+    {
+        SharedResources shared;
+        shared.backgroundFrame = cv::Mat::zeros(8, 8, CV_8UC1);
+        firstDir = openSaveDirectory(shared, outputDir, "results");
+        saveBatch(shared, firstDir, 100);
+        saveBatch(shared, firstDir, 101);
+        firstBatch0 = readFile(firstDir / "batch_0" / "batch_data.csv");
+        firstBatch1 = readFile(firstDir / "batch_1" / "images.bin");
+        saveDirName = shared.saveDirName;
+    }
+
+    {
+        SharedResources shared;
+        shared.backgroundFrame = cv::Mat::zeros(8, 8, CV_8UC1);
+        shared.saveDirName = saveDirName;
+        std::filesystem::path restartDir = openSaveDirectory(shared, outputDir, "results");
+        passed = check(restartDir == firstDir, "restart reuses " + firstDir.string()) && passed;
+        passed = check(shared.currentBatchNumber == 2, "restart numbers from batch_" +
+                                                           std::to_string(shared.currentBatchNumber.load())) &&
+                 passed;
+        saveBatch(shared, restartDir, 200);
+    }
+    passed = check(readFile(firstDir / "batch_0" / "batch_data.csv") == firstBatch0 &&
+                       readFile(firstDir / "batch_1" / "images.bin") == firstBatch1,
+                   "earlier batches unchanged") &&
+             passed;
+    passed = check(readFile(firstDir / "batch_2" / "batch_data.csv").find(",200,") != std::string::npos,
+                   "restart batch saved as batch_2") &&
+             passed;
+
+    {
+        SharedResources shared;
+        std::filesystem::path newDir = openSaveDirectory(shared, outputDir, "results");
+        passed = check(newDir != firstDir && shared.currentBatchNumber == 0,
+                       "a new run gets " + newDir.filename().string() + " from batch_0") &&
+                 passed;
+    }
+
+    std::filesystem::remove_all(outputDir);
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
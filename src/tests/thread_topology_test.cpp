@@ -0,0 +1,131 @@
+// Applies thread placements on this machine and checks what the OS reports
+// back: each core on its own, processing workers spread one per core, a
+// scoped placement restoring the old affinity, and frame storage bound to
+// the node of the acquisition core. A SCHED_FIFO request is tried too; it
+// needs CAP_SYS_NICE or an rtprio limit, so a refusal is reported, not failed.
+// Real-time roles with more threads than cores are reported.
+#include "mib_grabber/ThreadTopology.h"
+#include "CircularBuffer/FrameStorage.h"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    bool check(bool ok, const std::string &what)
+    {
+        std::cout << (ok ? "  ok: " : "  FAILED: ") << what << std::endl;
+        return ok;
+    }
+
+    // Cores this process may run on, read from a thread with no placement
+    std::vector<int> allowedCores()
+    {
+        std::vector<int> cores;
+        std::thread([&]()
+                    { cores = applyThreadPlacement(ThreadPlacement()).cores; })
+            .join();
+        return cores;
+    }
+}
+
+int main()
+{
+    bool passed = true;
+    std::vector<int> cores = allowedCores();
+    std::cout << "Allowed cores: " << describeCores(cores) << std::endl;
+
+    passed = check(describeCores({6, 0, 1, 2, 3, 3}) == "0-3,6", "core list described as 0-3,6") && passed;
+
+    for (int core : cores)
+    {
+        AppliedPlacement applied;
+        std::thread([&]()
+                    {
+            ThreadPlacement placement;
+            placement.cores = {core};
+            applied = applyThreadPlacement(placement); })
+            .join();
+        passed = check(applied.matches && applied.currentCore == core,
+                       "pinned to core " + std::to_string(core) + ", running on " + std::to_string(applied.currentCore)) &&
+                 passed;
+    }
+
+    // Workers beyond the listed cores wrap around
+    ThreadTopology topology;
+    topology.processing.cores = {cores.front(), cores.back()};
+    std::vector<int> workerCores(4, -1);
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < workerCores.size(); ++w)
+        workers.push_back(placedThread(topology, ThreadRole::Processing, w, [&workerCores, w]()
+                                       { workerCores[w] = applyThreadPlacement(ThreadPlacement()).cores.front(); }));
+    for (auto &worker : workers)
+        worker.join();
+    passed = check(workerCores[0] == cores.front() && workerCores[1] == cores.back() &&
+                       workerCores[2] == cores.front() && workerCores[3] == cores.back(),
+                   "processing workers spread over " + describeCores(topology.processing.cores)) &&
+             passed;
+
+    std::vector<int> restored;
+    std::thread([&]()
+                {
+        ThreadTopology acquisition;
+        acquisition.acquisition.cores = {cores.front()};
+        {
+            ScopedThreadPlacement placement(acquisition, ThreadRole::Acquisition);
+        }
+        restored = applyThreadPlacement(ThreadPlacement()).cores; })
+        .join();
+    passed = check(restored == cores, "scoped placement restored cores " + describeCores(restored)) && passed;
+
+    AppliedPlacement realtime;
+    std::thread([&]()
+                {
+        ThreadPlacement placement;
+        placement.priority = 10;
+        realtime = applyThreadPlacement(placement); })
+        .join();
+    std::cout << "  SCHED_FIFO 10: " << (realtime.matches ? "granted" : "refused: " + realtime.error) << std::endl;
+
+    ThreadTopology crowded;
+    crowded.acquisition = {{cores.front()}, 80};
+    crowded.processing.cores = {cores.front(), 100000};
+    std::vector<std::string> warnings = checkThreadTopology(crowded, static_cast<unsigned>(cores.back() + 1));
+    passed = check(warnings.size() == 2, "missing core and shared real-time core reported (" +
+                                             std::to_string(warnings.size()) + " warnings)") &&
+             passed;
+
+    // Both trigger loops spin, so they take different cores
+    ThreadTopology trigger;
+    trigger.trigger = {{cores.front(), cores.back()}, 80};
+    passed = check(trigger.placementFor(ThreadRole::Trigger, 1).cores == std::vector<int>{cores.back()},
+                   "second trigger thread on core " + std::to_string(cores.back())) &&
+             passed;
+    trigger.trigger.cores = {cores.front()};
+    warnings = checkThreadTopology(trigger, static_cast<unsigned>(cores.back() + 1));
+    passed = check(warnings.size() == 2, "two real-time trigger threads on one core reported (" +
+                                             std::to_string(warnings.size()) + " warnings)") &&
+             passed;
+
+    int node = numaNodeOfCore(cores.front());
+    std::cout << "Core " << cores.front() << " is on NUMA node " << node << std::endl;
+    if (node >= 0)
+    {
+        FrameStorageOptions options;
+        options.numaNode = node;
+        FrameStorage storage(64, 1 << 20, options);
+        storage.waitForPrefault();
+        passed = check(storage.residentNode() == node, "frame storage on node " + std::to_string(storage.residentNode())) && passed;
+
+        // Without prefault the node is checked on the first slot written
+        options.prefaultInBackground = false;
+        FrameStorage lazy(64, 1 << 20, options);
+        lazy.slot(0)[0] = 1;
+        lazy.noteFirstWrite(lazy.slot(0));
+        passed = check(lazy.residentNode() == node, "unprefaulted storage on node " + std::to_string(lazy.residentNode())) && passed;
+    }
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// Drives the processing work-item protocol at ring level: a writer pushes
+// frames and queues one work item per published sequence, a consumer slower
+// than the writer takes them with FrameRing::take under both processing
+// policies. every_frame must analyse every published frame once, in order,
+// with the writer dropping frames instead; latest_only must account for every
+// published frame as analysed or skipped. Each frame carries its sequence, so
+// analysing the wrong slot is caught too.
+#include "CircularBuffer/FrameRing.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const size_t RING_SIZE = 32;
+    const size_t IMAGE_SIZE = 512 * 96;
+    const uint64_t FRAMES = 20000;
+
+    struct Counts
+    {
+        uint64_t published = 0;
+        uint64_t writerDrops = 0;
+        uint64_t analysed = 0;
+        uint64_t skipped = 0;
+        uint64_t missing = 0; // work item named a frame the ring no longer held
+        uint64_t wrongFrame = 0;
+        uint64_t outOfOrder = 0;
+    };
+
+    Counts run(bool everyFrame)
+    {
+        FrameRing ring(RING_SIZE, IMAGE_SIZE);
+        size_t consumer = ring.registerConsumer("processing", everyFrame ? ConsumerMode::Pinned : ConsumerMode::Lossy);
+        std::queue<uint64_t> work;
+        std::mutex workMutex;
+        std::condition_variable workCondition;
+        bool writerDone = false;
+        Counts counts;
+
+        std::thread writer([&]()
+                           {
+            std::vector<uint8_t> frame(IMAGE_SIZE);
+            for (uint64_t i = 0; i < FRAMES; ++i)
+            {
+                uint64_t next = ring.latestSequence() + 1;
+                std::memcpy(frame.data(), &next, sizeof(next));
+                if (!ring.push(frame.data()))
+                {
+                    ++counts.writerDrops;
+                    std::this_thread::sleep_for(std::chrono::microseconds(5));
+                    continue;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(workMutex);
+                    work.push(ring.latestSequence());
+                    ++counts.published;
+                }
+                workCondition.notify_one();
+            }
+            {
+                std::lock_guard<std::mutex> lock(workMutex);
+                writerDone = true;
+            }
+            workCondition.notify_one(); });
+
+        uint64_t last = 0;
+        while (true)
+        {
+            uint64_t sequence;
+            {
+                std::unique_lock<std::mutex> lock(workMutex);
+                workCondition.wait(lock, [&]()
+                                   { return !work.empty() || writerDone; });
+                if (work.empty())
+                    break;
+                sequence = work.front();
+                work.pop();
+                if (!everyFrame)
+                {
+                    while (!work.empty())
+                    {
+                        sequence = work.front();
+                        work.pop();
+                        ++counts.skipped;
+                    }
+                }
+            }
+
+            FrameLease lease = ring.take(consumer, sequence);
+            if (!lease)
+            {
+                ++counts.missing;
+                continue;
+            }
+            uint64_t stamped;
+            std::memcpy(&stamped, lease.data(), sizeof(stamped));
+            if (stamped != sequence || lease.sequence() != sequence)
+                ++counts.wrongFrame;
+            if (sequence <= last || (everyFrame && sequence != last + 1))
+                ++counts.outOfOrder;
+            last = sequence;
+            ++counts.analysed;
+            // Slower than the writer, so the policies matter
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+        writer.join();
+        return counts;
+    }
+
+    bool report(const char *policy, const Counts &counts, bool everyFrame)
+    {
+        bool accounted = counts.analysed + counts.skipped + counts.missing == counts.published;
+        bool ok = accounted && counts.wrongFrame == 0 && counts.outOfOrder == 0 &&
+                  (!everyFrame || (counts.skipped == 0 && counts.missing == 0));
+        std::cout << policy << ": " << counts.published << " published, " << counts.analysed << " analysed, "
+                  << counts.skipped << " skipped, " << counts.missing << " missing, " << counts.writerDrops
+                  << " dropped by the writer, " << counts.wrongFrame << " wrong frames, " << counts.outOfOrder
+                  << " out of order" << (ok ? "" : "  <-- FAILED") << std::endl;
+        return ok;
+    }
+}
+
+int main()
+{
+    bool passed = report("every_frame", run(true), true);
+    passed = report("latest_only", run(false), false) && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}